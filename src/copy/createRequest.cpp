@@ -5,6 +5,9 @@
 
 #include <string>
 #include <sstream>
+#include <cstring>
+#include <list>
+#include <map>
 
 #include <epicsMutex.h>
 
@@ -15,10 +18,6 @@
 #include <pv/createRequest.h>
 
 using namespace epics::pvData;
-using std::ostringstream;
-using std::tr1::static_pointer_cast;
-using std::cout;
-using std::endl;
 using std::string;
 using std::vector;
 
@@ -27,453 +26,300 @@ namespace epics { namespace pvData {
 static PVDataCreatePtr pvDataCreate = getPVDataCreate();
 static FieldCreatePtr fieldCreate = getFieldCreate();
 
-class CreateRequestImpl : public CreateRequest {
-private:
-
-    struct Node 
+namespace {
+
+/* Recursive descent parser for
+ *
+ *   request := section* | list
+ *   section := 'record' '[' options? ']' | ('field' | 'getField' | 'putField') '(' list? ')'
+ *   list    := item (',' item)*
+ *   item    := name ('[' options ']')? ('.' item | '{' list '}')?
+ *   options := key '=' value (',' key '=' value)*
+ *
+ * Blanks are ignored everywhere.  Sections may be separated by ','.
+ * The Structure is built while parsing.  Option values are collected,
+ * to be set once the PVStructure exists.
+ */
+struct RequestParser {
+    const char *begin, *pos, *end;
+    string path; // eg. "field.a.b" while parsing the item 'b' of field(a.b)
+    vector<std::pair<string, string> > options;
+
+    explicit RequestParser(const string& request)
+        :begin(request.c_str())
+        ,pos(begin)
+        ,end(begin+request.size())
+    {}
+
+    static bool blank(char c)
     {
-        string name;
-        vector<Node> nodes;
-        Node(string name)
-        : name(name)
-        {}
-    };
+        return c==' ' || c=='\t' || c=='\n' || c=='\r';
+    }
 
-    struct OptionPair
+    // next non-blank character, or nil at the end
+    char peek()
     {
-         string name;
-         string value;
-         OptionPair(string name,string value)
-         : name(name),
-           value(value)
-         {}
-    };
-
-
-    vector<OptionPair> optionList;
-    string fullFieldName;
-
+        while(pos!=end && blank(*pos))
+            pos++;
+        return pos==end ? '\0' : *pos;
+    }
 
-public:
-    CreateRequestImpl()
+    bool atEnd()
     {
-        fullFieldName = "";
+        peek();
+        return pos==end;
     }
-private:
-         
 
-    void removeBlanks(string& str)
+    bool accept(char c)
     {
-        while(true) {
-            string::size_type pos = str.find_first_of(' ');
-            if(pos==string::npos) return;
-            str.erase(pos,1);
-        }
+        if(atEnd() || *pos!=c)
+            return false;
+        pos++;
+        return true;
     }
 
-    size_t findMatchingBrace(string& request, size_t index, int numOpen) {
-        size_t openBrace = request.find('{', index+1);
-        size_t closeBrace = request.find('}', index+1);
-        if(openBrace == string::npos && closeBrace == string::npos){
-             message = request + " mismatched {}";
-             throw std::logic_error("message");
-        }
-        if (openBrace != string::npos && openBrace!=0) {
-            if(openBrace<closeBrace) return findMatchingBrace(request,openBrace,numOpen+1);
-            if(numOpen==1) return closeBrace;
-            return findMatchingBrace(request,closeBrace,numOpen-1);
+    void expect(char c)
+    {
+        if(!accept(c)) {
+            string msg("expected '");
+            msg += c;
+            msg += '\'';
+            error(msg);
         }
-        if(numOpen==1) return closeBrace;
-        return findMatchingBrace(request,closeBrace,numOpen-1);
     }
 
-    size_t findMatchingBracket(string& request, size_t index) {
-        for(size_t i=index+1; i< request.size(); ++i) {
-            if(request[i] == ']') {
-                if(i==index+1) {
-                     message = request + " mismatched []";
-                     throw std::logic_error("message");
-                }
-                return i;
-            }
-        }
-        message = request + " missing ]";
-        throw std::logic_error("message");
+    void error(const string& msg)
+    {
+        std::ostringstream strm;
+        strm<<msg<<" at offset "<<(pos-begin)<<" of \""<<string(begin, end)<<"\"";
+        throw std::invalid_argument(strm.str());
     }
 
-    size_t findEndField(string& request) {
-        size_t ind = 0;
-        size_t maxind = request.size() -1;
-        while(true) {
-             if(request[ind]==',') return ind;
-             if(request[ind]=='[') {
-                 size_t closeBracket = findMatchingBracket(request,ind);
-                 if(closeBracket==string::npos) return closeBracket;
-                 ind = closeBracket;
-                 continue;
-             }
-             if(request[ind]=='{') {
-                 size_t closeBrace = findMatchingBrace(request,ind,1);
-                 if(closeBrace==string::npos) return closeBrace;
-                 if(ind>=request.size()) return request.size();
-                 ind = closeBrace;
-                 continue;
-             }
-             if(request[ind]=='.') {
-                 ++ind;
-                 continue;
-             }
-             if(ind>=maxind) break;
-             ++ind;
+    // characters up to the next delimiter, without blanks
+    string token(const char *delims)
+    {
+        string ret;
+        while(!atEnd() && !strchr(delims, *pos)) {
+            const char *start = pos;
+            while(pos!=end && !blank(*pos) && !strchr(delims, *pos))
+                pos++;
+            ret.append(start, pos);
         }
-        return request.size();
+        return ret;
     }
 
-    vector<string> split(string const & commaSeparatedList) {
-        string::size_type numValues = 1;
-        string::size_type index=0;
-        while(true) {
-            string::size_type pos = commaSeparatedList.find(',',index);
-            if(pos==string::npos) break;
-            numValues++;
-            index = pos +1;
-	}
-        vector<string> valueList(numValues,"");
-        index=0;
-        for(size_t i=0; i<numValues; i++) {
-            size_t pos = commaSeparatedList.find(',',index);
-            string value = commaSeparatedList.substr(index,pos-index);
-            valueList[i] = value;
-            index = pos +1;
-        }
-        return valueList;
+    // after '['
+    StructureConstPtr parseOptions()
+    {
+        StringArray names;
+        do {
+            string key(token("=,[](){}"));
+            if(key.empty() || !accept('='))
+                error("expected name=value");
+            options.push_back(std::make_pair(path + "._options." + key, token(",]")));
+            names.push_back(key);
+        } while(accept(','));
+        expect(']');
+        FieldConstPtrArray fields(names.size(), fieldCreate->createScalar(pvString));
+        return fieldCreate->createStructure(names, fields);
     }
 
-    Node createRequestOptions(
-        string const & request)
+    void parseItem(StringArray& names, FieldConstPtrArray& fields)
     {
-        if(request.length()<=1) {
-            throw std::logic_error("logic error empty options");
+        string name(token(",.[](){}"));
+        if(name.empty())
+            error("expected field name");
+        size_t parentLen = path.size();
+        path += '.';
+        path += name;
+
+        StringArray subNames;
+        FieldConstPtrArray subFields;
+        if(accept('[')) {
+            subNames.push_back("_options");
+            subFields.push_back(parseOptions());
         }
-        vector<Node> top;
-        vector<string> items = split(request);
-
-        size_t nitems = items.size();
-        for(size_t j=0; j<nitems; j++) {
-            string item = items[j];
-            size_t equals = item.find('=');
-            if(equals==string::npos || equals==0) {
-                message = item + " illegal option " + request;
-                throw std::logic_error("message");
-            }
-            top.push_back(Node(item.substr(0,equals)));
-            string name = fullFieldName + "._options." + item.substr(0,equals);
-            string value = item.substr(equals+1);
-            optionList.push_back(OptionPair(name,value));
+        if(accept('.')) {
+            parseItem(subNames, subFields);
+        } else if(accept('{')) {
+            parseList(subNames, subFields);
+            expect('}');
         }
-        Node node("_options");
-        node.nodes = top;
-        return node;
+
+        path.resize(parentLen);
+        names.push_back(name);
+        fields.push_back(fieldCreate->createStructure(subNames, subFields));
     }
 
+    void parseList(StringArray& names, FieldConstPtrArray& fields)
+    {
+        do {
+            parseItem(names, fields);
+        } while(accept(','));
+    }
 
-    void createSubNode(Node &node,string const & crequest)
+    StructureConstPtr parseList(const char *top)
     {
-        string request = crequest;
-        size_t end = 0;
-        for(size_t i=0; i<request.size(); ++i) {
-            if(request[i]=='[') { end = i; break;}
-            if(request[i]=='.') { end = i; break;}
-            if(request[i]=='{') { end = i; break;}
-            if(request[i]==',') { end = i; break;}
-        }
-        char chr = request[end];
-        Node optionNode("");
-        if(chr=='[') {
-            string saveFullName = fullFieldName;
-            fullFieldName += "." + request.substr(0,end);
-            size_t endBracket = findMatchingBracket(request,end);
-            string options = request.substr(end+1,endBracket -end -1);
-            optionNode = createRequestOptions(options);
-            fullFieldName = saveFullName;
-            size_t next = endBracket+1;
-            if(next<request.size()) {
-                request = request.substr(0, end) + request.substr(endBracket+1);
-            } else {
-                request = request.substr(0, end);
-            }
-            end = 0;
-            for(size_t i=0; i<request.size(); ++i) {
-                if(request[i]=='.') { end = i; break;}
-                if(request[i]=='{') { end = i; break;}
-                if(request[i]==',') { end = i; break;}
-            }
-            chr = request[end];
-        }
-        if(end==0) end = request.size();
-        string name = request.substr(0,end);
-        if(name.size()<1) {
-            throw std::logic_error("null field name " + request);
-        }
-        string saveFullName = fullFieldName;
-        fullFieldName += "." + name;
-        if(end==request.size()) {
-            Node subNode(name);
-            if(optionNode.name.size()>0) subNode.nodes.push_back(optionNode);
-            node.nodes.push_back(subNode);
-            fullFieldName = saveFullName;
-            return;
-        }
-        if(chr==',') {
-            Node subNode(name);
-            if(optionNode.name.size()>0) subNode.nodes.push_back(optionNode);
-            node.nodes.push_back(subNode);
-            string rest = request.substr(end+1);
-            fullFieldName = saveFullName;
-            createSubNode(node,rest);
-            return;
-        }
-        if(chr=='.') {
-            request = request.substr(end+1);
-            if(request.size()==string::npos || request.size()<1) {
-                throw std::logic_error("null field name " + request);
-            }
-            Node subNode(name);
-            if(optionNode.name.size()>0) subNode.nodes.push_back(optionNode);
-            size_t endField = findEndField(request);
-            string subRequest = request.substr(0, endField);
-            createSubNode(subNode,subRequest);
-            node.nodes.push_back(subNode);
-            size_t next = endField+1;
-            if(next>=request.size()) {
-                fullFieldName = saveFullName;
-                return;
-            }
-            request = request.substr(next);
-            fullFieldName = saveFullName;
-            createSubNode(node,request);
-            return;
-        }
-        if(chr=='{') {
-            size_t endBrace = findEndField(request);
-            if((end+1)>=(endBrace-1)) {
-                throw std::logic_error("illegal syntax " + request);
-            }
-            string subRequest = request.substr(end+1,endBrace-1 -end -1);
-            if(subRequest.size()<1) {
-                throw std::logic_error("empty {} " + request);
-            }
-            Node subNode(name);
-            if(optionNode.name.size()>0) subNode.nodes.push_back(optionNode);
-            createSubNode(subNode,subRequest);
-            node.nodes.push_back(subNode);
-            size_t next = endBrace + 1;
-            if(next>=request.size()) {
-                fullFieldName = saveFullName;
-                return;
-            }
-            request = request.substr(next);
-            fullFieldName = saveFullName;
-            createSubNode(node,request);
-            return;
-        }
-        throw std::logic_error("logic error");
+        StringArray names;
+        FieldConstPtrArray fields;
+        path = top;
+        parseList(names, fields);
+        return fieldCreate->createStructure(names, fields);
     }
 
-    FieldConstPtr createSubStructure(vector<Node> & nodes)
+    StructureConstPtr parse()
     {
-        size_t num = nodes.size();
-        StringArray names(num);
-        FieldConstPtrArray fields(num);
-        for(size_t i=0; i<num; ++i) {
-            Node node = nodes[i];
-            names[i] = node.name;
-            if(node.name.compare("_options")==0) {
-                fields[i] = createOptions(node.nodes);
+        enum {record, field, getField, putField, nsections};
+        static const char * const keywords[nsections] = {"record", "field", "getField", "putField"};
+        StructureConstPtr sections[nsections];
+        bool seen[nsections] = {false, false, false, false};
+
+        const char *start = pos;
+        string name(token(",.[](){}"));
+        unsigned sect = 0;
+        while(sect<nsections && name!=keywords[sect])
+            sect++;
+
+        if(sect==nsections || peek()!=(sect==record ? '[' : '(')) {
+            // a plain list of fields is short for field(list)
+            pos = start;
+            if(!atEnd()) {
+                sections[field] = parseList("field");
+                seen[field] = true;
+            }
+
+        } else while(true) {
+            if(seen[sect])
+                error(string("duplicate ") + keywords[sect]);
+            seen[sect] = true;
+
+            if(sect==record) {
+                expect('[');
+                if(!accept(']')) {
+                    path = "record";
+                    StringArray names(1, "_options");
+                    FieldConstPtrArray fields(1, parseOptions());
+                    sections[record] = fieldCreate->createStructure(names, fields);
+                }
+                // record[] is omitted
+                seen[record] = !!sections[record];
             } else {
-                vector<Node> subNode = node.nodes;
-                if(subNode.empty()) {
-                    fields[i] = fieldCreate->createStructure();
-                } else {
-                    fields[i] = createSubStructure(subNode);
+                expect('(');
+                if(!accept(')')) {
+                    sections[sect] = parseList(keywords[sect]);
+                    expect(')');
                 }
             }
+
+            while(accept(',')) {}
+            if(atEnd())
+                break;
+            name = token(",.[](){}");
+            for(sect=0; sect<nsections && name!=keywords[sect]; sect++) {}
+            if(sect==nsections)
+                error("expected record[, field(, getField(, or putField(");
         }
-        StructureConstPtr structure = fieldCreate->createStructure(
-            names, fields);
-        return structure;
+
+        if(!atEnd())
+            error("unexpected character");
+
+        StringArray names;
+        FieldConstPtrArray fields;
+        for(unsigned i=0; i<nsections; i++) {
+            if(!seen[i])
+                continue;
+            names.push_back(keywords[i]);
+            fields.push_back(sections[i] ? sections[i] : fieldCreate->createStructure());
+        }
+        return fieldCreate->createStructure(names, fields);
+    }
+};
+
+/* Parsed requests, by request string, least recently used last.
+ * Entries are never handed out, only cloned.  Since field values
+ * are shared by copy, a clone allocates only the PVFields.
+ */
+struct RequestCache {
+    struct Entry {
+        PVStructurePtr request;
+        std::list<const string*>::iterator lru;
+    };
+    typedef std::map<string, Entry> index_t;
+
+    Mutex mutex;
+    index_t index;
+    std::list<const string*> lru;
+    size_t limit;
+
+    RequestCache() :limit(128) {}
+
+    PVStructurePtr find(const string& key)
+    {
+        Lock G(mutex);
+        index_t::iterator it(index.find(key));
+        if(it==index.end())
+            return PVStructurePtr();
+        lru.splice(lru.begin(), lru, it->second.lru);
+        return it->second.request;
+    }
+
+    // returns false if request was not stored
+    bool insert(const string& key, const PVStructurePtr& request)
+    {
+        Lock G(mutex);
+        if(limit==0)
+            return false;
+        std::pair<index_t::iterator, bool> ins(index.insert(std::make_pair(key, Entry())));
+        if(!ins.second)
+            return false; // raced with another thread
+        ins.first->second.request = request;
+        lru.push_front(&ins.first->first);
+        ins.first->second.lru = lru.begin();
+        trim();
+        return true;
     }
 
-    StructureConstPtr createOptions(vector<Node> &nodes)
+    void trim()
     {
-        size_t num = nodes.size();
-        StringArray names(num);
-        FieldConstPtrArray fields(num);
-        for(size_t i=0; i<num; ++i) {
-            Node node = nodes[i];
-            names[i] = node.name;
-            fields[i] = fieldCreate->createScalar(pvString);
+        while(index.size()>limit) {
+            index.erase(*lru.back());
+            lru.pop_back();
         }
-        StructureConstPtr structure = fieldCreate->createStructure(names, fields);
-        return structure;
     }
 
+    static RequestCache& instance()
+    {
+        // never destroyed, may be used from static destructors
+        static RequestCache *cache = new RequestCache;
+        return *cache;
+    }
+};
+
+} // namespace
+
+class CreateRequestImpl : public CreateRequest {
 public:
 
     virtual PVStructurePtr createRequest(
         string const & crequest)
     {
         try {
-            string request = crequest;
-            if (!request.empty()) removeBlanks(request);
-            if (request.empty())
-            {
-                return pvDataCreate->createPVStructure(fieldCreate->createStructure());
-            }
-            size_t offsetRecord = request.find("record[");
-            size_t offsetField = request.find("field(");
-            size_t offsetPutField = request.find("putField(");
-            size_t offsetGetField = request.find("getField(");
-            if(offsetRecord==string::npos
-            && offsetField==string::npos
-            && offsetPutField==string::npos
-            && offsetGetField==string::npos)
-            {
-                 request = "field(" + request + ")";
-                 offsetField = request.find("field(");
+            RequestCache& cache = RequestCache::instance();
+            PVStructurePtr cached(cache.find(crequest));
+            if(!cached) {
+                RequestParser parser(crequest);
+                cached = pvDataCreate->createPVStructure(parser.parse());
+                for(size_t i=0; i<parser.options.size(); ++i)
+                    cached->getSubFieldT<PVString>(parser.options[i].first)->put(parser.options[i].second);
+                if(!cache.insert(crequest, cached))
+                    return cached;
             }
-            int numParan = 0;
-            int numBrace = 0;
-            int numBracket = 0;
-            for(size_t i=0; i< request.length() ; ++i) {
-                char chr = request[i];
-                if(chr=='(') numParan++;
-                if(chr==')') numParan--;
-                if(chr=='{') numBrace++;
-                if(chr=='}') numBrace--;
-                if(chr=='[') numBracket++;
-                if(chr==']') numBracket--;
-            }
-            if(numParan!=0) {
-                ostringstream oss;
-                oss << "mismatched () " << numParan;
-                message = oss.str();
-                return PVStructurePtr();
-            }
-            if(numBrace!=0) {
-                ostringstream oss;
-                oss << "mismatched {} " << numBrace;
-                message = oss.str();
-                return PVStructurePtr();
-            }
-            if(numBracket!=0) {
-                ostringstream oss;
-                oss << "mismatched [] " << numBracket;
-                message = oss.str();
-                return PVStructurePtr();
-            }
-            vector<Node> top;
-            try {
-                if(offsetRecord!=string::npos) {
-                    fullFieldName = "record";
-                    size_t openBracket = request.find('[', offsetRecord);
-                    size_t closeBracket = request.find(']', openBracket);
-                    if(closeBracket==string::npos) {
-                        message = request.substr(offsetRecord) +
-                            "record[ does not have matching ]";
-                        return PVStructurePtr();
-                    }
-                    if(closeBracket-openBracket > 3) {
-                        Node node("record");
-                        Node optNode = createRequestOptions(
-                                request.substr(openBracket+1,closeBracket-openBracket-1));
-                        node.nodes.push_back(optNode);
-                        top.push_back(node);
-                    }
-                }
-                if(offsetField!=string::npos) {
-                    fullFieldName = "field";
-                    Node node("field");
-                    size_t openParan = request.find('(', offsetField);
-                    size_t closeParan = request.find(')', openParan);
-                    if(closeParan==string::npos) {
-                        message = request.substr(offsetField)
-                                + " field( does not have matching )";
-                        return PVStructurePtr();
-                    }
-                    if(closeParan>openParan+1) {
-                        createSubNode(node,request.substr(openParan+1,closeParan-openParan-1));
-                    }
-                    top.push_back(node);
-                }
-                if(offsetGetField!=string::npos) {
-                    fullFieldName = "getField";
-                    Node node("getField");
-                    size_t openParan = request.find('(', offsetGetField);
-                    size_t closeParan = request.find(')', openParan);
-                    if(closeParan==string::npos) {
-                        message = request.substr(offsetField)
-                                + " getField( does not have matching )";
-                        return PVStructurePtr();
-                    }
-                    if(closeParan>openParan+1) {
-                        createSubNode(node,request.substr(openParan+1,closeParan-openParan-1));
-                    }
-                    top.push_back(node);
-                }
-                if(offsetPutField!=string::npos) {
-                    fullFieldName = "putField";
-                    Node node("putField");
-                    size_t openParan = request.find('(', offsetPutField);
-                    size_t closeParan = request.find(')', openParan);
-                    if(closeParan==string::npos) {
-                        message = request.substr(offsetField)
-                                + " putField( does not have matching )";
-                        return PVStructurePtr();
-                    }
-                    if(closeParan>openParan+1) {
-                        createSubNode(node,request.substr(openParan+1,closeParan-openParan-1));
-                    }
-                    top.push_back(node);
-                }
-            } catch (std::exception &e) {
-                string xxx = e.what();
-                message = "while creating Structure exception " + xxx;
-                return PVStructurePtr();
-            }
-            size_t num = top.size();
-            StringArray names(num);
-            FieldConstPtrArray fields(num);
-            for(size_t i=0; i<num; ++i) {
-                Node node = top[i];
-                names[i] = node.name;
-                vector<Node> subNode = node.nodes;
-                if(subNode.empty()) {
-                    fields[i] = fieldCreate->createStructure();
-                } else {
-                    fields[i] = createSubStructure(subNode);
-                }
-            }
-            StructureConstPtr structure = fieldCreate->createStructure(names, fields);
-            if(!structure) throw std::invalid_argument("bad request " + crequest);
-            PVStructurePtr pvStructure = pvDataCreate->createPVStructure(structure);
-            for(size_t i=0; i<optionList.size(); ++i) {
-                OptionPair pair = optionList[i];
-                string name = pair.name;
-                string value = pair.value;
-                PVStringPtr pvField = pvStructure->getSubField<PVString>(name);
-                if(!pvField) throw std::invalid_argument("bad request " + crequest);
-                pvField->put(value);
-            }
-            optionList.clear();
-            return pvStructure;
+            return pvDataCreate->createPVStructure(cached);
         } catch (std::exception &e) {
              message = e.what();
              return PVStructurePtr();
         }
     }
-
-
 };
 
 CreateRequest::shared_pointer CreateRequest::create()
@@ -482,5 +328,19 @@ CreateRequest::shared_pointer CreateRequest::create()
     return createRequest;
 }
 
-}}
+void CreateRequest::setCacheSize(size_t entries)
+{
+    RequestCache& cache = RequestCache::instance();
+    Lock G(cache.mutex);
+    cache.limit = entries;
+    cache.trim();
+}
 
+size_t CreateRequest::cacheSize()
+{
+    RequestCache& cache = RequestCache::instance();
+    Lock G(cache.mutex);
+    return cache.index.size();
+}
+
+}}
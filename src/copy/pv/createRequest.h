@@ -32,6 +32,13 @@ class epicsShareClass CreateRequest {
      * @returns A shared pointer to the new instance.
      */
     static CreateRequest::shared_pointer create();
+    /**
+     * Set the number of request strings whose parsed result is remembered
+     * by all instances.  Default 128.  0 disables the cache.
+     */
+    static void setCacheSize(size_t entries);
+    //! Number of request strings currently remembered
+    static size_t cacheSize();
     virtual ~CreateRequest() {};
     /**
     * Create a request structure for the create calls in Channel.
@@ -40,6 +47,9 @@ class epicsShareClass CreateRequest {
     * @return The request PVStructure if a valid request was given.
     * If a NULL PVStructure is returned then getMessage will return
     * the reason.
+    *
+    * Each call returns a new PVStructure.  Repeated request strings
+    * are parsed once.  See setCacheSize().
     */
     virtual PVStructure::shared_pointer createRequest(std::string const & request) = 0;
     /**
@@ -50,6 +50,8 @@ struct CopyMasterNode;
 typedef std::tr1::shared_ptr<CopyMasterNode> CopyMasterNodePtr;
 struct CopyStructureNode;
 typedef std::tr1::shared_ptr<CopyStructureNode> CopyStructureNodePtr;
+struct CopyOffsetMap;
+typedef std::tr1::shared_ptr<CopyOffsetMap> CopyOffsetMapPtr;
 
 
 /**
@@ -74,6 +76,19 @@ public:
         PVStructurePtr const &pvMaster,
         PVStructurePtr const &pvRequest,
         std::string const & structureName);
+    /**
+     * As create(), but returns an existing PVCopy if one is in use for
+     * the same pvMaster, an equal pvRequest, and the same structureName.
+     *
+     * A server with many subscribers for the same fields of a record
+     * then has one Structure and one mapping, and only creates
+     * per-subscriber copy PVStructures and BitSets.
+     * The returned PVCopy must not be destroy()ed, as other callers may hold it.
+     */
+    static PVCopyPtr createShared(
+        PVStructurePtr const &pvMaster,
+        PVStructurePtr const &pvRequest,
+        std::string const & structureName);
     virtual ~PVCopy(){}
     virtual void destroy();
     /**
@@ -110,6 +125,8 @@ public:
      * A value of std::string::npos means that the copy does not have this field.
      * @param masterPVStructure A structure in master that has masterPVField.
      * @param masterPVField The field in master.
+     *
+     * Equivalent to getCopyOffset(masterPVField).
      */
     std::size_t getCopyOffset(
         PVStructurePtr const  &masterPVStructure,
@@ -183,6 +200,7 @@ private:
     PVStructurePtr pvMaster;
     StructureConstPtr structure;
     CopyNodePtr headNode;
+    CopyOffsetMapPtr offsetMap;
     PVStructurePtr cacheInitStructure;
     PVCopy(PVStructurePtr const &pvMaster);
     friend class PVCopyMonitor;
@@ -198,32 +216,18 @@ private:
         PVStructurePtr const &pvMasterStructure,
         PVStructurePtr const &pvFromRequest,
         PVStructurePtr const &pvFromField);
-    void updateStructureNodeSetBitSet(
-        PVStructurePtr const &pvCopy,
-        CopyStructureNodePtr const &structureNode,
-        BitSetPtr const &bitSet);
+    void compileOffsetMap();
+    size_t compileOffsetMap(CopyNodePtr const &node);
     void updateSubFieldSetBitSet(
-        PVFieldPtr const &pvCopy,
-        PVFieldPtr const &pvMaster,
-        BitSetPtr const &bitSet);
-    void updateStructureNodeFromBitSet(
-        PVStructurePtr const &pvCopy,
-        CopyStructureNodePtr const &structureNode,
-        BitSetPtr const &bitSet,
-        bool toCopy,
-        bool doAll);
-    void updateSubFieldFromBitSet(
-        PVFieldPtr const &pvCopy,
-        PVFieldPtr const &pvMasterField,
-        BitSetPtr const &bitSet,
-        bool toCopy,
-        bool doAll);
-    CopyMasterNodePtr getCopyOffset(
-        CopyStructureNodePtr const &structureNode,
-        PVFieldPtr const &masterPVField);
-    CopyMasterNodePtr getMasterNode(
-        CopyStructureNodePtr const &structureNode,
-        std::size_t structureOffset);
+        PVField &pvCopy,
+        BitSet &bitSet);
+    void updateFromBitSet(
+        PVStructure &copyPVStructure,
+        BitSet const &bitSet,
+        bool toCopy);
+    void updateSubField(
+        PVField &pvCopy,
+        bool toCopy);
     
 };
 
@@ -11,12 +11,15 @@
 #include <stdexcept>
 #include <memory>
 #include <sstream>
+#include <map>
+#include <algorithm>
 
 #include <epicsThread.h>
 
 #define epicsExportSharedSymbols
 
 #include <pv/thread.h>
+#include <pv/lock.h>
 
 #include <pv/pvCopy.h>
 
@@ -44,9 +47,7 @@ static void newLine(string *buffer, int indentLevel)
 static PVCopyPtr NULLPVCopy;
 static FieldConstPtr NULLField;
 static StructureConstPtr NULLStructure;
-static PVStructurePtr NULLPVStructure;
 static CopyNodePtr NULLCopyNode;
-static CopyMasterNodePtr NULLCopyMasterNode;
 
 struct CopyNode {
     CopyNode()
@@ -71,6 +72,47 @@ struct CopyStructureNode : public  CopyNode {
     CopyNodePtrArrayPtr nodes;
 };
 
+/* The node tree flattened into tables indexed by field offset.
+ * Master offsets are relative to pvMaster.
+ * A copy field either has the same type as its master field,
+ * or is a structure with only some of the master sub-fields (partial).
+ */
+struct CopyOffsetMap {
+    PVFieldPtrArray masterFields;        // pvMaster and all sub-fields, by master offset
+    std::vector<size_t> copyOffsets;     // by master offset, string::npos if not in copy
+    std::vector<size_t> masterOffsets;   // by copy offset
+    std::vector<char> partial;           // by copy offset
+    std::vector<PVStructurePtr> options; // by copy offset
+};
+
+static void flatten(PVFieldPtrArray &fields, PVFieldPtr const &pvField)
+{
+    fields.push_back(pvField);
+    if(pvField->getField()->getType()!=epics::pvData::structure) return;
+    PVFieldPtrArray const &subFields =
+        static_cast<PVStructure*>(pvField.get())->getPVFields();
+    for(size_t i=0; i<subFields.size(); i++)
+        flatten(fields, subFields[i]);
+}
+
+// the field of top with the given offset.  Child offsets are increasing.
+static PVField* findField(PVStructure *top, size_t offset)
+{
+    PVField *pvField = top;
+    while(pvField->getFieldOffset()!=offset) {
+        PVFieldPtrArray const &fields =
+            static_cast<PVStructure*>(pvField)->getPVFields();
+        size_t lo = 0, hi = fields.size();
+        while(hi-lo>1) {
+            size_t mid = (lo+hi)/2;
+            if(fields[mid]->getFieldOffset()<=offset) lo = mid;
+            else hi = mid;
+        }
+        pvField = fields[lo].get();
+    }
+    return pvField;
+}
+
 PVCopyPtr PVCopy::create(
     PVStructurePtr const &pvMaster, 
     PVStructurePtr const &pvRequest, 
@@ -91,6 +133,115 @@ PVCopyPtr PVCopy::create(
     return pvCopy;
 }
 
+namespace {
+/* PVCopy instances in use, by master.  Holds only weak references.
+ * Entries of other masters are pruned when the map has doubled in size.
+ */
+struct SharedCopies {
+    struct Entry {
+        PVStructurePtr pvRequest;
+        string structureName;
+        std::tr1::weak_ptr<PVCopy> pvCopy;
+    };
+    struct Copies {
+        std::tr1::weak_ptr<PVStructure> pvMaster;
+        std::vector<Entry> entries;
+    };
+    typedef std::map<const PVStructure*, Copies> copies_t;
+
+    Mutex mutex;
+    copies_t copies;
+    size_t pruneSize;
+
+    SharedCopies() :pruneSize(16) {}
+
+    // remove expired entries, returns true if none remain
+    static bool prune(Copies& C)
+    {
+        size_t n = 0;
+        for(size_t i=0; i<C.entries.size(); i++) {
+            if(C.entries[i].pvCopy.expired()) continue;
+            if(n!=i) C.entries[n] = C.entries[i];
+            n++;
+        }
+        C.entries.resize(n);
+        return n==0 || C.pvMaster.expired();
+    }
+
+    void pruneAll()
+    {
+        for(copies_t::iterator it = copies.begin(); it!=copies.end();) {
+            if(prune(it->second)) copies.erase(it++);
+            else ++it;
+        }
+        pruneSize = std::max(size_t(16), 2*copies.size());
+    }
+
+    static SharedCopies& instance()
+    {
+        // never destroyed, as PVCopy may outlive static destructors
+        static SharedCopies *shared = new SharedCopies;
+        return *shared;
+    }
+};
+} // namespace
+
+PVCopyPtr PVCopy::createShared(
+    PVStructurePtr const &pvMaster,
+    PVStructurePtr const &pvRequest,
+    string const & structureName)
+{
+    SharedCopies& shared = SharedCopies::instance();
+    {
+        Lock G(shared.mutex);
+        SharedCopies::copies_t::iterator it = shared.copies.find(pvMaster.get());
+        if(it!=shared.copies.end()) {
+            SharedCopies::Copies& C = it->second;
+            if(C.pvMaster.lock()==pvMaster) {
+                for(size_t i=0; i<C.entries.size(); i++) {
+                    SharedCopies::Entry& E = C.entries[i];
+                    if(E.structureName!=structureName) continue;
+                    if(E.pvRequest!=pvRequest && *E.pvRequest!=*pvRequest) continue;
+                    PVCopyPtr pvCopy(E.pvCopy.lock());
+                    if(pvCopy) return pvCopy;
+                }
+            }
+        }
+    }
+
+    // create without the lock held
+    PVCopyPtr pvCopy(create(pvMaster, pvRequest, structureName));
+    if(!pvCopy) return pvCopy;
+    // createPVStructure() is not re-entrant while the initial structure is cached
+    pvCopy->cacheInitStructure.reset();
+
+    SharedCopies::Entry E;
+    E.pvRequest = getPVDataCreate()->createPVStructure(pvRequest);
+    E.structureName = structureName;
+    E.pvCopy = pvCopy;
+
+    Lock G(shared.mutex);
+    SharedCopies::Copies& C = shared.copies[pvMaster.get()];
+    if(C.pvMaster.lock()!=pvMaster) {
+        // new master, or a new master at the address of a destroyed one
+        C.pvMaster = pvMaster;
+        C.entries.clear();
+    } else {
+        SharedCopies::prune(C);
+        // prefer an instance created by another thread meanwhile
+        for(size_t i=0; i<C.entries.size(); i++) {
+            SharedCopies::Entry& O = C.entries[i];
+            if(O.structureName!=structureName || *O.pvRequest!=*pvRequest) continue;
+            PVCopyPtr other(O.pvCopy.lock());
+            if(other) return other;
+        }
+    }
+    C.entries.push_back(E);
+    if(shared.copies.size()>=shared.pruneSize)
+        shared.pruneAll();
+    return pvCopy;
+}
+
 PVCopy::PVCopy(
     PVStructurePtr const &pvMaster)
 : pvMaster(pvMaster)
@@ -100,6 +251,7 @@ PVCopy::PVCopy(
 void PVCopy::destroy()
 {
     headNode.reset();
+    offsetMap.reset();
 }
 
 PVStructurePtr PVCopy::getPVMaster()
@@ -142,92 +294,34 @@ PVStructurePtr PVCopy::createPVStructure()
 
 PVStructurePtr PVCopy::getOptions(std::size_t fieldOffset)
 {
-    if(fieldOffset==0) return headNode->options;
-    CopyNodePtr node = headNode;
-    while(true) {
-        if(!node->isStructure) {
-            if(node->structureOffset==fieldOffset) return node->options;
-            return NULLPVStructure;
-        }
-        CopyStructureNodePtr structNode = static_pointer_cast<CopyStructureNode>(node);
-        CopyNodePtrArrayPtr nodes = structNode->nodes;
-        boolean okToContinue = false;
-        for(size_t i=0; i< nodes->size(); i++) {
-            node = (*nodes)[i];
-            size_t soff = node->structureOffset;
-            if(fieldOffset>=soff && fieldOffset<soff+node->nfields) {
-                if(fieldOffset==soff) return node->options;
-                if(!node->isStructure) {
-                    return NULLPVStructure;
-                }
-                okToContinue = true;
-                break;
-            }
-        }
-        if(okToContinue) continue;
+    if(fieldOffset>=offsetMap->options.size())
         throw std::invalid_argument("fieldOffset not valid");
-    }
+    return offsetMap->options[fieldOffset];
 }
 
 size_t PVCopy::getCopyOffset(PVFieldPtr const &masterPVField)
 {
-    if(masterPVField->getFieldOffset()==0) return 0;
-    if(!headNode->isStructure) {
-        CopyMasterNodePtr masterNode = static_pointer_cast<CopyMasterNode>(headNode);
-        if((masterNode->masterPVField.get())==masterPVField.get()) {
-             return headNode->structureOffset;
-        }
-        PVStructure * parent = masterPVField->getParent();
-        size_t offsetParent = parent->getFieldOffset();
-        size_t off = masterPVField->getFieldOffset();
-        size_t offdiff = off -offsetParent;
-        if(offdiff<masterNode->nfields) return headNode->structureOffset + offdiff;
+    size_t offset = masterPVField->getFieldOffset() - pvMaster->getFieldOffset();
+    if(offset>=offsetMap->masterFields.size()
+            || offsetMap->masterFields[offset].get()!=masterPVField.get())
         return string::npos;
-    }
-    CopyStructureNodePtr node = static_pointer_cast<CopyStructureNode>(headNode);
-    CopyMasterNodePtr masterNode = getCopyOffset(node,masterPVField);
-    if(masterNode) return masterNode->structureOffset;
-    return string::npos;
+    return offsetMap->copyOffsets[offset];
 }
 
 size_t PVCopy::getCopyOffset(
     PVStructurePtr const  &masterPVStructure,
     PVFieldPtr const  &masterPVField)
 {
-    CopyMasterNodePtr masterNode;
-    if(!headNode->isStructure) {
-        masterNode = static_pointer_cast<CopyMasterNode>(headNode);
-        if(masterNode->masterPVField.get()!=masterPVStructure.get()) return string::npos;
-    } else {
-        CopyStructureNodePtr node = static_pointer_cast<CopyStructureNode>(headNode);
-        masterNode = getCopyOffset(node,masterPVField);
-    }
-    if(!masterNode) return string::npos;
-    size_t diff = masterPVField->getFieldOffset()
-        - masterPVStructure->getFieldOffset();
-    return masterNode->structureOffset + diff;
+    return getCopyOffset(masterPVField);
 }
 
 PVFieldPtr PVCopy::getMasterPVField(size_t structureOffset)
 {
-    CopyMasterNodePtr masterNode;
-    if(!headNode->isStructure) {
-        masterNode = static_pointer_cast<CopyMasterNode>(headNode);
-    } else {
-        CopyStructureNodePtr node = static_pointer_cast<CopyStructureNode>(headNode);
-        masterNode = getMasterNode(node,structureOffset);
-    }
-    if(!masterNode) {
+    if(structureOffset>=offsetMap->masterOffsets.size()) {
         throw std::invalid_argument(
             "PVCopy::getMasterPVField: setstructureOffset not valid");
     }
-    size_t diff = structureOffset - masterNode->structureOffset;
-    PVFieldPtr pvMasterField = masterNode->masterPVField;
-    if(diff==0) return pvMasterField;
-    PVStructurePtr pvStructure
-        = static_pointer_cast<PVStructure>(pvMasterField);
-    return pvStructure->getSubField(
-        pvMasterField->getFieldOffset() + diff);
+    return offsetMap->masterFields[offsetMap->masterOffsets[structureOffset]];
 }
 
 void PVCopy::initCopy(
@@ -243,55 +337,21 @@ void PVCopy::updateCopySetBitSet(
     PVStructurePtr const  &copyPVStructure,
     BitSetPtr const  &bitSet)
 {
-    if(headNode->isStructure) {
-        CopyStructureNodePtr node = static_pointer_cast<CopyStructureNode>(headNode);
-        updateStructureNodeSetBitSet(copyPVStructure,node,bitSet);
-    } else {
-        CopyMasterNodePtr masterNode = static_pointer_cast<CopyMasterNode>(headNode);
-        PVFieldPtr pvMasterField= masterNode->masterPVField;
-        PVFieldPtr copyPVField = copyPVStructure;
-        PVFieldPtr pvField = pvMasterField;
-        if(pvField->getField()->getType()==epics::pvData::structure) {
-            updateSubFieldSetBitSet(copyPVField,pvMasterField,bitSet);
-            return;
-        }
-        bool isEqual = (*copyPVField == *pvField);
-        if(!isEqual) {
-            copyPVField->copyUnchecked(*pvField);
-            bitSet->set(copyPVField->getFieldOffset());
-        }
-    }
+    updateSubFieldSetBitSet(*copyPVStructure,*bitSet);
 }
 
 void PVCopy::updateCopyFromBitSet(
     PVStructurePtr const  &copyPVStructure,
     BitSetPtr const  &bitSet)
 {
-    bool doAll = bitSet->get(0);
-    if(headNode->isStructure) {
-        CopyStructureNodePtr node = static_pointer_cast<CopyStructureNode>(headNode);
-        updateStructureNodeFromBitSet(copyPVStructure,node,bitSet,true,doAll);
-    } else {
-        CopyMasterNodePtr masterNode = static_pointer_cast<CopyMasterNode>(headNode);
-        updateSubFieldFromBitSet(copyPVStructure, masterNode->masterPVField,bitSet, true,doAll);
-    }
+    updateFromBitSet(*copyPVStructure,*bitSet,true);
 }
 
 void PVCopy::updateMaster(
     PVStructurePtr const  &copyPVStructure,
     BitSetPtr const  &bitSet)
 {
-    bool doAll = bitSet->get(0);
-    if(headNode->isStructure) {
-        CopyStructureNodePtr node =
-            static_pointer_cast<CopyStructureNode>(headNode);
-        updateStructureNodeFromBitSet(
-            copyPVStructure,node,bitSet,false,doAll);
-    } else {
-        CopyMasterNodePtr masterNode =
-            static_pointer_cast<CopyMasterNode>(headNode);
-        updateSubFieldFromBitSet( copyPVStructure,masterNode->masterPVField,bitSet,false,doAll);
-    }
+    updateFromBitSet(*copyPVStructure,*bitSet,false);
 }
 
 string PVCopy::dump()
@@ -361,6 +421,7 @@ bool PVCopy::init(epics::pvData::PVStructurePtr const &pvRequest)
         masterNode->structureOffset = 0;
         masterNode->masterPVField = pvMasterStructure;
         masterNode->nfields = pvMasterStructure->getNumberFields();
+        compileOffsetMap();
         return true;
     }
     structure = createStructure(pvMasterStructure,pvRequest);
@@ -370,9 +431,55 @@ bool PVCopy::init(epics::pvData::PVStructurePtr const &pvRequest)
         pvMaster,
         pvRequest,
         cacheInitStructure);
+    compileOffsetMap();
     return true;
 }
 
+void PVCopy::compileOffsetMap()
+{
+    offsetMap.reset(new CopyOffsetMap());
+    flatten(offsetMap->masterFields, pvMaster);
+    size_t numberMaster = offsetMap->masterFields.size();
+    size_t numberCopy = headNode->nfields;
+    offsetMap->copyOffsets.resize(numberMaster, string::npos);
+    offsetMap->masterOffsets.resize(numberCopy, 0);
+    offsetMap->partial.resize(numberCopy, 0);
+    offsetMap->options.resize(numberCopy);
+    compileOffsetMap(headNode);
+}
+
+// returns the master offset of node
+size_t PVCopy::compileOffsetMap(CopyNodePtr const &node)
+{
+    CopyOffsetMap &map = *offsetMap;
+    size_t copyOffset = node->structureOffset;
+    size_t masterOffset;
+    if(!node->isStructure) {
+        CopyMasterNodePtr masterNode = static_pointer_cast<CopyMasterNode>(node);
+        masterOffset = masterNode->masterPVField->getFieldOffset()
+            - pvMaster->getFieldOffset();
+        for(size_t i=0; i<node->nfields; i++) {
+            map.masterOffsets[copyOffset+i] = masterOffset+i;
+            map.copyOffsets[masterOffset+i] = copyOffset+i;
+        }
+    } else {
+        CopyStructureNodePtr structNode = static_pointer_cast<CopyStructureNode>(node);
+        CopyNodePtrArrayPtr nodes = structNode->nodes;
+        size_t child = 0;
+        for(size_t i=0; i<nodes->size(); i++)
+            child = compileOffsetMap((*nodes)[i]);
+        // the master structure holding the last child
+        masterOffset = copyOffset==0 ? 0 :
+            map.masterFields[child]->getParent()->getFieldOffset()
+                - pvMaster->getFieldOffset();
+        map.masterOffsets[copyOffset] = masterOffset;
+        map.copyOffsets[masterOffset] = copyOffset;
+        map.partial[copyOffset] = 1;
+    }
+    map.options[copyOffset] = node->options;
+    return masterOffset;
+}
+
 string PVCopy::dump(
     string const &value,
     CopyNodePtr const &node,
@@ -478,179 +585,69 @@ CopyNodePtr PVCopy::createStructureNodes(
     return structureNode;
 }
 
-void PVCopy::updateStructureNodeSetBitSet(
-    PVStructurePtr const &pvCopy,
-    CopyStructureNodePtr const &structureNode,
-    epics::pvData::BitSetPtr const &bitSet)
-{
-    for(size_t i=0; i<structureNode->nodes->size(); i++) {
-        CopyNodePtr node = (*structureNode->nodes)[i];
-        PVFieldPtr pvField = pvCopy->getSubField(node->structureOffset);
-        if(node->isStructure) {
-            PVStructurePtr xxx = static_pointer_cast<PVStructure>(pvField);
-            CopyStructureNodePtr yyy =
-                static_pointer_cast<CopyStructureNode>(node);
-            updateStructureNodeSetBitSet(xxx,yyy,bitSet); 
-        } else {
-            CopyMasterNodePtr masterNode =
-                static_pointer_cast<CopyMasterNode>(node);
-            updateSubFieldSetBitSet(pvField,masterNode->masterPVField,bitSet);
-        }
-    }
-}
-
 void PVCopy::updateSubFieldSetBitSet(
-    PVFieldPtr const &pvCopy,
-    PVFieldPtr const &pvMaster,
-    BitSetPtr const &bitSet)
+    PVField &pvCopy,
+    BitSet &bitSet)
 {
-    FieldConstPtr field = pvCopy->getField();
-    Type type = field->getType();
-    if(type!=epics::pvData::structure) {
-        bool isEqual = (*pvCopy == *pvMaster);
-    	if(isEqual) {
-    	    if(type==structureArray) {
-    	        // always act as though a change occurred.
-    	        // Note that array elements are shared.
-                bitSet->set(pvCopy->getFieldOffset());
-    	    }
-    	}
-        if(isEqual) return;
-        pvCopy->copyUnchecked(*pvMaster);
-        bitSet->set(pvCopy->getFieldOffset());
+    Type type = pvCopy.getField()->getType();
+    if(type==epics::pvData::structure) {
+        PVFieldPtrArray const & pvCopyFields =
+            static_cast<PVStructure&>(pvCopy).getPVFields();
+        for(size_t i=0; i<pvCopyFields.size(); i++)
+            updateSubFieldSetBitSet(*pvCopyFields[i],bitSet);
         return;
     }
-    PVStructurePtr pvCopyStructure = static_pointer_cast<PVStructure>(pvCopy);
-    PVFieldPtrArray const & pvCopyFields = pvCopyStructure->getPVFields();
-    PVStructurePtr pvMasterStructure =
-        static_pointer_cast<PVStructure>(pvMaster);
-    PVFieldPtrArray const & pvMasterFields =
-        pvMasterStructure->getPVFields();
-    size_t length = pvCopyFields.size();
-    for(size_t i=0; i<length; i++) {
-        updateSubFieldSetBitSet(pvCopyFields[i],pvMasterFields[i],bitSet);
+    size_t offset = pvCopy.getFieldOffset();
+    PVField &pvMasterField =
+        *offsetMap->masterFields[offsetMap->masterOffsets[offset]];
+    if(pvCopy == pvMasterField) {
+        // always act as though a change occurred.
+        // Note that array elements are shared.
+        if(type==structureArray) bitSet.set(offset);
+        return;
     }
+    pvCopy.copyUnchecked(pvMasterField);
+    bitSet.set(offset);
 }
 
-void PVCopy::updateStructureNodeFromBitSet(
-    PVStructurePtr const &pvCopy,
-    CopyStructureNodePtr const &structureNode,
-    BitSetPtr const &bitSet,
-    bool toCopy,
-    bool doAll)
+/* For each set bit, copy the field and all of its sub-fields.
+ * Sub-fields of a copied field are skipped.
+ */
+void PVCopy::updateFromBitSet(
+    PVStructure &copyPVStructure,
+    BitSet const &bitSet,
+    bool toCopy)
 {
-    size_t offset = structureNode->structureOffset;
-    if(!doAll) {
-        size_t nextSet = bitSet->nextSetBit(offset);
-        if(nextSet==string::npos) return;
-    }
-    if(offset>=pvCopy->getNextFieldOffset()) return;
-    if(!doAll) doAll = bitSet->get(offset);
-    CopyNodePtrArrayPtr  nodes = structureNode->nodes;
-    for(size_t i=0; i<nodes->size(); i++) {
-        CopyNodePtr node = (*nodes)[i];
-        PVFieldPtr pvField = pvCopy->getSubFieldT(node->structureOffset);
-        if(node->isStructure) {
-            PVStructurePtr xxx = static_pointer_cast<PVStructure>(pvField);
-            CopyStructureNodePtr subStructureNode =
-                static_pointer_cast<CopyStructureNode>(node);
-            updateStructureNodeFromBitSet(
-                 xxx,subStructureNode,bitSet,toCopy,doAll);
-        } else {
-            CopyMasterNodePtr masterNode =
-                static_pointer_cast<CopyMasterNode>(node);
-            updateSubFieldFromBitSet(
-                pvField,masterNode->masterPVField,bitSet,toCopy,doAll);
-        }
+    size_t numberFields = offsetMap->masterOffsets.size();
+    for(int32 bit = bitSet.nextSetBit(0);
+        bit>=0 && size_t(bit)<numberFields;
+        bit = bitSet.nextSetBit(bit))
+    {
+        PVField *pvCopy = findField(&copyPVStructure, bit);
+        updateSubField(*pvCopy,toCopy);
+        bit = pvCopy->getNextFieldOffset();
     }
 }
 
-void PVCopy::updateSubFieldFromBitSet(
-    PVFieldPtr const &pvCopy,
-    PVFieldPtr const &pvMasterField,
-    BitSetPtr const &bitSet,
-    bool toCopy,
-    bool doAll)
+void PVCopy::updateSubField(
+    PVField &pvCopy,
+    bool toCopy)
 {
-    if(!doAll) {
-        doAll = bitSet->get(pvCopy->getFieldOffset());
-    }
-    if(!doAll) {
-        size_t offset = pvCopy->getFieldOffset();
-        size_t nextSet = bitSet->nextSetBit(offset);
-        if(nextSet==string::npos) return;
-        if(nextSet>=pvCopy->getNextFieldOffset()) return;
+    size_t offset = pvCopy.getFieldOffset();
+    if(offsetMap->partial[offset]) {
+        PVFieldPtrArray const & pvCopyFields =
+            static_cast<PVStructure&>(pvCopy).getPVFields();
+        for(size_t i=0; i<pvCopyFields.size(); i++)
+            updateSubField(*pvCopyFields[i],toCopy);
+        return;
     }
-    if(pvCopy->getField()->getType()==epics::pvData::structure) {
-        PVStructurePtr pvCopyStructure =
-            static_pointer_cast<PVStructure>(pvCopy);
-        PVFieldPtrArray const & pvCopyFields = pvCopyStructure->getPVFields();
-        if(pvMasterField->getField()->getType() !=epics::pvData::structure)
-        {
-            throw std::logic_error(string("Logic error"));
-        }
-        PVStructurePtr pvMasterStructure = 
-            static_pointer_cast<PVStructure>(pvMasterField);
-        PVFieldPtrArray const & pvMasterFields =
-            pvMasterStructure->getPVFields();
-        for(size_t i=0; i<pvCopyFields.size(); i++) {
-            updateSubFieldFromBitSet(
-                pvCopyFields[i],
-                pvMasterFields[i],
-                bitSet,toCopy,doAll);
-        }
+    PVField &pvMasterField =
+        *offsetMap->masterFields[offsetMap->masterOffsets[offset]];
+    if(toCopy) {
+        pvCopy.copyUnchecked(pvMasterField);
     } else {
-        if(toCopy) {
-            pvCopy->copyUnchecked(*pvMasterField);
-        } else {
-            pvMasterField->copyUnchecked(*pvCopy);
-        }
-    }
-}
-
-CopyMasterNodePtr PVCopy::getCopyOffset(
-        CopyStructureNodePtr const &structureNode,
-        PVFieldPtr const &masterPVField)
-{
-    size_t offset = masterPVField->getFieldOffset();
-    CopyNodePtrArrayPtr nodes = structureNode->nodes;
-    for(size_t i=0; i< nodes->size(); i++) {
-        CopyNodePtr node = (*nodes)[i];
-        if(!node->isStructure) {
-            CopyMasterNodePtr masterNode =
-                static_pointer_cast<CopyMasterNode>(node);
-            size_t off = masterNode->masterPVField->getFieldOffset();
-            size_t nextOffset = masterNode->masterPVField->getNextFieldOffset(); 
-            if(offset>= off && offset<nextOffset) return masterNode;
-        } else {
-            CopyStructureNodePtr subNode =
-                static_pointer_cast<CopyStructureNode>(node);
-            CopyMasterNodePtr masterNode =
-                getCopyOffset(subNode,masterPVField);
-            if(masterNode) return masterNode;
-        }
-    }
-    return NULLCopyMasterNode;
-}
-
-CopyMasterNodePtr PVCopy::getMasterNode(
-        CopyStructureNodePtr const &structureNode,
-        std::size_t structureOffset)
-{
-    CopyNodePtrArrayPtr nodes = structureNode->nodes;
-    for(size_t i=0; i< nodes->size(); i++) {
-        CopyNodePtr node = (*nodes)[i];
-        if(structureOffset>=(node->structureOffset + node->nfields)) continue;
-        if(!node->isStructure) {
-            CopyMasterNodePtr masterNode =
-                static_pointer_cast<CopyMasterNode>(node);
-            return masterNode;
-        }
-        CopyStructureNodePtr subNode =
-            static_pointer_cast<CopyStructureNode>(node);
-        return  getMasterNode(subNode,structureOffset);
+        pvMasterField.copyUnchecked(pvCopy);
     }
-    return NULLCopyMasterNode;
 }
 
 }}
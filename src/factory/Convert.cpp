@@ -19,6 +19,7 @@
 #include <pv/pvIntrospect.h>
 #include <pv/pvData.h>
 #include <pv/convert.h>
+#include <pv/pvPrinter.h>
 
 using std::tr1::static_pointer_cast;
 using std::size_t;
@@ -50,10 +51,9 @@ static std::vector<string> split(string commaSeparatedList) {
 void Convert::getString(string *buf,PVField const *pvField,int /*indentLevel*/)
 {
     // TODO indextLevel ignored
-    std::ostringstream strm;
-    pvField->dumpValue(strm);
-    strm << std::endl;
-    strm.str().swap(*buf);
+    buf->clear();
+    PVPrinter().print(*buf, *pvField);
+    *buf += '\n';
 }
 
 
@@ -112,6 +112,7 @@ void BasePVScalar<T>::deserialize(ByteBuffer *pbuffer,
 {
     pflusher->ensureData(sizeof(T));
     value = pbuffer->GET(T);
+    PVField::markChanged();
 }
 
 typedef BasePVScalar<boolean> BasePVBoolean;
@@ -137,6 +138,7 @@ public:
     virtual ~BasePVString();
     virtual string get() const ;
     virtual void put(string val);
+    virtual void copyUnchecked(const PVScalar& from);
     virtual void serialize(ByteBuffer *pbuffer,
         SerializableControl *pflusher) const;
     virtual void deserialize(ByteBuffer *pbuffer,
@@ -144,7 +146,11 @@ public:
     virtual void serialize(ByteBuffer *pbuffer,
         SerializableControl *pflusher, size_t offset, size_t count) const;
 private:
-    string value;
+    const string& str() const;
+    string& writable();
+    // NULL for the empty string.  Shared by copyUnchecked(), and then
+    // immutable until no other BasePVString references it.
+    std::tr1::shared_ptr<string> value;
     std::size_t maxLength;
 };
 
@@ -160,32 +166,66 @@ BasePVString::BasePVString(ScalarConstPtr const & scalar)
 
 BasePVString::~BasePVString() {}
 
-string BasePVString::get() const  { return value;}
+const string& BasePVString::str() const
+{
+    static const string empty;
+    return value ? *value : empty;
+}
+
+string& BasePVString::writable()
+{
+    if(!value || !value.unique())
+        value.reset(new string);
+    return *value;
+}
+
+string BasePVString::get() const  { return str();}
 
 void BasePVString::put(string val)
 {
     if (maxLength > 0 && val.length() > maxLength)
         throw std::overflow_error("string too long");
 
-    value = val;
+    if(val.empty())
+        value.reset();
+    else
+        writable().swap(val);
+    postPut();
+}
+
+void BasePVString::copyUnchecked(const PVScalar& from)
+{
+    if(this==&from)
+        return;
+    const BasePVString *other = dynamic_cast<const BasePVString*>(&from);
+    if(!other) {
+        PVString::copyUnchecked(from);
+        return;
+    }
+    if (maxLength > 0 && other->str().length() > maxLength)
+        throw std::overflow_error("string too long");
+
+    value = other->value;
     postPut();
 }
 
 void BasePVString::serialize(ByteBuffer *pbuffer,
     SerializableControl *pflusher) const
 {
-    SerializeHelper::serializeString(value, pbuffer, pflusher);
+    SerializeHelper::serializeString(str(), pbuffer, pflusher);
 }
 
 void BasePVString::deserialize(ByteBuffer *pbuffer,
     DeserializableControl *pflusher)
 {
-    value = SerializeHelper::deserializeString(pbuffer, pflusher);
+    SerializeHelper::deserializeString(writable(), pbuffer, pflusher);
+    markChanged();
 }
 
 void BasePVString::serialize(ByteBuffer *pbuffer,
     SerializableControl *pflusher, size_t offset, size_t count) const
 {
+	const string& value = str();
 	// check bounds
 	const size_t length = /*(value == null) ? 0 :*/ value.length();
 	/*if (offset < 0) offset = 0;
@@ -329,8 +369,14 @@ void DefaultPVArray<T>::deserialize(ByteBuffer *pbuffer,
                 this->getArray()->getMaximumCapacity() :
                 SerializeHelper::readSize(pbuffer, pcontrol);
 
-    svector nextvalue(thaw(value));
-    nextvalue.resize(size); // TODO: avoid copy of stuff we will then overwrite
+    // every element is overwritten, so re-use the array if we own it
+    // and never copy the old contents.
+    svector nextvalue;
+    if(value.unique())
+        nextvalue = thaw(value);
+    else
+        value.clear();
+    nextvalue.resize_uninitialized(size);
 
     T* cur = nextvalue.data();
 
@@ -422,19 +468,19 @@ void DefaultPVArray<string>::deserialize(ByteBuffer *pbuffer,
                 this->getArray()->getMaximumCapacity() :
                 SerializeHelper::readSize(pbuffer, pcontrol);
 
-    svector nextvalue(thaw(value));
-
-    // Decide if we must re-allocate
-    if(size > nextvalue.size() || !nextvalue.unique())
-        nextvalue.resize(size);
-    else if(size < nextvalue.size())
-        nextvalue.slice(0, size);
+    // every element is assigned, so re-use the array (and the
+    // capacity of its strings) if we own it.
+    svector nextvalue;
+    if(value.unique())
+        nextvalue = thaw(value);
+    else
+        value.clear();
+    nextvalue.resize_uninitialized(size);
 
 
     string * pvalue = nextvalue.data();
     for(size_t i = 0; i<size; i++) {
-        pvalue[i] = SerializeHelper::deserializeString(pbuffer,
-                                                       pcontrol);
+        SerializeHelper::deserializeString(pvalue[i], pbuffer, pcontrol);
     }
     value = freeze(nextvalue);
     // inform about the change?
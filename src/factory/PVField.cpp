@@ -10,12 +10,14 @@
 #include <cstdlib>
 #include <string>
 #include <cstdio>
+#include <algorithm>
 
 #include <epicsMutex.h>
 
 #define epicsExportSharedSymbols
 #include <pv/lock.h>
 #include <pv/pvData.h>
+#include <pv/bitSet.h>
 #include <pv/factory.h>
 
 using std::tr1::const_pointer_cast;
@@ -24,15 +26,40 @@ using std::string;
 
 namespace epics { namespace pvData {
 
+namespace {
+const string* emptyFieldName()
+{
+    // never destroyed, as PVFields may outlive static destructors
+    static const string *empty = new string;
+    return empty;
+}
+}
+
+/* Handlers are only changed and called by the thread holding the record lock.
+ * A handler may add or remove handlers, replacing the list of its field
+ * while the list is being called.  Lists replaced during a call are chained
+ * to the current one through retired, and freed when the outermost call returns.
+ */
+struct PVField::PostHandlerList {
+    std::vector<PostHandlerPtr> handlers;
+    PostHandlerList *retired;
+    PostHandlerList() :retired(NULL) {}
+    ~PostHandlerList() { delete retired; }
+};
+
 PVField::PVField(FieldConstPtr field)
-: parent(NULL),field(field),
+: fieldName(emptyFieldName()),parent(NULL),field(field),
   fieldOffset(0), nextFieldOffset(0),
-  immutable(false)
+  immutable(false), posting(false), ownsName(false), tracker(NULL), postHandlers(NULL), postHandler(NULL)
 {
 }
 
 PVField::~PVField()
-{ }
+{
+    delete postHandlers;
+    if(ownsName)
+        delete fieldName;
+}
 
 
 size_t PVField::getFieldOffset() const
@@ -62,26 +89,144 @@ const FieldConstPtr & PVField::getField() const {return field;}
 
 PVStructure *PVField::getParent() const {return parent;}
 
-void PVField::postPut() 
+void PVField::notifyPut()
+{
+    // during a group put, tracker is set
+    if(tracker)
+        tracker->trackPut(this, true);
+    else
+        callPostHandlers();
+}
+
+void PVField::callPostHandlers()
+{
+    PostHandlerList *list = postHandlers;
+    if(!list)
+        return;
+    if(posting) {
+        // nested, eg. a handler putting to its own field
+        callHandlers(list);
+        return;
+    }
+    posting = true;
+    try {
+        callHandlers(list);
+    } catch(...) {
+        endPosting(list);
+        throw;
+    }
+    endPosting(list);
+}
+
+void PVField::callHandlers(PostHandlerList *list)
+{
+    if(postHandler)
+        postHandler->postPut();
+    else
+        for(size_t i=0, N=list->handlers.size(); i<N; i++)
+            list->handlers[i]->postPut();
+}
+
+void PVField::endPosting(PostHandlerList *called)
+{
+    posting = false;
+    PostHandlerList *list = postHandlers;
+    if(list==called)
+        return; // unchanged, nothing retired
+    if(list && list->retired) {
+        delete list->retired;
+        list->retired = NULL;
+    }
+    // left by removing the last handler during the call
+    if(list && list->handlers.empty()) {
+        delete list;
+        postHandlers = NULL;
+    }
+}
+
+void PVField::markChanged()
 {
-   if(postHandler.get()!=NULL) postHandler->postPut();
+   if(tracker) tracker->trackPut(this, false);
 }
 
 void PVField::setPostHandler(PostHandlerPtr const &handler)
 {
-    if(postHandler.get()!=NULL) {
-        if(postHandler.get()==handler.get()) return;
+    if(postHandlers && !postHandlers->handlers.empty()) {
+        if(postHandlers->handlers.size()==1 && postHandlers->handlers[0].get()==handler.get()) return;
         throw std::logic_error(
             "PVField::setPostHandler a postHandler is already registered");
 
     }
-    postHandler = handler;
+    addPostHandler(handler);
+}
+
+void PVField::addPostHandler(PostHandlerPtr const &handler)
+{
+    if(!handler)
+        throw std::invalid_argument("PVField::addPostHandler NULL handler");
+    PostHandlerList *next = new PostHandlerList;
+    if(postHandlers) {
+        const std::vector<PostHandlerPtr>& prev = postHandlers->handlers;
+        if(std::find(prev.begin(), prev.end(), handler)!=prev.end()) {
+            delete next;
+            return;
+        }
+        next->handlers.reserve(prev.size()+1);
+        next->handlers.insert(next->handlers.end(), prev.begin(), prev.end());
+    }
+    next->handlers.push_back(handler);
+    setPostHandlers(next);
+}
+
+void PVField::removePostHandler(PostHandlerPtr const &handler)
+{
+    if(!postHandlers) return;
+    const std::vector<PostHandlerPtr>& prev = postHandlers->handlers;
+    std::vector<PostHandlerPtr>::const_iterator it(std::find(prev.begin(), prev.end(), handler));
+    if(it==prev.end()) return;
+    PostHandlerList *next = NULL;
+    if(prev.size()>1) {
+        next = new PostHandlerList;
+        next->handlers.reserve(prev.size()-1);
+        next->handlers.insert(next->handlers.end(), prev.begin(), it);
+        next->handlers.insert(next->handlers.end(), it+1, prev.end());
+    }
+    setPostHandlers(next);
+}
+
+void PVField::setPostHandlers(PostHandlerList *next)
+{
+    PostHandlerList *prev = postHandlers;
+    if(prev && posting) {
+        // the handlers of prev may be running, keep it until they return
+        if(!next)
+            next = new PostHandlerList;
+        next->retired = prev;
+    } else {
+        delete prev;
+    }
+    postHandlers = next;
+    postHandler = next && next->handlers.size()==1 ? next->handlers[0].get() : NULL;
 }
 
-void PVField::setParentAndName(PVStructure * xxx,string const & name)
+void PVField::setParentAndName(PVStructure * xxx,const string * name)
 {
+    if(ownsName) {
+        delete fieldName;
+        ownsName = false;
+    }
     parent = xxx;
-    fieldName = name;
+    fieldName = name ? name : emptyFieldName();
+}
+
+void PVField::detachFromParent()
+{
+    // our name belongs to the Structure of parent, which is going away
+    parent = NULL;
+    if(!ownsName) {
+        fieldName = new string(*fieldName);
+        ownsName = true;
+    }
 }
 
 bool PVField::equals(PVField &pv)
@@ -96,7 +241,7 @@ std::ostream& operator<<(std::ostream& o, const PVField& f)
 
 string PVField::getFullName() const
 {
-    string ret(fieldName);
+    string ret(*fieldName);
     for(PVField *fld=getParent(); fld; fld=fld->getParent())
     {
         if(fld->getFieldName().size()==0) break;
@@ -11,6 +11,7 @@
 #include <string>
 #include <cstdio>
 #include <vector>
+#include <algorithm>
 
 #define epicsExportSharedSymbols
 #include <pv/pvData.h>
@@ -57,7 +58,7 @@ PVStructure::PVStructure(StructureConstPtr const & structurePtr)
         pvFields.push_back(pvDataCreate->createPVField(fields[i]));
     }
     for(size_t i=0; i<numberFields; i++) {
-    	pvFields[i]->setParentAndName(this,fieldNames[i]);
+    	pvFields[i]->setParentAndName(this,&fieldNames[i]);
     }
 }
 
@@ -75,12 +76,27 @@ PVStructure::PVStructure(StructureConstPtr const & structurePtr,
         pvFields.push_back(pvs[i]);
     }
     for(size_t i=0; i<numberFields; i++) {
-        pvFields[i]->setParentAndName(this,fieldNames[i]);
+        pvFields[i]->setParentAndName(this,&fieldNames[i]);
     }
 }
 
 PVStructure::~PVStructure()
 {
+    // Sub-fields still referenced elsewhere become top-level fields,
+    // unless re-parented by createPVStructure(fieldNames, pvFields).
+    for(size_t i=0, n=pvFields.size(); i<n; i++) {
+        if(pvFields[i].unique())
+            continue;
+        PVField *pvField = pvFields[i].get();
+        if(pvField->parent==this)
+            pvField->detachFromParent();
+        if(pvField->tracker!=this)
+            continue;
+        if(pvField->getField()->getType()==structure)
+            static_cast<PVStructure*>(pvField)->setTracker(NULL);
+        else
+            pvField->tracker = NULL;
+    }
 }
 
 void PVStructure::setImmutable()
@@ -425,5 +441,182 @@ void PVStructure::copyUnchecked(const PVStructure& from, const BitSet& maskBitSe
     }
 }
 
+void PVStructure::setTracker(PVStructure *top)
+{
+    tracker = top;
+    for(size_t i=0, N=pvFields.size(); i<N; i++) {
+        PVField *pvField = pvFields[i].get();
+        if(pvField->getField()->getType()==structure)
+            static_cast<PVStructure*>(pvField)->setTracker(top);
+        else
+            pvField->tracker = top;
+    }
+}
+
+struct PVStructure::GroupPut {
+    unsigned depth;
+    BitSet changed; // by field offset
+    BitSet posted;  // fields in pending
+    std::vector<PVField*> pending; // with PostHandlers, in order posted
+    std::tr1::shared_ptr<const std::vector<GroupPutHandlerPtr> > handlers; // copy on write
+    GroupPut() :depth(0) {}
+};
+
+void PVStructure::updateTracker()
+{
+    bool track = changes || (groupPut && (groupPut->handlers || groupPut->depth));
+    if(track==(tracker==this))
+        return;
+    getNumberFields(); // computes offsets
+    setTracker(track ? this : NULL);
+}
+
+void PVStructure::setTrackChanges(bool track)
+{
+    if(getParent())
+        throw std::logic_error("Only top-level structures can track changes");
+    if(track==!!changes)
+        return;
+    if(track)
+        changes.reset(new BitSet(static_cast<uint32>(getNumberFields())));
+    else
+        changes.reset();
+    updateTracker();
+}
+
+void PVStructure::beginGroupPut()
+{
+    if(getParent())
+        throw std::logic_error("Only top-level structures can group puts");
+    if(!groupPut)
+        groupPut.reset(new GroupPut);
+    // puts find the group through tracker
+    if(groupPut->depth++==0)
+        updateTracker();
+}
+
+void PVStructure::endGroupPut()
+{
+    if(!groupPut || groupPut->depth==0)
+        throw std::logic_error("endGroupPut() without beginGroupPut()");
+    GroupPut& G = *groupPut;
+    if(--G.depth)
+        return;
+
+    // handlers may start another group
+    BitSet changed;
+    changed.swap(G.changed);
+    std::vector<PVField*> posted;
+    posted.swap(G.pending);
+    G.posted.clear();
+
+    if(changes)
+        *changes |= changed;
+    for(size_t i=0; i<posted.size(); i++)
+        posted[i]->callPostHandlers();
+    if(G.handlers && !changed.isEmpty()) {
+        std::tr1::shared_ptr<const std::vector<GroupPutHandlerPtr> > handlers(G.handlers);
+        for(size_t i=0; i<handlers->size(); i++)
+            (*handlers)[i]->postGroupPut(*this, changed);
+    }
+
+    // keep the capacity for the next group
+    changed.clear();
+    if(G.changed.isEmpty())
+        G.changed.swap(changed);
+    posted.clear();
+    if(G.pending.empty())
+        G.pending.swap(posted);
+    if(G.depth==0)
+        updateTracker();
+}
+
+void PVStructure::trackPut(PVField *pvField, bool post)
+{
+    uint32 offset = static_cast<uint32>(pvField->fieldOffset);
+    if(!groupPut || (groupPut->depth==0 && !groupPut->handlers)) {
+        if(changes)
+            changes->set(offset);
+        if(post)
+            pvField->callPostHandlers();
+        return;
+    }
+
+    // a put outside of a group is a group of one
+    bool single = groupPut->depth==0;
+    if(single)
+        groupPut->depth = 1;
+    groupPut->changed.set(offset);
+    if(post)
+        deferPost(pvField);
+    if(single)
+        endGroupPut();
+}
+
+bool PVStructure::deferPost(PVField *pvField)
+{
+    if(!groupPut || groupPut->depth==0)
+        return false;
+    if(!pvField->postHandlers)
+        return true;
+    uint32 offset = static_cast<uint32>(pvField->getFieldOffset());
+    if(!groupPut->posted.get(offset)) {
+        groupPut->posted.set(offset);
+        groupPut->pending.push_back(pvField);
+    }
+    return true;
+}
+
+void PVStructure::addGroupPutHandler(GroupPutHandlerPtr const &handler)
+{
+    if(getParent())
+        throw std::logic_error("Only top-level structures have GroupPutHandlers");
+    if(!handler)
+        throw std::invalid_argument("PVStructure::addGroupPutHandler NULL handler");
+    if(!groupPut)
+        groupPut.reset(new GroupPut);
+    std::tr1::shared_ptr<std::vector<GroupPutHandlerPtr> > next(new std::vector<GroupPutHandlerPtr>);
+    if(groupPut->handlers) {
+        const std::vector<GroupPutHandlerPtr>& prev = *groupPut->handlers;
+        if(std::find(prev.begin(), prev.end(), handler)!=prev.end())
+            return;
+        next->reserve(prev.size()+1);
+        next->insert(next->end(), prev.begin(), prev.end());
+    }
+    next->push_back(handler);
+    groupPut->handlers = next;
+    updateTracker();
+}
+
+void PVStructure::removeGroupPutHandler(GroupPutHandlerPtr const &handler)
+{
+    if(!groupPut || !groupPut->handlers)
+        return;
+    const std::vector<GroupPutHandlerPtr>& prev = *groupPut->handlers;
+    std::vector<GroupPutHandlerPtr>::const_iterator it(std::find(prev.begin(), prev.end(), handler));
+    if(it==prev.end())
+        return;
+    if(prev.size()==1) {
+        groupPut->handlers.reset();
+    } else {
+        std::tr1::shared_ptr<std::vector<GroupPutHandlerPtr> > next(new std::vector<GroupPutHandlerPtr>);
+        next->reserve(prev.size()-1);
+        next->insert(next->end(), prev.begin(), it);
+        next->insert(next->end(), it+1, prev.end());
+        groupPut->handlers = next;
+    }
+    updateTracker();
+}
+
+void PVStructure::takeChanges(BitSet& changed)
+{
+    if(changes) {
+        // exchange storage, so neither BitSet re-allocates once both have grown
+        changed.swap(*changes);
+        changes->clear();
+    } else {
+        changed.clear();
+    }
+}
 
 }}
@@ -29,6 +29,91 @@ int32 PVUnion::UNDEFINED_INDEX = PVUNION_UNDEFINED_INDEX;
 
 PVDataCreatePtr PVUnion::pvDataCreate(getPVDataCreate());
 
+size_t PVUnion::memberCacheLimit = 4;
+
+namespace {
+
+// swap() does not call postPut()
+template<typename A>
+void clearArray(A& field)
+{
+    typename A::const_svector empty;
+    field.swap(empty);
+}
+
+template<typename T>
+void releaseArray(PVScalarArray& field)
+{
+    clearArray(static_cast<PVValueArray<T>&>(field));
+}
+
+// posts nothing, as a reusable member has no PostHandlers or tracker
+template<typename T>
+void resetScalar(PVScalar& field)
+{
+    static_cast<PVScalarValue<T>&>(field).put(T());
+}
+
+// reset a cached member to the values of a new one, dropping strings and arrays
+void releaseValues(PVField& field)
+{
+    switch(field.getField()->getType()) {
+    case scalar: {
+        PVScalar& sca = static_cast<PVScalar&>(field);
+        switch(sca.getScalar()->getScalarType()) {
+        case pvBoolean: resetScalar<boolean>(sca); break;
+        case pvByte:    resetScalar<int8>(sca); break;
+        case pvShort:   resetScalar<int16>(sca); break;
+        case pvInt:     resetScalar<int32>(sca); break;
+        case pvLong:    resetScalar<int64>(sca); break;
+        case pvUByte:   resetScalar<uint8>(sca); break;
+        case pvUShort:  resetScalar<uint16>(sca); break;
+        case pvUInt:    resetScalar<uint32>(sca); break;
+        case pvULong:   resetScalar<uint64>(sca); break;
+        case pvFloat:   resetScalar<float>(sca); break;
+        case pvDouble:  resetScalar<double>(sca); break;
+        case pvString:  resetScalar<string>(sca); break;
+        }
+        break;
+    }
+    case scalarArray: {
+        PVScalarArray& arr = static_cast<PVScalarArray&>(field);
+        switch(arr.getScalarArray()->getElementType()) {
+        case pvBoolean: releaseArray<boolean>(arr); break;
+        case pvByte:    releaseArray<int8>(arr); break;
+        case pvShort:   releaseArray<int16>(arr); break;
+        case pvInt:     releaseArray<int32>(arr); break;
+        case pvLong:    releaseArray<int64>(arr); break;
+        case pvUByte:   releaseArray<uint8>(arr); break;
+        case pvUShort:  releaseArray<uint16>(arr); break;
+        case pvUInt:    releaseArray<uint32>(arr); break;
+        case pvULong:   releaseArray<uint64>(arr); break;
+        case pvFloat:   releaseArray<float>(arr); break;
+        case pvDouble:  releaseArray<double>(arr); break;
+        case pvString:  releaseArray<string>(arr); break;
+        }
+        break;
+    }
+    case structure: {
+        const PVFieldPtrArray& fields = static_cast<PVStructure&>(field).getPVFields();
+        for(size_t i=0; i<fields.size(); i++)
+            releaseValues(*fields[i]);
+        break;
+    }
+    case structureArray:
+        clearArray(static_cast<PVStructureArray&>(field));
+        break;
+    case union_:
+        static_cast<PVUnion&>(field).select(PVUnion::UNDEFINED_INDEX);
+        break;
+    case unionArray:
+        clearArray(static_cast<PVUnionArray&>(field));
+        break;
+    }
+}
+
+} // namespace
+
 PVUnion::PVUnion(UnionConstPtr const & unionPtr)
 : PVField(unionPtr),
   unionPtr(unionPtr),
@@ -44,6 +129,56 @@ PVUnion::~PVUnion()
 {
 }
 
+void PVUnion::setMemberCacheSize(size_t entries)
+{
+    memberCacheLimit = entries;
+}
+
+size_t PVUnion::memberCacheSize()
+{
+    return memberCacheLimit;
+}
+
+bool PVUnion::reusable(const PVFieldPtr& field)
+{
+    // tracker is set while a structure tracks changes, has GroupPutHandlers or is in a group put
+    if(!field.unique() || field->isImmutable() || field->postHandlers || field->tracker)
+        return false;
+    if(field->getField()->getType()==structure) {
+        const PVFieldPtrArray& fields = static_cast<PVStructure&>(*field).getPVFields();
+        for(size_t i=0; i<fields.size(); i++)
+            if(!reusable(fields[i]))
+                return false;
+    }
+    return true;
+}
+
+void PVUnion::stash(PVFieldPtr& member)
+{
+    // members with PostHandlers or change tracking are not handed out again
+    if(member && memberCacheLimit && reusable(member)) {
+        releaseValues(*member);
+        while(memberCache.size()>=memberCacheLimit)
+            memberCache.erase(memberCache.begin());
+        memberCache.push_back(member);
+    }
+    member.reset();
+}
+
+PVFieldPtr PVUnion::take(FieldConstPtr const & field)
+{
+    for(size_t i=memberCache.size(); i>0; i--) {
+        PVFieldPtr& cached = memberCache[i-1];
+        if(cached->getField().get()==field.get() && cached.unique()) {
+            PVFieldPtr ret;
+            ret.swap(cached);
+            memberCache.erase(memberCache.begin()+(i-1));
+            return ret;
+        }
+    }
+    return pvDataCreate->createPVField(field);
+}
+
 UnionConstPtr PVUnion::getUnion() const
 {
     return unionPtr;
@@ -77,7 +212,7 @@ PVFieldPtr PVUnion::select(int32 index)
     if (index == UNDEFINED_INDEX)
     {
         selector = UNDEFINED_INDEX;
-        value.reset();
+        stash(value);
         return value;
     }
     else if (variant)
@@ -87,7 +222,8 @@ PVFieldPtr PVUnion::select(int32 index)
 
     FieldConstPtr field = unionPtr->getField(index);
     selector = index;
-    value = pvDataCreate->createPVField(field);
+    stash(value);
+    value = take(field);
 
     return value;
 }
@@ -126,7 +262,12 @@ void PVUnion::set(int32 index, PVFieldPtr const & value)
     }
 
     selector = index;
-    this->value = value;
+    if (this->value != value)
+    {
+        PVFieldPtr previous(value);
+        previous.swap(this->value);
+        stash(previous);
+    }
     postPut();
 }
 
@@ -171,11 +312,14 @@ void PVUnion::deserialize(ByteBuffer *pbuffer, DeserializableControl *pcontrol)
         {
             // try to reuse existing field instance
             if (!value.get() || *value->getField() != *field)
-                value = pvDataCreate->createPVField(field);
+            {
+                stash(value);
+                value = take(field);
+            }
             value->deserialize(pbuffer, pcontrol);
         }
         else
-            value.reset();
+            stash(value);
     }
     else
     {
@@ -188,13 +332,17 @@ void PVUnion::deserialize(ByteBuffer *pbuffer, DeserializableControl *pcontrol)
                 FieldConstPtr field = unionPtr->getField(selector);
                 // try to reuse existing field instance
                 if (!value.get() || *value->getField() != *field)
-                    value = pvDataCreate->createPVField(field);
+                {
+                    stash(value);
+                    value = take(field);
+                }
             }
             value->deserialize(pbuffer, pcontrol);
         }
         else
-            value.reset();
+            stash(value);
     }
+    markChanged();
 }
 
 std::ostream& PVUnion::dumpValue(std::ostream& o) const
@@ -243,7 +391,8 @@ void PVUnion::copyUnchecked(const PVUnion& from)
             PVFieldPtr toValue = get();
             if (toValue.get() == 0 || *toValue->getField() != *fromValue->getField())
             {
-                toValue = pvDataCreate->createPVField(fromValue->getField());
+                toValue.reset();
+                toValue = take(fromValue->getField());
                 toValue->copyUnchecked(*fromValue);
                 set(toValue);
             }
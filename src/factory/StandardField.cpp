@@ -647,7 +647,7 @@ StructureConstPtr StandardField::enumeratedAlarm()
 StandardFieldPtr StandardField::getStandardField()
 {
     static StandardFieldPtr standardFieldCreate;
-    static Mutex mutex;
+    static NamedMutex mutex("StandardField");
     Lock xx(mutex);
 
     if(standardFieldCreate.get()==0)
@@ -5,9 +5,15 @@
  */
  
 #include <deque>
+#include <cstdio>
+
+#include <epicsMath.h>
 
 #define epicsExportSharedSymbols
 #include <pv/pvIntrospect.h>
+#include <pv/pvData.h>
+#include <pv/typeCast.h>
+#include <pv/pvPrinter.h>
 
 using std::string;
 
@@ -41,4 +47,348 @@ namespace format
 	}
 };
 
+namespace {
+
+struct Printer {
+    string& out;
+    bool json;
+    size_t maxElements, maxDepth;
+
+    Printer(string& out, bool json, size_t maxElements, size_t maxDepth)
+        :out(out), json(json), maxElements(maxElements), maxDepth(maxDepth)
+    {}
+
+    void indent(unsigned level)
+    {
+        out.append(size_t(level)*4u, ' ');
+    }
+
+    template<typename T>
+    void number(T val)
+    {
+        char buf[detail::formatPODSize];
+        out.append(buf, detail::formatPOD(buf, val) - buf);
+    }
+
+    // JSON numbers keep all digits, and have no NaN or Inf
+    void jsonNumber(double val, int digits)
+    {
+        if(!finite(val)) {
+            out += "null";
+            return;
+        }
+        char buf[32];
+        int n = snprintf(buf, sizeof(buf), "%.*g", digits, val);
+        out.append(buf, n>0 && n<int(sizeof(buf)) ? size_t(n) : 0u);
+    }
+
+    void value(boolean val) { number(val); }
+    void value(int8 val) { number(val); }
+    void value(uint8 val) { number(val); }
+    void value(int16 val) { number(val); }
+    void value(uint16 val) { number(val); }
+    void value(int32 val) { number(val); }
+    void value(uint32 val) { number(val); }
+    void value(int64 val) { number(val); }
+    void value(uint64 val) { number(val); }
+    void value(float val) { if(json) jsonNumber(val, 9); else number(val); }
+    void value(double val) { if(json) jsonNumber(val, 17); else number(val); }
+    void value(const string& val)
+    {
+        if(json)
+            quote(val);
+        else
+            out += val;
+    }
+
+    void quote(const string& val)
+    {
+        static const char hex[] = "0123456789abcdef";
+        out += '"';
+        const char *s = val.c_str(), *e = s + val.size(), *run = s;
+        for(; s!=e; s++) {
+            unsigned char c = *s;
+            if(c>=0x20 && c!='"' && c!='\\')
+                continue;
+            out.append(run, s-run);
+            run = s+1;
+            switch(c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            default:
+                out += "\\u00";
+                out += hex[c>>4];
+                out += hex[c&0xf];
+            }
+        }
+        out.append(run, s-run);
+        out += '"';
+    }
+
+    template<typename T>
+    void scalarT(const PVScalar& field)
+    {
+        value(static_cast<const PVScalarValue<T>&>(field).get());
+    }
+
+    template<typename T>
+    void arrayT(const PVScalarArray& field)
+    {
+        typename PVValueArray<T>::const_svector V(static_cast<const PVValueArray<T>&>(field).view());
+        size_t n = V.size();
+        bool truncated = maxElements && n>maxElements;
+        if(truncated)
+            n = maxElements;
+        out += '[';
+        for(size_t i=0; i<n; i++) {
+            if(i)
+                out += ',';
+            value(V[i]);
+        }
+        if(truncated && !json)
+            out += n ? ",..." : "...";
+        out += ']';
+    }
+
+    void printScalar(const PVScalar& field)
+    {
+        switch(field.getScalar()->getScalarType()) {
+#define CASE(ENUM, TYPE) case ENUM: scalarT<TYPE>(field); break
+        CASE(pvBoolean, boolean);
+        CASE(pvByte, int8);
+        CASE(pvShort, int16);
+        CASE(pvInt, int32);
+        CASE(pvLong, int64);
+        CASE(pvUByte, uint8);
+        CASE(pvUShort, uint16);
+        CASE(pvUInt, uint32);
+        CASE(pvULong, uint64);
+        CASE(pvFloat, float);
+        CASE(pvDouble, double);
+        CASE(pvString, string);
+#undef CASE
+        }
+    }
+
+    void printArray(const PVScalarArray& field)
+    {
+        switch(field.getScalarArray()->getElementType()) {
+#define CASE(ENUM, TYPE) case ENUM: arrayT<TYPE>(field); break
+        CASE(pvBoolean, boolean);
+        CASE(pvByte, int8);
+        CASE(pvShort, int16);
+        CASE(pvInt, int32);
+        CASE(pvLong, int64);
+        CASE(pvUByte, uint8);
+        CASE(pvUShort, uint16);
+        CASE(pvUInt, uint32);
+        CASE(pvULong, uint64);
+        CASE(pvFloat, float);
+        CASE(pvDouble, double);
+        CASE(pvString, string);
+#undef CASE
+        }
+    }
+
+    bool expand(size_t depth) const
+    {
+        return !maxDepth || depth<maxDepth;
+    }
+
+    // text output, as the dumpValue() methods
+
+    void textHeader(const PVField& field, unsigned level)
+    {
+        indent(level);
+        out += field.getField()->getID();
+        out += ' ';
+        out += field.getFieldName();
+        out += '\n';
+    }
+
+    void textMember(const PVField& field, size_t depth, unsigned level)
+    {
+        Type type = field.getField()->getType();
+        if(type==scalar || type==scalarArray) {
+            indent(level);
+            out += field.getField()->getID();
+            out += ' ';
+            out += field.getFieldName();
+            out += ' ';
+            textValue(field, depth, level);
+            out += '\n';
+        } else {
+            textValue(field, depth, level);
+        }
+    }
+
+    template<typename A>
+    void textElements(const A& field, size_t depth, unsigned level)
+    {
+        typename A::const_svector V(field.view());
+        size_t n = V.size();
+        if(maxElements && n>maxElements)
+            n = maxElements;
+        for(size_t i=0; i<n; i++) {
+            if(V[i])
+                textValue(*V[i], depth+1, level+1);
+            else {
+                indent(level+1);
+                out += "(none)\n";
+            }
+        }
+        if(n<V.size()) {
+            indent(level+1);
+            out += "...\n";
+        }
+    }
+
+    void textValue(const PVField& field, size_t depth, unsigned level)
+    {
+        switch(field.getField()->getType()) {
+        case scalar:
+            printScalar(static_cast<const PVScalar&>(field));
+            break;
+        case scalarArray:
+            printArray(static_cast<const PVScalarArray&>(field));
+            break;
+        case structure: {
+            const PVStructure& S = static_cast<const PVStructure&>(field);
+            textHeader(S, level);
+            if(!expand(depth)) {
+                indent(level+1);
+                out += "...\n";
+                break;
+            }
+            const PVFieldPtrArray& fields = S.getPVFields();
+            for(size_t i=0, N=fields.size(); i<N; i++)
+                textMember(*fields[i], depth+1, level+1);
+        }
+            break;
+        case union_: {
+            const PVUnion& U = static_cast<const PVUnion&>(field);
+            textHeader(U, level);
+            PVField::const_shared_pointer member(U.get());
+            if(!member) {
+                indent(level+1);
+                out += "(none)\n";
+            } else if(!expand(depth)) {
+                indent(level+1);
+                out += "...\n";
+            } else {
+                textMember(*member, depth+1, level+1);
+            }
+        }
+            break;
+        case structureArray:
+            textHeader(field, level);
+            textElements(static_cast<const PVStructureArray&>(field), depth, level);
+            break;
+        case unionArray:
+            textHeader(field, level);
+            textElements(static_cast<const PVUnionArray&>(field), depth, level);
+            break;
+        }
+    }
+
+    // JSON output
+
+    template<typename A>
+    void jsonElements(const A& field, size_t depth)
+    {
+        typename A::const_svector V(field.view());
+        size_t n = V.size();
+        if(maxElements && n>maxElements)
+            n = maxElements;
+        out += '[';
+        for(size_t i=0; i<n; i++) {
+            if(i)
+                out += ',';
+            if(V[i])
+                jsonValue(*V[i], depth+1);
+            else
+                out += "null";
+        }
+        out += ']';
+    }
+
+    void jsonValue(const PVField& field, size_t depth)
+    {
+        switch(field.getField()->getType()) {
+        case scalar:
+            printScalar(static_cast<const PVScalar&>(field));
+            break;
+        case scalarArray:
+            printArray(static_cast<const PVScalarArray&>(field));
+            break;
+        case structure: {
+            out += '{';
+            if(expand(depth)) {
+                const PVFieldPtrArray& fields = static_cast<const PVStructure&>(field).getPVFields();
+                for(size_t i=0, N=fields.size(); i<N; i++) {
+                    if(i)
+                        out += ',';
+                    quote(fields[i]->getFieldName());
+                    out += ':';
+                    jsonValue(*fields[i], depth+1);
+                }
+            }
+            out += '}';
+        }
+            break;
+        case union_: {
+            PVField::const_shared_pointer member(static_cast<const PVUnion&>(field).get());
+            if(member && expand(depth))
+                jsonValue(*member, depth+1);
+            else
+                out += "null";
+        }
+            break;
+        case structureArray:
+            jsonElements(static_cast<const PVStructureArray&>(field), depth);
+            break;
+        case unionArray:
+            jsonElements(static_cast<const PVUnionArray&>(field), depth);
+            break;
+        }
+    }
+};
+
+} // namespace
+
+PVPrinter::PVPrinter()
+    :m_format(text)
+    ,m_maxElements(0)
+    ,m_maxDepth(0)
+    ,m_indent(0)
+{}
+
+void PVPrinter::print(std::string& out, const PVField& field) const
+{
+    Printer P(out, m_format==json, m_maxElements, m_maxDepth);
+    if(m_format==json)
+        P.jsonValue(field, 0);
+    else
+        P.textValue(field, 0, m_indent);
+}
+
+std::ostream& PVPrinter::print(std::ostream& strm, const PVField& field) const
+{
+    string temp;
+    print(temp, field);
+    return strm.write(temp.data(), temp.size());
+}
+
+std::string PVPrinter::toString(const PVField& field) const
+{
+    string ret;
+    print(ret, field);
+    return ret;
+}
+
 }}
@@ -0,0 +1,126 @@
+/* pvSerializedUpdate.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <stdexcept>
+#include <algorithm>
+
+#define epicsExportSharedSymbols
+#include <pv/pvData.h>
+#include <pv/pvSerializedUpdate.h>
+
+namespace epics { namespace pvData {
+
+namespace {
+
+/* Serializes through a small bounce buffer, which is flushed
+ * to the end of a growing shared_vector.
+ */
+struct BlockBuilder : public SerializableControl
+{
+    std::vector<char> scratch;
+    ByteBuffer buffer;
+    shared_vector<char> out;
+
+    explicit BlockBuilder(int byteOrder)
+        :scratch(16*1024)
+        ,buffer(&scratch[0], scratch.size(), byteOrder)
+    {}
+    virtual ~BlockBuilder() {}
+
+    void append(const char *bytes, size_t count)
+    {
+        size_t N = out.size();
+        out.resize_amortized(N+count);
+        std::copy(bytes, bytes+count, out.begin()+N);
+    }
+
+    virtual void flushSerializeBuffer()
+    {
+        append(buffer.getBuffer(), buffer.getPosition());
+        buffer.clear();
+    }
+
+    virtual void ensureBuffer(std::size_t size)
+    {
+        flushSerializeBuffer();
+    }
+
+    virtual void alignBuffer(std::size_t alignment)
+    {
+        if(buffer.getRemaining()<alignment)
+            flushSerializeBuffer();
+        buffer.align(alignment);
+    }
+
+    virtual bool directSerialize(ByteBuffer *existingBuffer, const char* toSerialize,
+                                 std::size_t elementCount, std::size_t elementSize)
+    {
+        // only called when no byte swapping is needed
+        flushSerializeBuffer();
+        append(toSerialize, elementCount*elementSize);
+        return true;
+    }
+
+    virtual void cachedSerialize(std::tr1::shared_ptr<const Field> const & field, ByteBuffer* buffer)
+    {
+        field->serialize(buffer, this);
+    }
+
+    // bytes written so far
+    size_t mark() const { return out.size() + buffer.getPosition(); }
+};
+
+} // namespace
+
+SerializedUpdate::SerializedUpdate(const PVStructure& value,
+                                   const BitSet& changed,
+                                   const BitSet& overrun,
+                                   int byteOrder)
+    :m_byteOrder(byteOrder)
+{
+    // all three encodings share one allocation
+    BlockBuilder B(byteOrder);
+    changed.serialize(&B.buffer, &B);
+    value.serialize(&B.buffer, &B, const_cast<BitSet*>(&changed));
+    size_t changedEnd = B.mark();
+    overrun.serialize(&B.buffer, &B);
+    size_t overrunEnd = B.mark();
+    BitSet().serialize(&B.buffer, &B);
+    B.flushSerializeBuffer();
+
+    block_t all(freeze(B.out));
+    m_changed = m_overrun = m_noOverrun = all;
+    m_changed.slice(0, changedEnd);
+    m_overrun.slice(changedEnd, overrunEnd-changedEnd);
+    m_noOverrun.slice(overrunEnd);
+}
+
+void SerializedUpdate::serialize(ByteBuffer *buffer, SerializableControl *control, bool overrun) const
+{
+    if(buffer->reverse<int32>() != (m_byteOrder!=EPICS_BYTE_ORDER))
+        throw std::logic_error("SerializedUpdate byte order does not match buffer");
+
+    const block_t* blocks[2] = {&m_changed, &getOverrun(overrun)};
+    for(unsigned b=0; b<2; b++) {
+        const char *bytes = blocks[b]->data();
+        size_t count = blocks[b]->size();
+
+        if(count>buffer->getRemaining() && control->directSerialize(buffer, bytes, count, 1))
+            continue;
+
+        while(true) {
+            size_t n = std::min(count, buffer->getRemaining());
+            buffer->put(bytes, 0, n);
+            bytes += n;
+            count -= n;
+            if(count==0)
+                break;
+            control->flushSerializeBuffer();
+        }
+    }
+}
+
+}}
@@ -9,9 +9,11 @@
 #include <string>
 #include <stdexcept>
 #include <memory>
+#include <algorithm>
 
 #define epicsExportSharedSymbols
 #include <pv/pvSubArrayCopy.h>
+#include <pv/arrayKernels.h>
 
 using std::cout;
 using std::endl;
@@ -19,6 +21,23 @@ using std::string;
 
 namespace epics { namespace pvData { 
 
+namespace {
+
+// memcpy(), vectorized and multi-threaded for large arrays.  See arrayKernels.h
+template<typename T>
+void copyElements(T *to, size_t toStride, const T *from, size_t fromStride, size_t count)
+{
+    detail::arrayStridedCopy((ScalarType)ScalarTypeID<T>::value, to, toStride,
+                             from, fromStride, count);
+}
+
+void copyElements(string *to, size_t toStride, const string *from, size_t fromStride, size_t count)
+{
+    for(size_t i=0; i<count; ++i) to[i*toStride] = from[i*fromStride];
+}
+
+} // namespace
+
 template<typename T>
 void copy(
     PVValueArray<T> & pvFrom,
@@ -37,12 +56,36 @@ void copy(
     size_t newLength = toOffset + count*toStride;
     size_t capacity = pvTo.getCapacity();
     if(newLength>capacity) capacity = newLength;
-    shared_vector<T> temp(capacity);
+    size_t length = pvTo.getLength();
+    // as replace() would, but before pvTo is modified
+    ArrayConstPtr array(pvTo.getArray());
+    if(array->getArraySizeType()==Array::fixed && capacity!=array->getMaximumCapacity())
+        throw std::invalid_argument("invalid length for a fixed size array");
+    else if(array->getArraySizeType()==Array::bounded && capacity>array->getMaximumCapacity())
+        throw std::invalid_argument("new array capacity too large for a bounded size array");
     typename PVValueArray<T>::const_svector vecFrom = pvFrom.view();
-    typename PVValueArray<T>::const_svector vecTo = pvTo.view();
-    for(size_t i=0; i<pvTo.getLength(); ++i) temp[i] = vecTo[i];
-    for(size_t i=pvTo.getLength(); i< capacity; ++i) temp[i] = T();
-    for(size_t i=0; i<count; ++i) temp[i*toStride + toOffset] = vecFrom[i*fromStride+fromOffset];
+    // Take the array from pvTo.  When nothing else references it
+    // (including pvFrom) it is modified in place without a copy.
+    typename PVValueArray<T>::const_svector vecTo;
+    pvTo.swap(vecTo);
+    shared_vector<T> temp;
+    try {
+        temp = thaw(vecTo);
+        temp.resize(capacity);
+    } catch(...) {
+        if(!vecTo.dataPtr())
+            vecTo = freeze(temp);
+        pvTo.swap(vecTo);
+        throw;
+    }
+    if(toStride==1 && toOffset<=length) {
+        // elements which are about to be overwritten need not be cleared
+        std::fill(temp.begin()+std::max(length, newLength), temp.end(), T());
+    } else {
+        std::fill(temp.begin()+length, temp.end(), T());
+    }
+    if(count>0)
+        copyElements(temp.data()+toOffset, toStride, vecFrom.data()+fromOffset, fromStride, count);
     shared_vector<const T> temp2(freeze(temp));
     pvTo.replace(temp2);
 }
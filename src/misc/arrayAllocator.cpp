@@ -0,0 +1,258 @@
+/* arrayAllocator.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+#if defined(__linux__)
+#  include <sys/mman.h>
+#  define HAVE_HUGEPAGE_MMAP
+#endif
+#ifdef _WIN32
+#  include <malloc.h>
+#endif
+
+#define epicsExportSharedSymbols
+#include <pv/arrayAllocator.h>
+#include <pv/byteBuffer.h>
+
+namespace epics { namespace pvData {
+
+namespace {
+
+// slot per ScalarType, then the default
+enum { defaultSlot = pvString+1, numSlots };
+
+#if defined(__GNUC__) || defined(__clang__)
+// Looked up for every allocation, so avoid taking a lock
+ArrayAllocator *slots[numSlots];
+
+inline ArrayAllocator* loadSlot(int i) { return __atomic_load_n(&slots[i], __ATOMIC_ACQUIRE); }
+inline void storeSlot(int i, ArrayAllocator *A) { __atomic_store_n(&slots[i], A, __ATOMIC_RELEASE); }
+#else
+ArrayAllocator *slots[numSlots];
+Mutex slotLock;
+
+inline ArrayAllocator* loadSlot(int i)
+{
+    Lock G(slotLock);
+    return slots[i];
+}
+inline void storeSlot(int i, ArrayAllocator *A)
+{
+    Lock G(slotLock);
+    slots[i] = A;
+}
+#endif
+
+void install(int slot, const ArrayAllocator::shared_pointer& alloc)
+{
+    // never destroyed, see class documentation
+    static Mutex *lock = new Mutex;
+    static std::vector<ArrayAllocator::shared_pointer> *installed = new std::vector<ArrayAllocator::shared_pointer>;
+
+    Lock G(*lock);
+    if(alloc)
+        installed->push_back(alloc);
+    storeSlot(slot, alloc.get());
+}
+
+} // namespace
+
+ArrayAllocator::~ArrayAllocator() {}
+
+void ArrayAllocator::setDefault(const shared_pointer& alloc)
+{
+    install(defaultSlot, alloc);
+}
+
+void ArrayAllocator::set(ScalarType type, const shared_pointer& alloc)
+{
+    if(type<pvBoolean || type>=pvString)
+        throw std::invalid_argument("ArrayAllocator::set() only for numeric types and pvBoolean");
+    install(type, alloc);
+}
+
+ArrayAllocator* ArrayAllocator::getDefault()
+{
+    return loadSlot(defaultSlot);
+}
+
+ArrayAllocator* ArrayAllocator::get(ScalarType type)
+{
+    ArrayAllocator *ret = loadSlot(type);
+    return ret ? ret : loadSlot(defaultSlot);
+}
+
+AlignedAllocator::AlignedAllocator(std::size_t alignment,
+                                   std::size_t hugePageThreshold,
+                                   std::size_t poolBytes,
+                                   std::size_t maxPooledBlock)
+    :alignment(alignment)
+    ,hugePageThreshold(hugePageThreshold)
+    ,poolBytes(poolBytes)
+    ,maxPooledBlock(maxPooledBlock)
+{
+    if(alignment<sizeof(void*) || (alignment&(alignment-1)))
+        throw std::invalid_argument("AlignedAllocator alignment must be a power of 2 and at least sizeof(void*)");
+    counters.poolHits = counters.poolMisses = 0;
+    counters.hugePageAllocations = counters.pooledBytes = 0;
+}
+
+AlignedAllocator::~AlignedAllocator()
+{
+    trim();
+}
+
+// index of the pool for this request, or -1 if not pooled
+int AlignedAllocator::sizeClass(std::size_t bytes) const
+{
+    if(!poolBytes || bytes>maxPooledBlock)
+        return -1;
+    int i = 0;
+    while((std::size_t(1)<<i) < bytes || (std::size_t(1)<<i) < alignment)
+        i++;
+    return i;
+}
+
+void* AlignedAllocator::allocateAligned(std::size_t bytes)
+{
+    if(bytes==0)
+        bytes = alignment;
+    void *ret;
+#ifdef _WIN32
+    ret = _aligned_malloc(bytes, alignment);
+    if(!ret)
+        throw std::bad_alloc();
+#else
+    if(posix_memalign(&ret, alignment, bytes))
+        throw std::bad_alloc();
+#endif
+    return ret;
+}
+
+static void freeAligned(void *ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+void* AlignedAllocator::allocate(std::size_t bytes)
+{
+#ifdef HAVE_HUGEPAGE_MMAP
+    if(hugePageThreshold && bytes>=hugePageThreshold) {
+        const std::size_t huge = hugePageSize;
+        if(bytes > ((std::size_t)-1) - 2*huge)
+            throw std::bad_alloc();
+        std::size_t len = (bytes+huge-1)&~(huge-1);
+        // over map so that the block can be trimmed to start on a 2MB boundary
+        char *raw = (char*)mmap(0, len+huge, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if(raw==MAP_FAILED)
+            throw std::bad_alloc();
+        char *ret = (char*)(((std::size_t)raw+huge-1)&~(huge-1));
+        if(ret!=raw)
+            munmap(raw, ret-raw);
+        munmap(ret+len, raw+huge-ret);
+#ifdef MADV_HUGEPAGE
+        (void)madvise(ret, len, MADV_HUGEPAGE);
+#endif
+        Lock G(mutex);
+        counters.hugePageAllocations++;
+        return ret;
+    }
+#endif
+
+    int cls = sizeClass(bytes);
+    if(cls<0)
+        return allocateAligned(bytes);
+    {
+        Lock G(mutex);
+        if(!pool[cls].empty()) {
+            void *ret = pool[cls].back();
+            pool[cls].pop_back();
+            counters.pooledBytes -= std::size_t(1)<<cls;
+            counters.poolHits++;
+            return ret;
+        }
+        counters.poolMisses++;
+    }
+    return allocateAligned(std::size_t(1)<<cls);
+}
+
+void AlignedAllocator::deallocate(void *ptr, std::size_t bytes)
+{
+    if(!ptr)
+        return;
+#ifdef HAVE_HUGEPAGE_MMAP
+    if(hugePageThreshold && bytes>=hugePageThreshold) {
+        const std::size_t huge = hugePageSize;
+        munmap(ptr, (bytes+huge-1)&~(huge-1));
+        return;
+    }
+#endif
+
+    int cls = sizeClass(bytes);
+    if(cls>=0) {
+        std::size_t blockSize = std::size_t(1)<<cls;
+        Lock G(mutex);
+        if(counters.pooledBytes+blockSize <= poolBytes) {
+            try {
+                pool[cls].push_back(ptr);
+                counters.pooledBytes += blockSize;
+                return;
+            } catch(std::bad_alloc&) {
+                // fall through and free
+            }
+        }
+    }
+    freeAligned(ptr);
+}
+
+AlignedAllocator::Stats AlignedAllocator::stats() const
+{
+    Lock G(mutex);
+    return counters;
+}
+
+void AlignedAllocator::trim()
+{
+    Lock G(mutex);
+    for(int i=0; i<numClasses; i++) {
+        for(size_t j=0; j<pool[i].size(); j++)
+            freeAligned(pool[i][j]);
+        pool[i].clear();
+    }
+    counters.pooledBytes = 0;
+}
+
+namespace detail {
+
+char* allocateByteBuffer(ArrayAllocator*& alloc, std::size_t size)
+{
+    alloc = ArrayAllocator::getDefault();
+    if(!alloc)
+        return (char*)std::malloc(size);
+    try {
+        return (char*)alloc->allocate(size);
+    } catch(std::bad_alloc&) {
+        return 0;
+    }
+}
+
+void freeByteBuffer(ArrayAllocator *alloc, char *buffer, std::size_t size)
+{
+    if(alloc)
+        alloc->deallocate(buffer, size);
+    else
+        std::free(buffer);
+}
+
+} // namespace detail
+
+}}
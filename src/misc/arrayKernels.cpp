@@ -0,0 +1,670 @@
+/* arrayKernels.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#define epicsExportSharedSymbols
+#include <pv/arrayKernels.h>
+#include <pv/typeCast.h>
+#include <pv/lock.h>
+#include <pv/event.h>
+#include <pv/thread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(__AVX2__) \
+    && (defined(__clang__) || __GNUC__*100+__GNUC_MINOR__>=409)
+#  define KERNELS_AVX2
+#endif
+
+#ifdef KERNELS_AVX2
+#  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+namespace epics { namespace pvData {
+
+namespace {
+
+// Elements of other types are converted to double in blocks of this many
+enum { blockSize = 512 };
+
+struct Partial {
+    double min, max, sum, sumOfSquares;
+    Partial()
+        :min(std::numeric_limits<double>::infinity())
+        ,max(-std::numeric_limits<double>::infinity())
+        ,sum(0.0), sumOfSquares(0.0)
+    {}
+    void merge(const Partial& o)
+    {
+        // o.min is never NaN
+        if(o.min<min) min = o.min;
+        if(o.max>max) max = o.max;
+        sum += o.sum;
+        sumOfSquares += o.sumOfSquares;
+    }
+};
+
+/* The statistics loops.  x<m ? x : m ignores NaN x, which is also
+ * the behaviour of the SSE MINPD instruction with x as first operand.
+ */
+void statsGeneric(const double *x, size_t n, Partial& P)
+{
+    double mn[4], mx[4], s[4], q[4];
+    for(unsigned k=0; k<4; k++) {
+        mn[k] = P.min;
+        mx[k] = P.max;
+        s[k] = q[k] = 0.0;
+    }
+    size_t i=0;
+    for(; i+4<=n; i+=4) {
+        for(unsigned k=0; k<4; k++) {
+            double v = x[i+k];
+            mn[k] = v<mn[k] ? v : mn[k];
+            mx[k] = v>mx[k] ? v : mx[k];
+            s[k] += v;
+            q[k] += v*v;
+        }
+    }
+    for(; i<n; i++) {
+        double v = x[i];
+        mn[0] = v<mn[0] ? v : mn[0];
+        mx[0] = v>mx[0] ? v : mx[0];
+        s[0] += v;
+        q[0] += v*v;
+    }
+    Partial R;
+    for(unsigned k=0; k<4; k++) {
+        R.min = std::min(R.min, mn[k]);
+        R.max = std::max(R.max, mx[k]);
+    }
+    R.sum = (s[0]+s[1]) + (s[2]+s[3]);
+    R.sumOfSquares = (q[0]+q[1]) + (q[2]+q[3]);
+    P.merge(R);
+}
+
+#ifdef __SSE2__
+void statsSSE2(const double *x, size_t n, Partial& P)
+{
+    __m128d mn0 = _mm_set1_pd(P.min), mn1 = mn0;
+    __m128d mx0 = _mm_set1_pd(P.max), mx1 = mx0;
+    __m128d s0 = _mm_setzero_pd(), s1 = s0, q0 = s0, q1 = s0;
+    size_t i=0;
+    for(; i+4<=n; i+=4) {
+        __m128d a = _mm_loadu_pd(x+i), b = _mm_loadu_pd(x+i+2);
+        mn0 = _mm_min_pd(a, mn0);
+        mn1 = _mm_min_pd(b, mn1);
+        mx0 = _mm_max_pd(a, mx0);
+        mx1 = _mm_max_pd(b, mx1);
+        s0 = _mm_add_pd(s0, a);
+        s1 = _mm_add_pd(s1, b);
+        q0 = _mm_add_pd(q0, _mm_mul_pd(a, a));
+        q1 = _mm_add_pd(q1, _mm_mul_pd(b, b));
+    }
+    double mn[4], mx[4], s[4], q[4];
+    _mm_storeu_pd(mn, mn0); _mm_storeu_pd(mn+2, mn1);
+    _mm_storeu_pd(mx, mx0); _mm_storeu_pd(mx+2, mx1);
+    _mm_storeu_pd(s, s0); _mm_storeu_pd(s+2, s1);
+    _mm_storeu_pd(q, q0); _mm_storeu_pd(q+2, q1);
+    Partial R;
+    for(unsigned k=0; k<4; k++) {
+        R.min = std::min(R.min, mn[k]);
+        R.max = std::max(R.max, mx[k]);
+    }
+    R.sum = (s[0]+s[2]) + (s[1]+s[3]);
+    R.sumOfSquares = (q[0]+q[2]) + (q[1]+q[3]);
+    P.merge(R);
+    statsGeneric(x+i, n-i, P);
+}
+#endif
+
+void affineLoop(double *d, const double *s, size_t n, double scale, double offset)
+{
+    for(size_t i=0; i<n; i++)
+        d[i] = s[i]*scale + offset;
+}
+
+#ifdef KERNELS_AVX2
+__attribute__((target("avx2")))
+void statsAVX2(const double *x, size_t n, Partial& P)
+{
+    __m256d mn0 = _mm256_set1_pd(P.min), mn1 = mn0;
+    __m256d mx0 = _mm256_set1_pd(P.max), mx1 = mx0;
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, q0 = s0, q1 = s0;
+    size_t i=0;
+    for(; i+8<=n; i+=8) {
+        __m256d a = _mm256_loadu_pd(x+i), b = _mm256_loadu_pd(x+i+4);
+        mn0 = _mm256_min_pd(a, mn0);
+        mn1 = _mm256_min_pd(b, mn1);
+        mx0 = _mm256_max_pd(a, mx0);
+        mx1 = _mm256_max_pd(b, mx1);
+        s0 = _mm256_add_pd(s0, a);
+        s1 = _mm256_add_pd(s1, b);
+        q0 = _mm256_add_pd(q0, _mm256_mul_pd(a, a));
+        q1 = _mm256_add_pd(q1, _mm256_mul_pd(b, b));
+    }
+    double mn[8], mx[8], s[8], q[8];
+    _mm256_storeu_pd(mn, mn0); _mm256_storeu_pd(mn+4, mn1);
+    _mm256_storeu_pd(mx, mx0); _mm256_storeu_pd(mx+4, mx1);
+    _mm256_storeu_pd(s, s0); _mm256_storeu_pd(s+4, s1);
+    _mm256_storeu_pd(q, q0); _mm256_storeu_pd(q+4, q1);
+    Partial R;
+    R.sum = R.sumOfSquares = 0.0;
+    for(unsigned k=0; k<8; k++) {
+        R.min = std::min(R.min, mn[k]);
+        R.max = std::max(R.max, mx[k]);
+        R.sum += s[k];
+        R.sumOfSquares += q[k];
+    }
+    P.merge(R);
+    statsGeneric(x+i, n-i, P);
+}
+
+__attribute__((target("avx2")))
+void affineAVX2(double *d, const double *s, size_t n, double scale, double offset)
+{
+    for(size_t i=0; i<n; i++)
+        d[i] = s[i]*scale + offset;
+}
+#endif
+
+typedef void (*statsfn)(const double *x, size_t n, Partial& P);
+typedef void (*affinefn)(double *d, const double *s, size_t n, double scale, double offset);
+
+struct Kernels {
+    const char *name;
+    statsfn stats;
+    affinefn affine;
+};
+
+const Kernels& selectKernels()
+{
+#ifdef KERNELS_AVX2
+    static const Kernels avx2 = {"avx2", &statsAVX2, &affineAVX2};
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return avx2;
+#endif
+#ifdef __SSE2__
+    static const Kernels sse2 = {"sse2", &statsSSE2, &affineLoop};
+    return sse2;
+#else
+    static const Kernels generic = {"generic", &statsGeneric, &affineLoop};
+    return generic;
+#endif
+}
+
+const Kernels& kernels()
+{
+    static const Kernels& K = selectKernels();
+    return K;
+}
+
+void checkNumeric(ScalarType type)
+{
+    if(type<pvByte || type>pvDouble)
+        throw std::invalid_argument("Array kernels support only numeric types");
+}
+
+/* Strided copy.  Small constant source strides (eg. binning or
+ * decimation) are written out so that the compiler vectorizes the
+ * loads with shuffles, which is faster than hardware gather.
+ */
+template<typename T>
+void stridedCopy(T *d, size_t dstride, const T *s, size_t sstride, size_t n)
+{
+    if(dstride==1) {
+        switch(sstride) {
+        case 1:
+            memcpy(d, s, n*sizeof(T));
+            return;
+        case 2:
+            for(size_t i=0; i<n; i++)
+                d[i] = s[2*i];
+            return;
+        case 3:
+            for(size_t i=0; i<n; i++)
+                d[i] = s[3*i];
+            return;
+        case 4:
+            for(size_t i=0; i<n; i++)
+                d[i] = s[4*i];
+            return;
+        default:
+            for(size_t i=0; i<n; i++)
+                d[i] = s[i*sstride];
+            return;
+        }
+    } else if(sstride==1) {
+        for(size_t i=0; i<n; i++)
+            d[i*dstride] = s[i];
+    } else {
+        for(size_t i=0; i<n; i++)
+            d[i*dstride] = s[i*sstride];
+    }
+}
+
+template<typename T>
+void stridedCopyV(void *dest, size_t dstride, const void *src, size_t sstride,
+                  size_t begin, size_t end)
+{
+    stridedCopy((T*)dest + begin*dstride, dstride,
+                (const T*)src + begin*sstride, sstride, end-begin);
+}
+
+// Process [begin, end) of one thread's share of the work
+struct Job {
+    virtual ~Job() {}
+    virtual void run(size_t begin, size_t end) = 0;
+};
+
+/* Pool of worker threads.  One job at a time, the caller takes part.
+ * Never destroyed, as worker threads may still be waiting at exit.
+ */
+class Pool {
+public:
+    Pool() :nthreads(1), threshold(ArrayKernels::defaultThreshold), job(0), next(0), remaining(0), failed(false) {}
+
+    void configure(unsigned threads, size_t thres)
+    {
+        Lock B(busy);
+        stopWorkers();
+        nthreads = 1;
+        threshold = thres;
+        for(unsigned i=1; i<threads; i++) {
+            Worker *W = new Worker(this);
+            workers.push_back(W);
+            W->thread = new Thread(Thread::Config(W, &Worker::run)
+                                   .prio(epicsThreadPriorityMedium)
+                                   <<"pvArrayKernel"<<i);
+            nthreads++;
+        }
+    }
+
+    unsigned threads()
+    {
+        Lock B(busy);
+        return nthreads;
+    }
+
+    // Split count elements into parts of at least 'align' elements
+    void execute(Job& J, size_t count, size_t align = blockSize)
+    {
+        if(!busy.tryLock()) {
+            J.run(0, count);
+            return;
+        }
+        if(count<threshold || nthreads<=1) {
+            busy.unlock();
+            J.run(0, count);
+            return;
+        }
+        {
+            Lock G(lock);
+            job = &J;
+            size_t chunk = (count + nthreads - 1)/nthreads;
+            chunk = (chunk + align - 1)/align*align;
+            parts.clear();
+            for(size_t b=0; b<count; b+=chunk)
+                parts.push_back(std::make_pair(b, std::min(count, b+chunk)));
+            next = 0;
+            remaining = parts.size();
+            failed = false;
+        }
+        for(size_t i=0; i<workers.size(); i++)
+            workers[i]->start.signal();
+        process();
+        while(true) {
+            {
+                Lock G(lock);
+                if(remaining==0)
+                    break;
+            }
+            done.wait();
+        }
+        bool fail;
+        {
+            Lock G(lock);
+            job = 0;
+            fail = failed;
+        }
+        busy.unlock();
+        if(fail)
+            throw std::runtime_error("Array kernel failed in worker thread");
+    }
+
+private:
+    struct Worker {
+        Pool *pool;
+        Event start;
+        bool stop;
+        Thread *thread;
+        explicit Worker(Pool *pool) :pool(pool), stop(false), thread(0) {}
+        void run()
+        {
+            while(true) {
+                start.wait();
+                if(stop)
+                    break;
+                pool->process();
+            }
+        }
+    };
+
+    void process()
+    {
+        while(true) {
+            std::pair<size_t, size_t> part;
+            Job *J;
+            {
+                Lock G(lock);
+                if(!job || next>=parts.size())
+                    return;
+                part = parts[next++];
+                J = job;
+            }
+            bool ok = true;
+            try {
+                J->run(part.first, part.second);
+            } catch(...) {
+                ok = false;
+            }
+            Lock G(lock);
+            if(!ok)
+                failed = true;
+            if(--remaining==0)
+                done.signal();
+        }
+    }
+
+    // call with busy locked
+    void stopWorkers()
+    {
+        for(size_t i=0; i<workers.size(); i++) {
+            workers[i]->stop = true;
+            workers[i]->start.signal();
+            delete workers[i]->thread; // joins
+            delete workers[i];
+        }
+        workers.clear();
+    }
+
+    Mutex busy; // held while a job runs, and protects members until 'lock'
+    unsigned nthreads;
+    size_t threshold;
+    std::vector<Worker*> workers;
+    Mutex lock; // protects members below
+    Event done;
+    Job *job;
+    std::vector<std::pair<size_t, size_t> > parts;
+    size_t next, remaining;
+    bool failed;
+};
+
+Pool& pool()
+{
+    static Pool *P = new Pool;
+    return *P;
+}
+
+// Call fn(block, n) for blocks of elements converted to double
+template<typename FN>
+void forEachBlock(ScalarType type, const void *src, size_t count, FN& fn)
+{
+    if(type==pvDouble) {
+        fn((const double*)src, count);
+        return;
+    }
+    const size_t esize = ScalarTypeFunc::elementSize(type);
+    double buf[blockSize];
+    for(size_t i=0; i<count; i+=blockSize) {
+        size_t n = std::min(count-i, (size_t)blockSize);
+        castUnsafeV(n, pvDouble, buf, type, (const char*)src + i*esize);
+        fn(buf, n);
+    }
+}
+
+struct StatsBlock {
+    statsfn stats;
+    Partial P;
+    StatsBlock() :stats(kernels().stats) {}
+    void operator()(const double *x, size_t n) { stats(x, n, P); }
+};
+
+struct StatsJob : public Job {
+    ScalarType type;
+    const char *src;
+    size_t esize;
+    Mutex lock;
+    Partial total;
+    StatsJob(ScalarType type, const void *src)
+        :type(type), src((const char*)src), esize(ScalarTypeFunc::elementSize(type)) {}
+    virtual void run(size_t begin, size_t end)
+    {
+        StatsBlock B;
+        forEachBlock(type, src + begin*esize, end-begin, B);
+        Lock G(lock);
+        total.merge(B.P);
+    }
+};
+
+struct AffineJob : public Job {
+    ScalarType dtype, stype;
+    char *dest;
+    const char *src;
+    size_t dsize, ssize;
+    double scale, offset;
+    AffineJob(ScalarType dtype, void *dest, ScalarType stype, const void *src,
+              double scale, double offset)
+        :dtype(dtype), stype(stype), dest((char*)dest), src((const char*)src)
+        ,dsize(ScalarTypeFunc::elementSize(dtype)), ssize(ScalarTypeFunc::elementSize(stype))
+        ,scale(scale), offset(offset)
+    {}
+    virtual void run(size_t begin, size_t end)
+    {
+        affinefn affine = kernels().affine;
+        double buf[blockSize];
+        for(size_t i=begin; i<end; i+=blockSize) {
+            size_t n = std::min(end-i, (size_t)blockSize);
+            const double *in;
+            if(stype==pvDouble) {
+                in = (const double*)(src + i*ssize);
+            } else {
+                castUnsafeV(n, pvDouble, buf, stype, src + i*ssize);
+                in = buf;
+            }
+            if(dtype==pvDouble) {
+                affine((double*)(dest + i*dsize), in, n, scale, offset);
+            } else {
+                affine(buf, in, n, scale, offset);
+                castUnsafeV(n, dtype, dest + i*dsize, pvDouble, buf);
+            }
+        }
+    }
+};
+
+struct ConvertJob : public Job {
+    ScalarType dtype, stype;
+    char *dest;
+    const char *src;
+    size_t dsize, ssize;
+    ConvertJob(ScalarType dtype, void *dest, ScalarType stype, const void *src)
+        :dtype(dtype), stype(stype), dest((char*)dest), src((const char*)src)
+        ,dsize(ScalarTypeFunc::elementSize(dtype)), ssize(ScalarTypeFunc::elementSize(stype))
+    {}
+    virtual void run(size_t begin, size_t end)
+    {
+        castUnsafeV(end-begin, dtype, dest + begin*dsize, stype, src + begin*ssize);
+    }
+};
+
+struct HistogramBlock {
+    uint64 *bins;
+    size_t nbins, counted;
+    double lo, factor;
+    HistogramBlock(uint64 *bins, size_t nbins, double lo, double hi)
+        :bins(bins), nbins(nbins), counted(0), lo(lo), factor(nbins/(hi-lo)) {}
+    void operator()(const double *x, size_t n)
+    {
+        const double top = double(nbins);
+        for(size_t i=0; i<n; i++) {
+            double f = (x[i]-lo)*factor;
+            // false for NaN
+            if(f>=0.0 && f<top) {
+                bins[size_t(f)]++;
+                counted++;
+            }
+        }
+    }
+};
+
+struct HistogramJob : public Job {
+    ScalarType type;
+    const char *src;
+    size_t esize, count;
+    uint64 *bins;
+    size_t nbins;
+    double lo, hi;
+    Mutex lock;
+    size_t counted;
+    HistogramJob(uint64 *bins, size_t nbins, double lo, double hi,
+                 ScalarType type, const void *src, size_t count)
+        :type(type), src((const char*)src), esize(ScalarTypeFunc::elementSize(type)), count(count)
+        ,bins(bins), nbins(nbins), lo(lo), hi(hi), counted(0)
+    {}
+    virtual void run(size_t begin, size_t end)
+    {
+        if(begin==0 && end==count) {
+            // not split, so count directly into bins
+            HistogramBlock B(bins, nbins, lo, hi);
+            forEachBlock(type, src, count, B);
+            counted = B.counted;
+            return;
+        }
+        std::vector<uint64> local(nbins, 0);
+        HistogramBlock B(&local[0], nbins, lo, hi);
+        forEachBlock(type, src + begin*esize, end-begin, B);
+        Lock G(lock);
+        for(size_t i=0; i<nbins; i++)
+            bins[i] += local[i];
+        counted += B.counted;
+    }
+};
+
+typedef void (*stridedfn)(void *dest, size_t dstride, const void *src, size_t sstride,
+                          size_t begin, size_t end);
+
+struct StridedCopyJob : public Job {
+    stridedfn fn;
+    void *dest;
+    size_t dstride;
+    const void *src;
+    size_t sstride;
+    StridedCopyJob(ScalarType type, void *dest, size_t dstride, const void *src, size_t sstride)
+        :fn(0), dest(dest), dstride(dstride), src(src), sstride(sstride)
+    {
+        switch(type) {
+#define CASE(ENUM, TYPE) case ENUM: fn = &stridedCopyV<TYPE>; break
+        CASE(pvBoolean, boolean);
+        CASE(pvByte, int8);
+        CASE(pvShort, int16);
+        CASE(pvInt, int32);
+        CASE(pvLong, int64);
+        CASE(pvUByte, uint8);
+        CASE(pvUShort, uint16);
+        CASE(pvUInt, uint32);
+        CASE(pvULong, uint64);
+        CASE(pvFloat, float);
+        CASE(pvDouble, double);
+#undef CASE
+        case pvString:
+            throw std::invalid_argument("arrayStridedCopy() does not support pvString");
+        }
+    }
+    virtual void run(size_t begin, size_t end)
+    {
+        (*fn)(dest, dstride, src, sstride, begin, end);
+    }
+};
+
+} // namespace
+
+void ArrayKernels::setParallel(unsigned threads, size_t threshold)
+{
+    pool().configure(threads, threshold);
+}
+
+unsigned ArrayKernels::threads()
+{
+    return pool().threads();
+}
+
+const char* ArrayKernels::implementation()
+{
+    return kernels().name;
+}
+
+namespace detail {
+
+void arrayStatistics(ArrayStatistics& out, ScalarType type, const void *src, size_t count)
+{
+    checkNumeric(type);
+    StatsJob J(type, src);
+    pool().execute(J, count);
+    out.count = count;
+    out.min = J.total.min;
+    out.max = J.total.max;
+    out.sum = J.total.sum;
+    out.sumOfSquares = J.total.sumOfSquares;
+}
+
+void arrayAffine(ScalarType dtype, void *dest, ScalarType stype, const void *src,
+                 size_t count, double scale, double offset)
+{
+    checkNumeric(dtype);
+    checkNumeric(stype);
+    AffineJob J(dtype, dest, stype, src, scale, offset);
+    pool().execute(J, count);
+}
+
+void arrayConvert(ScalarType dtype, void *dest, ScalarType stype, const void *src,
+                  size_t count)
+{
+    checkNumeric(dtype);
+    checkNumeric(stype);
+    ConvertJob J(dtype, dest, stype, src);
+    pool().execute(J, count);
+}
+
+size_t arrayHistogram(uint64 *bins, size_t nbins, double lo, double hi,
+                      ScalarType type, const void *src, size_t count)
+{
+    checkNumeric(type);
+    if(!(lo<hi))
+        throw std::invalid_argument("arrayHistogram() requires lo<hi");
+    if(nbins==0)
+        return 0;
+    HistogramJob J(bins, nbins, lo, hi, type, src, count);
+    pool().execute(J, count);
+    return J.counted;
+}
+
+void arrayStridedCopy(ScalarType type, void *dest, size_t destStride,
+                      const void *src, size_t srcStride, size_t count)
+{
+    if(destStride<1 || srcStride<1)
+        throw std::invalid_argument("arrayStridedCopy() stride must be >=1");
+    StridedCopyJob J(type, dest, destStride, src, srcStride);
+    // parts of whole cache lines
+    pool().execute(J, count, 4096);
+}
+
+} // namespace detail
+
+}}
@@ -29,6 +29,36 @@ using std::string;
 
 namespace epics { namespace pvData { 
 
+#if defined(PVDATA_USE_FUTEX) && defined(PVDATA_HAVE_FUTEX)
+
+Event::~Event() {}
+
+Event::Event(bool full)
+: impl(full)
+{
+}
+
+void Event::signal()
+{
+    impl.signal();
+}
+
+bool Event::wait ()
+{
+    return impl.wait();
+}
+
+bool Event::wait ( double timeOut )
+{
+    return impl.wait(timeOut);
+}
+
+bool Event::tryWait ()
+{
+    return impl.tryWait();
+}
+
+#else
 
 Event::~Event() {
     epicsEventDestroy(id);
@@ -68,4 +98,6 @@ bool Event::tryWait ()
     return status==epicsEventWaitOK ? true : false;
 }
 
+#endif
+
 }}
@@ -11,6 +11,8 @@
 #include <cstddef>
 #include <string>
 #include <cstdio>
+#include <stdexcept>
+#include <algorithm>
 
 #include <epicsEvent.h>
 #include <epicsMutex.h>
@@ -23,76 +25,282 @@ using std::string;
 
 namespace epics { namespace pvData {
 
-// special instance to stop the executor thread
-class ExecutorShutdown : public Command {
-    virtual void command();
-};
+Executor::Completion::Completion()
+: pending(0),
+  failed(0)
+{
+}
+
+Executor::Completion::~Completion()
+{
+}
+
+void Executor::Completion::add(size_t n)
+{
+    Lock xx(mutex);
+    pending += n;
+}
+
+void Executor::Completion::complete(bool ok)
+{
+    Lock xx(mutex);
+    if(!ok) failed++;
+    if(--pending==0) done.signal();
+}
+
+void Executor::Completion::wait()
+{
+    Lock xx(mutex);
+    while(pending) {
+        xx.unlock();
+        done.wait();
+        xx.lock();
+    }
+}
+
+bool Executor::Completion::wait(double timeOut)
+{
+    Lock xx(mutex);
+    while(pending) {
+        xx.unlock();
+        if(!done.wait(timeOut)) return isDone();
+        xx.lock();
+    }
+    return true;
+}
+
+bool Executor::Completion::isDone()
+{
+    Lock xx(mutex);
+    return pending==0;
+}
+
+size_t Executor::Completion::failures()
+{
+    Lock xx(mutex);
+    return failed;
+}
+
+
+Executor::ClassStats::ClassStats()
+: maxLatency(0.0),
+  queued(0),
+  executed(0),
+  late(0),
+  latencyTotal(0.0),
+  latencyMax(0.0),
+  runTotal(0.0),
+  runMax(0.0)
+{
+}
 
-void ExecutorShutdown::command()
+Executor::Queue::Queue(string const &name, double maxLatency)
+: name(name),
+  maxLatency(uint64(maxLatency*1e9)),
+  ring(16),
+  head(0),
+  count(0)
 {
+    resetStats();
 }
 
-static
-std::tr1::shared_ptr<Command> shutdown(new ExecutorShutdown());
+void Executor::Queue::resetStats()
+{
+    executed = late = 0;
+    latencyTotal = latencyMax = 0;
+    runTotal = runMax = 0;
+}
 
 
 Executor::Executor(string const & threadName,ThreadPriority priority)
-:  thread(threadName,priority,this)
+:  queues(1, Queue("default", 1.0)),
+   pending(0),
+   stopping(false),
+   mutex("Executor"),
+   thread(threadName,priority,this)
 {
 } 
 
 Executor::~Executor()
 {
-    execute(shutdown);
+    {
+        Lock xx(mutex);
+        stopping = true;
+    }
+    moreWork.signal();
     stopped.wait();
     // The thread signals 'stopped' while still holding
     // the lock.  By taking it we wait for the run() function
     // to actually return
     Lock xx(mutex);
-    head.reset();
-    tail.reset();
+    queues.clear();
+}
+
+unsigned Executor::addClass(string const &name, double maxLatency)
+{
+    if(!(maxLatency>=0.0 && maxLatency<1e9))
+        throw std::invalid_argument("Executor::addClass() maxLatency must be finite and >= 0");
+    Lock xx(mutex);
+    queues.push_back(Queue(name, maxLatency));
+    return queues.size()-1;
 }
 
 void Executor::run()
 {
     Lock xx(mutex);
     while(true) {
-        while(!head.get()) {
+        while(pending==0 && !stopping) {
             xx.unlock();
             moreWork.wait();
             xx.lock();
         }
-        CommandPtr command = head;
-        head = command->next;
-        if(!command.get()) continue;
-        if(command.get()==shutdown.get()) break;
+        // commands queued before destruction are still executed
+        if(pending==0) break;
+
+        // earliest deadline first
+        size_t next = queues.size();
+        uint64 deadline = 0;
+        for(size_t i=0; i<queues.size(); i++) {
+            Queue& Q = queues[i];
+            if(Q.count==0) continue;
+            uint64 D = Q.ring[Q.head].queuedAt + Q.maxLatency;
+            if(next==queues.size() || D<deadline) {
+                next = i;
+                deadline = D;
+            }
+        }
+        Queue *queue = &queues[next];
+        Entry& ent = queue->ring[queue->head];
+        CommandPtr command;
+        command.swap(ent.command);
+        void (*fn)(void*) = ent.fn;
+        void *arg = ent.arg;
+        Completion *done = ent.done;
+        uint64 queuedAt = ent.queuedAt;
+        queue->head = (queue->head+1)%queue->ring.size();
+        queue->count--;
+        pending--;
         xx.unlock();
+        uint64 start = monotonicTimeNS();
+        bool ok = false;
         try {
-            command->command();
+            if(command)
+                command->command();
+            else
+                (*fn)(arg);
+            ok = true;
         }catch(std::exception& e){
             //TODO: feed into logging mechanism
             fprintf(stderr, "Executor: Unhandled exception: %s",e.what());
         }catch(...){
             fprintf(stderr, "Executor: Unhandled exception");
         }
+        uint64 end = monotonicTimeNS();
+        // release our reference before reporting completion
+        command.reset();
 
         xx.lock();
+        // addClass() may have moved the queues
+        queue = &queues[next];
+        uint64 latency = start - queuedAt, runtime = end - start;
+        queue->executed++;
+        if(start>deadline) queue->late++;
+        queue->latencyTotal += latency;
+        queue->latencyMax = std::max(queue->latencyMax, latency);
+        queue->runTotal += runtime;
+        queue->runMax = std::max(queue->runMax, runtime);
+        // after the stats, so that a waiter sees this command counted
+        if(done) done->complete(ok);
     }
     stopped.signal();
 }
 
+Executor::Queue& Executor::getQueue(unsigned cls)
+{
+    if(cls>=queues.size())
+        throw std::invalid_argument("Executor: unknown scheduling class");
+    return queues[cls];
+}
+
+void Executor::reserve(Queue& queue, size_t n)
+{
+    if(queue.count+n<=queue.ring.size())
+        return;
+    // grow, keeping the queued entries in order
+    size_t size = queue.ring.size()*2;
+    while(size<queue.count+n)
+        size *= 2;
+    std::vector<Entry> bigger(size);
+    for(size_t i=0; i<queue.count; i++)
+        std::swap(bigger[i], queue.ring[(queue.head+i)%queue.ring.size()]);
+    queue.ring.swap(bigger);
+    queue.head = 0;
+}
+
+void Executor::push(Queue& queue, CommandPtr const &command, void (*fn)(void*), void *arg,
+                    Completion *done, uint64 now)
+{
+    reserve(queue, 1);
+    Entry& ent = queue.ring[(queue.head+queue.count)%queue.ring.size()];
+    ent.command = command;
+    ent.fn = fn;
+    ent.arg = arg;
+    ent.done = done;
+    ent.queuedAt = now;
+    queue.count++;
+    if(pending++==0)
+        moreWork.signal();
+}
+
 void Executor::execute(CommandPtr const & command)
 {
+    execute(command, 0);
+}
+
+void Executor::execute(CommandPtr const & command, Completion *done, unsigned cls)
+{
+    if(!command)
+        throw std::invalid_argument("Executor::execute() NULL command");
+    uint64 now = monotonicTimeNS();
     Lock xx(mutex);
-    command->next.reset();
-    if(!head.get()) {
-        head = command;
-        moreWork.signal();
-        return;
+    push(getQueue(cls), command, 0, 0, done, now);
+    if(done) done->add(1);
+}
+
+void Executor::execute(void (*fn)(void*), void *arg, Completion *done, unsigned cls)
+{
+    if(!fn)
+        throw std::invalid_argument("Executor::execute() NULL function");
+    uint64 now = monotonicTimeNS();
+    Lock xx(mutex);
+    push(getQueue(cls), CommandPtr(), fn, arg, done, now);
+    if(done) done->add(1);
+}
+
+void Executor::getStats(std::vector<ClassStats>& stats)
+{
+    Lock xx(mutex);
+    stats.resize(queues.size());
+    for(size_t i=0; i<queues.size(); i++) {
+        const Queue& Q = queues[i];
+        ClassStats& S = stats[i];
+        S.name = Q.name;
+        S.maxLatency = Q.maxLatency*1e-9;
+        S.queued = Q.count;
+        S.executed = Q.executed;
+        S.late = Q.late;
+        S.latencyTotal = Q.latencyTotal*1e-9;
+        S.latencyMax = Q.latencyMax*1e-9;
+        S.runTotal = Q.runTotal*1e-9;
+        S.runMax = Q.runMax*1e-9;
     }
-    CommandPtr tail = head;
-    while(tail->next) tail = tail->next;
-    tail->next = command;   
+}
+
+void Executor::resetStats()
+{
+    Lock xx(mutex);
+    for(size_t i=0; i<queues.size(); i++)
+        queues[i].resetStats();
 }
 
 }}
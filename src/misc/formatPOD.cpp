@@ -0,0 +1,234 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <epicsMath.h>
+
+#define epicsExportSharedSymbols
+#include "pv/typeCast.h"
+
+/* Formatting of numbers as std::ostream does with default flags
+ * and precision (the same as printf "%d" and "%g"), without iostreams,
+ * locale or allocation.
+ */
+
+namespace {
+
+using epics::pvData::uint32;
+using epics::pvData::uint64;
+
+// digits of val, right aligned ending at 'end'.  Returns start.
+inline char* formatDigits(char *end, uint64 val)
+{
+    static const char pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+    while(val>=100) {
+        unsigned i = unsigned(val%100)*2;
+        val /= 100;
+        *--end = pairs[i+1];
+        *--end = pairs[i];
+    }
+    if(val>=10) {
+        unsigned i = unsigned(val)*2;
+        *--end = pairs[i+1];
+        *--end = pairs[i];
+    } else {
+        *--end = char('0'+val);
+    }
+    return end;
+}
+
+inline char* formatUnsigned(char *buf, uint64 val)
+{
+    char temp[20];
+    char *start = formatDigits(temp+sizeof(temp), val);
+    size_t n = temp+sizeof(temp)-start;
+    memcpy(buf, start, n);
+    return buf+n;
+}
+
+inline char* formatSigned(char *buf, epics::pvData::int64 val)
+{
+    if(val<0) {
+        *buf++ = '-';
+        return formatUnsigned(buf, uint64(0)-uint64(val));
+    }
+    return formatUnsigned(buf, uint64(val));
+}
+
+// powers of 10 which are exactly representable as double
+const double exactPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+    1e21, 1e22
+};
+
+const int precision = 6;
+
+// printf("%g") with the C locale, used when the fast path can't be sure of the rounding
+char* formatSlow(char *buf, double val)
+{
+    int n = snprintf(buf, epics::pvData::detail::formatPODSize, "%.*g", precision, val);
+    if(n<0)
+        n = 0;
+    for(int i=0; i<n; i++) {
+        // the decimal point of LC_NUMERIC is the only non-ASCII-alnum, non-sign character
+        if(buf[i]==',')
+            buf[i] = '.';
+    }
+    return buf+n;
+}
+
+// mag*10^(precision-1-exp), with a single rounding
+inline bool scaleDigits(double mag, int exp, double *scaled)
+{
+    int shift = precision-1-exp;
+    if(shift< -22 || shift>22)
+        return false;
+    *scaled = shift>=0 ? mag*exactPow10[shift] : mag/exactPow10[-shift];
+    return true;
+}
+
+/* "%g" with precision 6.  The value is scaled to six integer digits
+ * with one correctly rounded multiply or divide by an exact power of ten.
+ * When the discarded fraction is too near one half for that to decide
+ * the rounding, or the exponent is out of range, use snprintf().
+ */
+char* formatDouble(char *buf, double val)
+{
+    double mag = fabs(val);
+    if(mag==0.0) {
+        uint64 bits;
+        memcpy(&bits, &val, sizeof(bits));
+        if(bits>>63)
+            *buf++ = '-';
+        *buf++ = '0';
+        return buf;
+    }
+    if(!finite(mag))
+        return formatSlow(buf, val);
+
+    // small integers print as themselves
+    if(mag<1e6 && mag==double(uint32(mag))) {
+        if(val<0)
+            *buf++ = '-';
+        return formatUnsigned(buf, uint32(mag));
+    }
+
+    int exp = int(floor(log10(mag)));
+    double scaled;
+    if(!scaleDigits(mag, exp, &scaled))
+        return formatSlow(buf, val);
+    // log10() may be off by one near powers of 10
+    if(scaled>=1e6 || scaled<1e5) {
+        exp += scaled>=1e6 ? 1 : -1;
+        if(!scaleDigits(mag, exp, &scaled) || scaled>=1e6 || scaled<1e5)
+            return formatSlow(buf, val);
+    }
+
+    double whole = floor(scaled);
+    double frac = scaled-whole;
+    // error of scaled is at most half an ulp, ~6e-11
+    if(fabs(frac-0.5)<1e-9)
+        return formatSlow(buf, val);
+
+    uint32 digits = uint32(whole);
+    if(frac>0.5)
+        digits++;
+    if(digits==1000000u) {
+        digits = 100000u;
+        exp++;
+    }
+
+    char dig[precision];
+    formatDigits(dig+precision, digits);
+    // drop trailing zeros
+    int ndig = precision;
+    while(ndig>1 && dig[ndig-1]=='0')
+        ndig--;
+
+    if(val<0)
+        *buf++ = '-';
+
+    if(exp< -4 || exp>=precision) {
+        // d.ddddde+XX
+        *buf++ = dig[0];
+        if(ndig>1) {
+            *buf++ = '.';
+            memcpy(buf, dig+1, ndig-1);
+            buf += ndig-1;
+        }
+        *buf++ = 'e';
+        if(exp<0) {
+            *buf++ = '-';
+            exp = -exp;
+        } else {
+            *buf++ = '+';
+        }
+        if(exp<10)
+            *buf++ = '0';
+        return formatUnsigned(buf, unsigned(exp));
+
+    } else if(exp<0) {
+        // 0.000ddd
+        *buf++ = '0';
+        *buf++ = '.';
+        for(int i=-1; i>exp; i--)
+            *buf++ = '0';
+        memcpy(buf, dig, ndig);
+        return buf+ndig;
+
+    } else {
+        // ddd.ddd
+        int nint = exp+1;
+        memcpy(buf, dig, nint);
+        buf += nint;
+        if(ndig>nint) {
+            *buf++ = '.';
+            memcpy(buf, dig+nint, ndig-nint);
+            buf += ndig-nint;
+        }
+        return buf;
+    }
+}
+
+} // namespace
+
+namespace epics { namespace pvData { namespace detail {
+
+char* formatPOD(char *buf, boolean val)
+{
+    if(val) {
+        memcpy(buf, "true", 4);
+        return buf+4;
+    } else {
+        memcpy(buf, "false", 5);
+        return buf+5;
+    }
+}
+
+char* formatPOD(char *buf, int8 val) { return formatSigned(buf, val); }
+char* formatPOD(char *buf, uint8 val) { return formatUnsigned(buf, val); }
+char* formatPOD(char *buf, int16_t val) { return formatSigned(buf, val); }
+char* formatPOD(char *buf, uint16_t val) { return formatUnsigned(buf, val); }
+char* formatPOD(char *buf, int32_t val) { return formatSigned(buf, val); }
+char* formatPOD(char *buf, uint32_t val) { return formatUnsigned(buf, val); }
+char* formatPOD(char *buf, int64_t val) { return formatSigned(buf, val); }
+char* formatPOD(char *buf, uint64_t val) { return formatUnsigned(buf, val); }
+char* formatPOD(char *buf, float val) { return formatDouble(buf, val); }
+char* formatPOD(char *buf, double val) { return formatDouble(buf, val); }
+
+}}}
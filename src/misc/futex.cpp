@@ -0,0 +1,150 @@
+/* futex.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#if defined(__linux__)
+#include <ctime>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#define epicsExportSharedSymbols
+#include <pv/futex.h>
+
+#ifdef PVDATA_HAVE_FUTEX
+
+namespace epics { namespace pvData {
+
+namespace {
+
+inline void cpuRelax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+// Waits only while *addr==val.  timeout==NULL waits forever.
+inline int futexWait(int *addr, int val, const struct timespec *timeout)
+{
+    return syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeout, NULL, 0);
+}
+
+inline void futexWake(int *addr, int nwake)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, nwake, NULL, NULL, 0);
+}
+
+// No point in spinning if the thread we wait for can't be running.
+int spinCeiling()
+{
+    static const int ceiling = sysconf(_SC_NPROCESSORS_ONLN)>1 ? FutexMutex::spinMax : 0;
+    return ceiling;
+}
+
+// Allow up to twice the number of spins which were needed recently,
+// so that when the wait is usually longer than a spin is worth
+// the limit settles at parking quickly.
+inline int spinLimit(int estimate)
+{
+    int limit = estimate*2 + 10;
+    int ceiling = spinCeiling();
+    return limit>ceiling ? ceiling : limit;
+}
+
+inline void spinUpdate(int *estimate, int prev, int spins)
+{
+    __atomic_store_n(estimate, prev + (spins - prev)/8, __ATOMIC_RELAXED);
+}
+
+inline double monotonicNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+} // namespace
+
+void FutexMutex::lockSlow()
+{
+    int estimate = __atomic_load_n(&spinEstimate, __ATOMIC_RELAXED);
+    int limit = spinLimit(estimate);
+    int c;
+    for(int i=0; i<limit; i++) {
+        cpuRelax();
+        c = 0;
+        if(__atomic_load_n(&state, __ATOMIC_RELAXED)==0
+                && __atomic_compare_exchange_n(&state, &c, 1, false,
+                                               __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            spinUpdate(&spinEstimate, estimate, i);
+            return;
+        }
+    }
+    spinUpdate(&spinEstimate, estimate, limit);
+
+    // Park.  Mark the lock contended so the eventual unlock() wakes us.
+    c = __atomic_exchange_n(&state, 2, __ATOMIC_ACQUIRE);
+    while(c!=0) {
+        futexWait(&state, 2, NULL);
+        c = __atomic_exchange_n(&state, 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+void FutexMutex::wake()
+{
+    futexWake(&state, 1);
+}
+
+bool FutexEvent::waitSlow(double timeOut)
+{
+    int estimate = __atomic_load_n(&spinEstimate, __ATOMIC_RELAXED);
+    int limit = spinLimit(estimate);
+    for(int i=0; i<limit; i++) {
+        cpuRelax();
+        if(__atomic_load_n(&state, __ATOMIC_RELAXED) && tryWait()) {
+            spinUpdate(&spinEstimate, estimate, i);
+            return true;
+        }
+    }
+    spinUpdate(&spinEstimate, estimate, limit);
+
+    double deadline = timeOut>=0.0 ? monotonicNow()+timeOut : 0.0;
+    bool ret = false;
+    __atomic_add_fetch(&waiters, 1, __ATOMIC_SEQ_CST);
+    while(true) {
+        if(tryWait()) {
+            ret = true;
+            break;
+        }
+        if(timeOut<0.0) {
+            futexWait(&state, 0, NULL);
+        } else {
+            double remain = deadline - monotonicNow();
+            if(remain<=0.0)
+                break;
+            struct timespec ts;
+            ts.tv_sec = (time_t)remain;
+            ts.tv_nsec = (long)((remain - ts.tv_sec)*1e9);
+            futexWait(&state, 0, &ts);
+        }
+    }
+    __atomic_sub_fetch(&waiters, 1, __ATOMIC_SEQ_CST);
+    return ret;
+}
+
+void FutexEvent::wake()
+{
+    futexWake(&state, 1);
+}
+
+}}
+
+#endif /* PVDATA_HAVE_FUTEX */
@@ -0,0 +1,282 @@
+/* lockStats.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+#include <cstring>
+
+#define epicsExportSharedSymbols
+#include <pv/lock.h>
+#include <pv/timeFunction.h>
+
+namespace epics { namespace pvData {
+
+#ifdef PVDATA_LOCK_STATS
+
+namespace detail {
+struct LockStatsEntry : public LockStats {
+    LockStatsEntry *prev, *next;
+};
+}
+
+using detail::LockStatsEntry;
+
+namespace {
+
+inline unsigned bucket(uint64_t ns)
+{
+    unsigned i = 0;
+    while(ns>1 && i<LockStats::histogramSize-1) {
+        ns >>= 1;
+        i++;
+    }
+    return i;
+}
+
+void clear(LockStats& S)
+{
+    S.acquired = S.contended = 0;
+    S.waitTime = S.maxWait = 0;
+    S.holdTime = S.maxHold = 0;
+    memset(S.waitHistogram, 0, sizeof(S.waitHistogram));
+    memset(S.holdHistogram, 0, sizeof(S.holdHistogram));
+}
+
+void accumulate(LockStats& to, const LockStats& from)
+{
+    to.instances += from.instances;
+    to.acquired += from.acquired;
+    to.contended += from.contended;
+    to.waitTime += from.waitTime;
+    to.maxWait = std::max(to.maxWait, from.maxWait);
+    to.holdTime += from.holdTime;
+    to.maxHold = std::max(to.maxHold, from.maxHold);
+    for(unsigned i=0; i<LockStats::histogramSize; i++) {
+        to.waitHistogram[i] += from.waitHistogram[i];
+        to.holdHistogram[i] += from.holdHistogram[i];
+    }
+}
+
+// Upper bound of the bucket holding the given fraction of all samples
+uint64_t percentile(const uint64_t *hist, double frac)
+{
+    uint64_t total = 0;
+    for(unsigned i=0; i<LockStats::histogramSize; i++)
+        total += hist[i];
+    if(total==0)
+        return 0;
+    uint64_t want = uint64_t(total*frac), sum = 0;
+    for(unsigned i=0; i<LockStats::histogramSize; i++) {
+        sum += hist[i];
+        if(sum>want)
+            return uint64_t(2)<<i;
+    }
+    return uint64_t(2)<<(LockStats::histogramSize-1);
+}
+
+bool moreContended(const LockStats& lhs, const LockStats& rhs)
+{
+    if(lhs.contended!=rhs.contended)
+        return lhs.contended>rhs.contended;
+    return lhs.waitTime>rhs.waitTime;
+}
+
+// Registry of live instances, and totals of destroyed instances.
+// The registry lock is never instrumented.
+struct Registry {
+    BasicMutex lock;
+    LockStatsEntry *head;
+    typedef std::map<std::string, LockStats> retired_t;
+    retired_t retired;
+    Registry() :head(0) {}
+};
+
+Registry& registry()
+{
+    // never destroyed as mutexes may outlive static destructors
+    static Registry *reg = new Registry;
+    return *reg;
+}
+
+} // namespace
+
+LockStats::LockStats()
+    :instances(0)
+{
+    clear(*this);
+}
+
+InstrumentedMutex::InstrumentedMutex(const char *name)
+    :stats(new LockStatsEntry)
+    ,depth(0)
+    ,lockedAt(0)
+{
+    stats->name = name ? name : "<unnamed>";
+    stats->instances = 1;
+    stats->prev = 0;
+
+    Registry& reg = registry();
+    reg.lock.lock();
+    stats->next = reg.head;
+    if(reg.head)
+        reg.head->prev = stats;
+    reg.head = stats;
+    reg.lock.unlock();
+}
+
+InstrumentedMutex::~InstrumentedMutex()
+{
+    Registry& reg = registry();
+    reg.lock.lock();
+    if(stats->prev)
+        stats->prev->next = stats->next;
+    else
+        reg.head = stats->next;
+    if(stats->next)
+        stats->next->prev = stats->prev;
+
+    Registry::retired_t::iterator it = reg.retired.find(stats->name);
+    if(it==reg.retired.end()) {
+        it = reg.retired.insert(std::make_pair(stats->name, LockStats())).first;
+        it->second.name = stats->name;
+    }
+    accumulate(it->second, *stats);
+    reg.lock.unlock();
+    delete stats;
+}
+
+void InstrumentedMutex::lock()
+{
+    if(!mutex.tryLock()) {
+        uint64_t start = monotonicTimeNS();
+        mutex.lock();
+        // a recursive lock never waits, so we are not the owner yet
+        uint64_t waited = monotonicTimeNS() - start;
+        stats->contended++;
+        stats->waitTime += waited;
+        if(waited>stats->maxWait)
+            stats->maxWait = waited;
+        stats->waitHistogram[bucket(waited)]++;
+    }
+    if(depth++==0) {
+        stats->acquired++;
+        lockedAt = monotonicTimeNS();
+    }
+}
+
+void InstrumentedMutex::unlock()
+{
+    if(--depth==0) {
+        uint64_t held = monotonicTimeNS() - lockedAt;
+        stats->holdTime += held;
+        if(held>stats->maxHold)
+            stats->maxHold = held;
+        stats->holdHistogram[bucket(held)]++;
+    }
+    mutex.unlock();
+}
+
+bool InstrumentedMutex::tryLock()
+{
+    if(!mutex.tryLock())
+        return false;
+    if(depth++==0) {
+        stats->acquired++;
+        lockedAt = monotonicTimeNS();
+    }
+    return true;
+}
+
+void getLockStats(std::vector<LockStats>& stats)
+{
+    Registry& reg = registry();
+    Registry::retired_t totals;
+    {
+        reg.lock.lock();
+        totals = reg.retired;
+        // counters of live instances are read without their lock
+        for(LockStatsEntry *ent = reg.head; ent; ent = ent->next) {
+            LockStats& T = totals[ent->name];
+            T.name = ent->name;
+            accumulate(T, *ent);
+        }
+        reg.lock.unlock();
+    }
+    stats.clear();
+    stats.reserve(totals.size());
+    for(Registry::retired_t::const_iterator it = totals.begin(); it!=totals.end(); ++it)
+        stats.push_back(it->second);
+    std::sort(stats.begin(), stats.end(), moreContended);
+}
+
+void reportLockStats(std::ostream& strm, size_t top)
+{
+    std::vector<LockStats> stats;
+    getLockStats(stats);
+    if(top>stats.size())
+        top = stats.size();
+    std::ios_base::fmtflags flags = strm.flags();
+    std::streamsize prec = strm.precision();
+
+    strm<<"Lock contention, top "<<top<<" of "<<stats.size()<<" names. Times in us.\n"
+        <<std::left<<std::setw(24)<<"name"<<std::right
+        <<std::setw(6)<<"count"
+        <<std::setw(12)<<"acquired"
+        <<std::setw(12)<<"contended"
+        <<std::setw(8)<<"%"
+        <<std::setw(12)<<"wait"
+        <<std::setw(10)<<"max wait"
+        <<std::setw(10)<<"hold avg"
+        <<std::setw(10)<<"hold p50"
+        <<std::setw(10)<<"hold p99"
+        <<std::setw(10)<<"max hold"
+        <<"\n";
+    for(size_t i=0; i<top; i++) {
+        const LockStats& S = stats[i];
+        double pct = S.acquired ? 100.0*S.contended/S.acquired : 0.0;
+        double avg = S.acquired ? S.holdTime*1e-3/S.acquired : 0.0;
+        strm<<std::left<<std::setw(24)<<S.name<<std::right
+            <<std::setw(6)<<S.instances
+            <<std::setw(12)<<S.acquired
+            <<std::setw(12)<<S.contended
+            <<std::fixed<<std::setprecision(2)
+            <<std::setw(8)<<pct
+            <<std::setprecision(1)
+            <<std::setw(12)<<S.waitTime*1e-3
+            <<std::setw(10)<<S.maxWait*1e-3
+            <<std::setw(10)<<avg
+            <<std::setw(10)<<percentile(S.holdHistogram, 0.5)*1e-3
+            <<std::setw(10)<<percentile(S.holdHistogram, 0.99)*1e-3
+            <<std::setw(10)<<S.maxHold*1e-3
+            <<"\n";
+    }
+    strm.flags(flags);
+    strm.precision(prec);
+}
+
+void resetLockStats()
+{
+    Registry& reg = registry();
+    reg.lock.lock();
+    reg.retired.clear();
+    for(LockStatsEntry *ent = reg.head; ent; ent = ent->next)
+        clear(*ent);
+    reg.lock.unlock();
+}
+
+#else /* PVDATA_LOCK_STATS */
+
+void reportLockStats(std::ostream& strm, size_t)
+{
+    strm<<"Lock statistics not available.  Build with PVDATA_LOCK_STATS\n";
+}
+
+void resetLockStats() {}
+
+#endif /* PVDATA_LOCK_STATS */
+
+}}
@@ -0,0 +1,134 @@
+/* mappedVector.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES>0
+#    define HAVE_MMAP
+#  endif
+#endif
+
+#define epicsExportSharedSymbols
+#include <pv/mappedVector.h>
+
+namespace epics { namespace pvData {
+
+#ifdef HAVE_MMAP
+
+namespace {
+
+struct munmap_deleter {
+    size_t length;
+    explicit munmap_deleter(size_t length) :length(length) {}
+    void operator()(const void *base) { munmap((void*)base, length); }
+};
+
+struct FD {
+    int fd;
+    explicit FD(int fd) :fd(fd) {}
+    ~FD() { if(fd>=0) close(fd); }
+};
+
+void fail(const std::string& filename, const char *what, int err)
+{
+    std::ostringstream msg;
+    msg<<"mapFileVector() "<<what<<" '"<<filename<<"'";
+    if(err)
+        msg<<" : "<<strerror(err);
+    throw std::runtime_error(msg.str());
+}
+
+} // namespace
+
+namespace detail {
+
+shared_vector<const void> mapFileBytes(const std::string& filename, uint64 offset,
+                                       uint64 bytes, size_t elemSize, unsigned flags)
+{
+    int oflags = O_RDONLY;
+#ifdef O_CLOEXEC
+    oflags |= O_CLOEXEC;
+#endif
+    FD file(open(filename.c_str(), oflags));
+    if(file.fd<0)
+        fail(filename, "can't open", errno);
+
+    struct stat info;
+    if(fstat(file.fd, &info))
+        fail(filename, "can't stat", errno);
+    uint64 fileSize = info.st_size;
+
+    if(offset>fileSize)
+        fail(filename, "offset beyond end of", 0);
+    if(bytes==(uint64)-1)
+        bytes = (fileSize-offset) - (fileSize-offset)%elemSize;
+    else if(bytes>fileSize-offset)
+        fail(filename, "region beyond end of", 0);
+
+    if(bytes==0)
+        return shared_vector<const void>();
+    if(bytes > ((size_t)-1)/2)
+        fail(filename, "region too large to map from", 0);
+
+    // mmap() offset must be page aligned
+    const uint64 page = sysconf(_SC_PAGESIZE);
+    uint64 start = offset - offset%page;
+    size_t skip = size_t(offset-start);
+    size_t length = skip + size_t(bytes);
+
+    int prot = PROT_READ, mflags = MAP_SHARED;
+    if(flags&mapCopyOnWrite) {
+        prot |= PROT_WRITE;
+        mflags = MAP_PRIVATE;
+    }
+    void *base = mmap(0, length, prot, mflags, file.fd, off_t(start));
+    if(base==MAP_FAILED)
+        fail(filename, "can't map", errno);
+
+    // on failure shared_ptr calls the deleter
+    std::tr1::shared_ptr<void> owner(base, munmap_deleter(length));
+
+    int advice = -1;
+    if(flags&mapSequential)
+        advice = MADV_SEQUENTIAL;
+    else if(flags&mapRandom)
+        advice = MADV_RANDOM;
+    if(advice>=0)
+        (void)madvise(base, length, advice);
+    if(flags&mapWillNeed)
+        (void)madvise(base, length, MADV_WILLNEED);
+
+    if(flags&mapCopyOnWrite) {
+        // plain storage, so unique() permits thaw() in place
+        return shared_vector<const void>(std::tr1::shared_ptr<const void>(owner), skip, size_t(bytes));
+    }
+    std::tr1::shared_ptr<const void> data(base, readonly_storage_deleter(owner));
+    return shared_vector<const void>(data, skip, size_t(bytes), _shared_vector_readonly_tag());
+}
+
+} // namespace detail
+
+#else /* HAVE_MMAP */
+
+namespace detail {
+
+shared_vector<const void> mapFileBytes(const std::string&, uint64, uint64, size_t, unsigned)
+{
+    throw std::logic_error("mapFileVector() not supported on this target");
+}
+
+} // namespace detail
+
+#endif /* HAVE_MMAP */
+
+}}
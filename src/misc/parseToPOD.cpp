@@ -8,6 +8,8 @@
 #include <float.h>
 #include <limits.h>
 
+#include <limits>
+
 #include <epicsVersion.h>
 
 #include <epicsMath.h>
@@ -505,6 +507,134 @@ void handleParseError(int err)
     }
 }
 
+/* Fast paths for plain decimal numbers, which don't need c_str(),
+ * errno or strtod().  Anything else (whitespace, hex, octal, inf/nan,
+ * out of range, errors) returns false and goes through epicsParse*().
+ */
+namespace {
+
+using epics::pvData::int64;
+using epics::pvData::uint64;
+
+// [+-]?[1-9][0-9]* with at most 18 digits, or 0
+bool parseDecimal(const string& in, bool *neg, uint64 *val)
+{
+    const char *s = in.data(), *end = s+in.size();
+    *neg = false;
+    if(s!=end && (*s=='-' || *s=='+'))
+        *neg = *s++=='-';
+    size_t ndig = end-s;
+    if(ndig==0 || ndig>18 || (*s=='0' && ndig>1))
+        return false;
+    uint64 v = 0;
+    for(; s!=end; s++) {
+        unsigned d = unsigned(*s)-'0';
+        if(d>9)
+            return false;
+        v = v*10u + d;
+    }
+    *val = v;
+    return true;
+}
+
+template<typename T>
+bool parseIntFast(const string& in, T *out)
+{
+    bool neg;
+    uint64 v;
+    if(!parseDecimal(in, &neg, &v))
+        return false;
+    if(std::numeric_limits<T>::is_signed) {
+        int64 sv = neg ? -int64(v) : int64(v);
+        if(sv<int64(std::numeric_limits<T>::min()) || sv>int64(std::numeric_limits<T>::max()))
+            return false;
+        *out = T(sv);
+    } else {
+        // strtoul() accepts a leading '-'.  Leave that to the slow path.
+        if(neg || v>uint64(std::numeric_limits<T>::max()))
+            return false;
+        *out = T(v);
+    }
+    return true;
+}
+
+const double exactPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+    1e21, 1e22
+};
+
+/* [+-]?digits[.digits][e[+-]digits] with at most 15 significant digits
+ * and a decimal exponent of at most 22.  The mantissa and the power
+ * of ten are then exact, so one multiply or divide is correctly rounded
+ * and gives the same result as strtod().
+ */
+bool parseDoubleFast(const string& in, double *out)
+{
+    const char *s = in.data(), *end = s+in.size();
+    bool neg = false;
+    if(s!=end && (*s=='-' || *s=='+'))
+        neg = *s++=='-';
+
+    uint64 mant = 0;
+    int ndig = 0, exp10 = 0;
+    bool any = false;
+    for(; s!=end; s++) {
+        unsigned d = unsigned(*s)-'0';
+        if(d>9)
+            break;
+        any = true;
+        if((mant || d) && ++ndig>15)
+            return false;
+        mant = mant*10u + d;
+    }
+    if(s!=end && *s=='.') {
+        for(s++; s!=end; s++) {
+            unsigned d = unsigned(*s)-'0';
+            if(d>9)
+                break;
+            any = true;
+            if((mant || d) && ++ndig>15)
+                return false;
+            mant = mant*10u + d;
+            exp10--;
+        }
+    }
+    if(!any)
+        return false;
+    if(s!=end && (*s=='e' || *s=='E')) {
+        s++;
+        bool eneg = false;
+        if(s!=end && (*s=='-' || *s=='+'))
+            eneg = *s++=='-';
+        int e = 0;
+        bool edig = false;
+        for(; s!=end; s++) {
+            unsigned d = unsigned(*s)-'0';
+            if(d>9)
+                break;
+            edig = true;
+            if(e<1000)
+                e = e*10 + d;
+        }
+        if(!edig)
+            return false;
+        exp10 += eneg ? -e : e;
+    }
+    if(s!=end || exp10< -22 || exp10>22)
+        return false;
+
+    double v = double(mant);
+    if(exp10<0)
+        v /= exactPow10[-exp10];
+    else
+        v *= exactPow10[exp10];
+    *out = neg ? -v : v;
+    return true;
+}
+
+} // namespace
+
 namespace epics { namespace pvData { namespace detail {
 
 void parseToPOD(const string & in, boolean *out)
@@ -519,6 +649,7 @@ void parseToPOD(const string & in, boolean *out)
 
 #define INTFN(T, S) \
 void parseToPOD(const string& in, T *out) { \
+    if(parseIntFast(in, out)) return; \
     epics ## S temp; \
     int err = epicsParse ## S (in.c_str(), &temp, 0, NULL); \
     if(err)   handleParseError(err); \
@@ -533,6 +664,7 @@ INTFN(int32_t, Int32);
 INTFN(uint32_t, UInt32);
 
 void parseToPOD(const string& in, int64_t *out) {
+    if(parseIntFast(in, out)) return;
 #ifdef NEED_LONGLONG
     int err = epicsParseLongLong(in.c_str(), out, 0, NULL);
 #else
@@ -542,6 +674,7 @@ void parseToPOD(const string& in, int64_t *out) {
 }
 
 void parseToPOD(const string& in, uint64_t *out) {
+    if(parseIntFast(in, out)) return;
 #ifdef NEED_LONGLONG
     int err = epicsParseULongLong(in.c_str(), out, 0, NULL);
 #else
@@ -551,11 +684,23 @@ void parseToPOD(const string& in, uint64_t *out) {
 }
 
 void parseToPOD(const string& in, float *out) {
+    double value;
+    if(parseDoubleFast(in, &value)) {
+        // same range checks as epicsParseFloat()
+        double abs = fabs(value);
+        if(value > 0 && abs <= FLT_MIN)
+            handleParseError(S_stdlib_underflow);
+        if(finite(value) && abs >= FLT_MAX)
+            handleParseError(S_stdlib_overflow);
+        *out = (float)value;
+        return;
+    }
     int err = epicsParseFloat(in.c_str(), out, NULL);
     if(err)   handleParseError(err);
 }
 
 void parseToPOD(const string& in, double *out) {
+    if(parseDoubleFast(in, out)) return;
     int err = epicsParseDouble(in.c_str(), out, NULL);
     if(err)   handleParseError(err);
 #if defined(vxWorks)
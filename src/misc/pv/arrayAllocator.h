@@ -0,0 +1,165 @@
+/* arrayAllocator.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/**
+ *  Pluggable allocation of array storage.
+ *
+ *  By default the storage of numeric shared_vector (and so of every
+ *  PVValueArray<T>) is allocated with new[], and that of ByteBuffer
+ *  with malloc().  An ArrayAllocator may be installed either for all
+ *  of these, or for the arrays of one ScalarType only.
+ *
+ *  AlignedAllocator is a ready made allocator which returns cache line
+ *  aligned storage, recycles blocks of common sizes, and can back large
+ *  arrays with transparent huge pages.
+ */
+#ifndef ARRAYALLOCATOR_H
+#define ARRAYALLOCATOR_H
+
+#include <cstddef>
+#include <vector>
+
+#include <pv/sharedPtr.h>
+#include <pv/lock.h>
+#include <pv/pvIntrospect.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+/**
+ * @brief Interface of array storage allocators.
+ *
+ * Implementations must be thread safe.
+ *
+ * An installed allocator is referenced, and never destroyed, until process exit
+ * since arrays allocated from it may outlive any later change of policy.
+ */
+class epicsShareClass ArrayAllocator {
+public:
+    POINTER_DEFINITIONS(ArrayAllocator);
+    virtual ~ArrayAllocator();
+    /**
+     * Allocate storage.
+     * @param bytes Number of bytes.  May be zero.
+     * @return Storage suitably aligned for any scalar type.
+     * @throws std::bad_alloc
+     */
+    virtual void* allocate(std::size_t bytes) = 0;
+    /**
+     * Release storage.
+     * @param ptr As returned by allocate()
+     * @param bytes The same size which was passed to allocate()
+     */
+    virtual void deallocate(void *ptr, std::size_t bytes) = 0;
+
+    /**
+     * Install the allocator used for all arrays with no allocator of their own.
+     * This includes ByteBuffer storage.
+     * @param alloc The allocator, or NULL to restore new[] and malloc().
+     */
+    static void setDefault(const shared_pointer& alloc);
+    /**
+     * Install the allocator used for arrays of one type.
+     * @param type A numeric type, or pvBoolean.  pvString arrays are always allocated with new[].
+     * @param alloc The allocator, or NULL to use the default.
+     * @throws std::invalid_argument for pvString
+     */
+    static void set(ScalarType type, const shared_pointer& alloc);
+
+    //! The allocator installed by setDefault(), or NULL
+    static ArrayAllocator* getDefault();
+    //! The allocator used for arrays of this type, or NULL for new[]
+    static ArrayAllocator* get(ScalarType type);
+};
+
+/**
+ * @brief Aligned allocator with a recycling pool and huge page support.
+ *
+ * Every block is aligned to the alignment given to the constructor.
+ *
+ * When poolBytes is non-zero, requests up to maxPooledBlock bytes are rounded
+ * up to a power of two.  Released blocks are kept for re-use, up to poolBytes
+ * in total, which avoids repeated trips to the system allocator
+ * when arrays of the same size are created and destroyed in a loop.
+ *
+ * When hugePageThreshold is non-zero, requests of this size, or larger,
+ * are mapped directly with mmap(), aligned to 2MB and advised (MADV_HUGEPAGE)
+ * to be backed by transparent huge pages.  Linux only.  Elsewhere ignored.
+ */
+class epicsShareClass AlignedAllocator : public ArrayAllocator {
+public:
+    POINTER_DEFINITIONS(AlignedAllocator);
+
+    enum {
+        //! Size of, and alignment of, huge pages
+        hugePageSize = 2*1024*1024,
+        //! Default upper limit of pooled block size
+        defaultMaxPooledBlock = 1024*1024
+    };
+
+    //! Counters since construction
+    struct Stats {
+        //! Pooled allocations satisfied by a recycled block
+        size_t poolHits;
+        //! Pooled allocations which needed a new block
+        size_t poolMisses;
+        //! Allocations mapped with huge pages
+        size_t hugePageAllocations;
+        //! Bytes currently held by the pool
+        size_t pooledBytes;
+    };
+
+    /**
+     * @param alignment Power of two alignment of all blocks.  At least sizeof(void*).
+     * @param hugePageThreshold Size above which huge pages are used.  0 to disable.
+     * @param poolBytes Upper limit of bytes kept by the pool.  0 to disable.
+     * @param maxPooledBlock Largest block size which is pooled.
+     * @throws std::invalid_argument for an invalid alignment.
+     */
+    explicit AlignedAllocator(std::size_t alignment = 64,
+                              std::size_t hugePageThreshold = 0,
+                              std::size_t poolBytes = 0,
+                              std::size_t maxPooledBlock = defaultMaxPooledBlock);
+    virtual ~AlignedAllocator();
+
+    virtual void* allocate(std::size_t bytes);
+    virtual void deallocate(void *ptr, std::size_t bytes);
+
+    Stats stats() const;
+    //! Release all blocks held by the pool
+    void trim();
+
+private:
+    enum { numClasses = 8*sizeof(std::size_t) };
+    int sizeClass(std::size_t bytes) const;
+    void* allocateAligned(std::size_t bytes);
+
+    const std::size_t alignment;
+    const std::size_t hugePageThreshold;
+    const std::size_t poolBytes;
+    const std::size_t maxPooledBlock;
+
+    mutable Mutex mutex;
+    // free blocks by log2(size)
+    std::vector<void*> pool[numClasses];
+    Stats counters;
+};
+
+namespace detail {
+
+//! Deleter for array storage obtained from an ArrayAllocator
+struct allocator_array_deleter {
+    ArrayAllocator *alloc;
+    std::size_t bytes;
+    allocator_array_deleter(ArrayAllocator *alloc, std::size_t bytes) :alloc(alloc), bytes(bytes) {}
+    void operator()(void *ptr) { alloc->deallocate(ptr, bytes); }
+};
+
+} // namespace detail
+
+}}
+
+#endif  /* ARRAYALLOCATOR_H */
@@ -0,0 +1,165 @@
+/* arrayKernels.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/**
+ *  Bulk operations on numeric arrays.
+ *
+ *  Statistics, affine (linear calibration) transforms, converting copies
+ *  and histograms of a shared_vector<const T>, eg. as returned by
+ *  PVValueArray<T>::view().  The loops are SIMD vectorized (SSE2, or AVX2
+ *  when the CPU supports it) and arrays above a configurable size may be
+ *  split across a pool of threads.  See ArrayKernels::setParallel().
+ *
+ *  Values of all numeric types are processed as double.
+ *  pvBoolean and pvString arrays are not supported.
+ *
+ *  The same pool of threads is used by the strided copy of
+ *  copy(PVScalarArray&, ...) from pvSubArrayCopy.h
+ */
+#ifndef ARRAYKERNELS_H
+#define ARRAYKERNELS_H
+
+#include <cmath>
+
+#include <pv/pvType.h>
+#include <pv/pvIntrospect.h>
+#include <pv/sharedVector.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+/** @brief Result of arrayStatistics()
+ *
+ * NaN elements are ignored by min and max, but propagate to sum and sumOfSquares.
+ * For an empty array min is +inf and max is -inf.
+ */
+struct ArrayStatistics {
+    size_t count;
+    double min;
+    double max;
+    double sum;
+    double sumOfSquares;
+
+    //! Arithmetic mean.  NaN for an empty array.
+    double mean() const { return sum/count; }
+    //! Root mean square.  NaN for an empty array.
+    double rms() const { return std::sqrt(sumOfSquares/count); }
+    //! Population standard deviation.  NaN for an empty array.
+    double stddev() const
+    {
+        double m = mean(), var = sumOfSquares/count - m*m;
+        return std::sqrt(var>0.0 ? var : 0.0);
+    }
+};
+
+/** @brief Configuration of the array kernels
+ */
+class epicsShareClass ArrayKernels {
+public:
+    enum {defaultThreshold = 256*1024};
+    /**
+     * Split arrays of at least threshold elements across up to 'threads' threads,
+     * including the calling thread.  By default (threads<=1) all work is done
+     * by the calling thread.
+     *
+     * Worker threads are created (or stopped) by this call.
+     * While the pool is busy, other callers work alone.
+     */
+    static void setParallel(unsigned threads, size_t threshold = defaultThreshold);
+    //! Number of threads used for large arrays.
+    static unsigned threads();
+    //! Name of the kernels selected for this CPU ("avx2", "sse2" or "generic")
+    static const char* implementation();
+};
+
+namespace detail {
+epicsShareFunc void arrayStatistics(ArrayStatistics& out, ScalarType type, const void *src, size_t count);
+epicsShareFunc void arrayAffine(ScalarType dtype, void *dest, ScalarType stype, const void *src,
+                                size_t count, double scale, double offset);
+epicsShareFunc void arrayConvert(ScalarType dtype, void *dest, ScalarType stype, const void *src,
+                                 size_t count);
+epicsShareFunc size_t arrayHistogram(uint64 *bins, size_t nbins, double lo, double hi,
+                                     ScalarType type, const void *src, size_t count);
+/** dest[i*destStride] = src[i*srcStride] for i in [0, count).
+ *
+ * Any type except pvString.  The regions must not overlap.
+ * Used by copy() from pvSubArrayCopy.h
+ */
+epicsShareFunc void arrayStridedCopy(ScalarType type, void *dest, size_t destStride,
+                                     const void *src, size_t srcStride, size_t count);
+}
+
+/** @brief Count, min, max, sum, and sum of squares of all elements
+ *
+ @code
+   ArrayStatistics S(arrayStatistics(pvDoubleArray->view()));
+   printf("mean %f rms %f\n", S.mean(), S.rms());
+ @endcode
+ */
+template<typename T>
+ArrayStatistics arrayStatistics(const shared_vector<const T>& src)
+{
+    ArrayStatistics ret;
+    detail::arrayStatistics(ret, (ScalarType)ScalarTypeID<T>::value, src.data(), src.size());
+    return ret;
+}
+
+/** @brief Linear transform.  dest[i] = src[i]*scale + offset
+ *
+ * Computed in double precision, then converted as by castUnsafe<TO>().
+ *
+ @code
+   PVDoubleArray::svector eng(arrayAffine<double>(pvRaw->view(), 0.5, -10.0));
+ @endcode
+ */
+template<typename TO, typename FROM>
+shared_vector<TO> arrayAffine(const shared_vector<const FROM>& src, double scale, double offset)
+{
+    shared_vector<TO> ret;
+    ret.resize_uninitialized(src.size());
+    detail::arrayAffine((ScalarType)ScalarTypeID<TO>::value, ret.data(),
+                        (ScalarType)ScalarTypeID<FROM>::value, src.data(),
+                        src.size(), scale, offset);
+    return ret;
+}
+
+/** @brief Copy with conversion, as by castUnsafeV(), but split across threads
+ *  for large arrays.
+ */
+template<typename TO, typename FROM>
+shared_vector<TO> arrayConvert(const shared_vector<const FROM>& src)
+{
+    shared_vector<TO> ret;
+    ret.resize_uninitialized(src.size());
+    detail::arrayConvert((ScalarType)ScalarTypeID<TO>::value, ret.data(),
+                         (ScalarType)ScalarTypeID<FROM>::value, src.data(),
+                         src.size());
+    return ret;
+}
+
+/** @brief Add the histogram of src to bins
+ *
+ * The range [lo, hi) is divided into bins.size() equal bins.
+ * Elements outside this range, and NaN, are not counted.
+ * Counts are added to the existing values of bins,
+ * which allows a histogram to be accumulated over several arrays.
+ *
+ * @returns The number of elements counted.
+ * @throws std::invalid_argument unless lo<hi
+ */
+template<typename T>
+size_t arrayHistogram(const shared_vector<const T>& src, double lo, double hi,
+                      shared_vector<uint64>& bins)
+{
+    bins.make_unique();
+    return detail::arrayHistogram(bins.data(), bins.size(), lo, hi,
+                                  (ScalarType)ScalarTypeID<T>::value,
+                                  src.data(), src.size());
+}
+
+}}
+
+#endif  /* ARRAYKERNELS_H */
@@ -195,6 +195,15 @@ inline double swap(double val)
 #define GET(T) get<T>()
 #endif
 
+class ArrayAllocator;
+
+namespace detail {
+// Storage of ByteBuffer, see pv/arrayAllocator.h
+// Sets alloc to the allocator used, if any.  Returns NULL on failure.
+epicsShareFunc char* allocateByteBuffer(ArrayAllocator*& alloc, std::size_t size);
+epicsShareFunc void freeByteBuffer(ArrayAllocator *alloc, char *buffer, std::size_t size);
+}
+
 /**
  * @brief This class implements a Bytebuffer that is like the java.nio.ByteBuffer.
  * 
@@ -214,7 +223,8 @@ public:
      * Must be one of EPICS_BYTE_ORDER,EPICS_ENDIAN_LITTLE,EPICS_ENDIAN_BIG.
      */
     ByteBuffer(std::size_t size, int byteOrder = EPICS_BYTE_ORDER) :
-        _buffer((char*)std::malloc(size)), _size(size),
+        _allocator(0),
+        _buffer(detail::allocateByteBuffer(_allocator, size)), _size(size),
         _reverseEndianess(byteOrder != EPICS_BYTE_ORDER),
         _reverseFloatEndianess(byteOrder != EPICS_FLOAT_WORD_ORDER),
         _wrapped(false)
@@ -233,6 +243,7 @@ public:
      * Must be one of EPICS_BYTE_ORDER,EPICS_ENDIAN_LITTLE,EPICS_ENDIAN_BIG.
      */
     ByteBuffer(char* buffer, std::size_t size, int byteOrder = EPICS_BYTE_ORDER) :
+        _allocator(0),
         _buffer(buffer), _size(size),
         _reverseEndianess(byteOrder != EPICS_BYTE_ORDER),
         _reverseFloatEndianess(byteOrder != EPICS_FLOAT_WORD_ORDER),
@@ -247,7 +258,7 @@ public:
      */
     ~ByteBuffer()
     {
-        if (_buffer && !_wrapped) std::free(_buffer);
+        if (_buffer && !_wrapped) detail::freeByteBuffer(_allocator, _buffer, _size);
     }
     /**
      * Set the byte order.
@@ -643,6 +654,7 @@ public:
 
     
 private:
+    ArrayAllocator* _allocator;
     char* const _buffer;
     char* _position;
     char* _limit;
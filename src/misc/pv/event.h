@@ -15,8 +15,10 @@
 #include <epicsEvent.h>
 #include <shareLib.h>
 
+#include <pv/pvdataConfig.h>
 #include <pv/pvType.h>
 #include <pv/sharedPtr.h>
+#include <pv/futex.h>
 
 
 namespace epics { namespace pvData { 
@@ -27,6 +29,7 @@ typedef std::tr1::shared_ptr<Event> EventPtr;
 /**
  * @brief C++ wrapper for epicsEvent from EPICS base.
  *
+ * When pvData is built with PVDATA_USE_FUTEX on Linux a FutexEvent is used instead.
  */
 class epicsShareClass Event {
 public:
@@ -61,7 +64,11 @@ public:
      */
     bool tryWait (); /* false if empty */
 private:
+#if defined(PVDATA_USE_FUTEX) && defined(PVDATA_HAVE_FUTEX)
+    FutexEvent impl;
+#else
     epicsEventId id;
+#endif
 };
 
 }}
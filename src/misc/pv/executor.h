@@ -10,12 +10,15 @@
 #define EXECUTOR_H
 
 #include <memory>
+#include <vector>
+#include <stdexcept>
 
 #include <pv/pvType.h>
 #include <pv/lock.h>
 #include <pv/event.h>
 #include <pv/thread.h>
 #include <pv/sharedPtr.h>
+#include <pv/timeFunction.h>
 
 #include <shareLib.h>
 
@@ -29,6 +32,8 @@ typedef std::tr1::shared_ptr<Executor> ExecutorPtr;
 /**
  * @brief A command to be called by Executor
  *
+ * The same command may be queued any number of times,
+ * and will be called once for each time it was queued.
  */
 class epicsShareClass Command {
 public:
@@ -43,18 +48,84 @@ public:
      * The command that is executed.
      */
     virtual void command() = 0;
-private:
-    CommandPtr next;
-    friend class Executor;
 };
 
 /**
  * @brief A class that executes commands.
  *
+ * Each command is queued in a scheduling class, which has a maximum latency.
+ * A command's deadline is the time it was queued plus this latency.
+ * The queued command with the earliest deadline is executed next,
+ * so commands of the same class are executed in the order they were queued,
+ * and no class can be starved.
+ * A running command is never interrupted.
+ *
+ * Queuing a command does not allocate once the queue of its class
+ * has grown to hold the largest backlog seen.
  */
 class epicsShareClass Executor : public Runnable{
 public:
     POINTER_DEFINITIONS(Executor);
+    /**
+     * @brief Tracks the completion of a group of commands.
+     *
+     * Passed to execute() or executeBatch() by the caller, who owns it.
+     * It must not be destroyed while any of its commands are queued.
+     * May be reused once wait() has returned.
+     */
+    class epicsShareClass Completion : private NoDefaultMethods {
+    public:
+        Completion();
+        ~Completion();
+        /**
+         * Wait until all commands have been executed.
+         */
+        void wait();
+        /**
+         * Wait up to timeOut seconds for all commands to be executed.
+         * @return (false,true) if (timeout, all done).
+         */
+        bool wait(double timeOut);
+        /**
+         * @return true if no commands are still queued or running.
+         */
+        bool isDone();
+        /**
+         * @return The number of commands which threw an exception.
+         */
+        size_t failures();
+    private:
+        friend class Executor;
+        void add(size_t n);
+        void complete(bool ok);
+        Mutex mutex;
+        Event done;
+        size_t pending;
+        size_t failed;
+    };
+    /**
+     * @brief Statistics of a scheduling class.
+     *
+     * Times are in seconds.
+     */
+    struct epicsShareClass ClassStats {
+        std::string name;
+        //! Configured maximum latency.
+        double maxLatency;
+        //! Number of commands currently queued.
+        size_t queued;
+        //! Number of commands executed.
+        uint64 executed;
+        //! Number of commands started after their deadline.
+        uint64 late;
+        //! Total and maximum time from queuing to start.
+        double latencyTotal, latencyMax;
+        //! Total and maximum time spent running.
+        double runTotal, runMax;
+        ClassStats();
+    };
+    //! The class used when none is given.  Its maximum latency is 1 second.
+    static const unsigned defaultClass = 0;
     /**
      * Constructor
      *
@@ -66,21 +137,114 @@ public:
      * Destructor
      */
     ~Executor();
+    /**
+     * 
+     * Add a scheduling class.
+     * @param name Name shown in statistics.
+     * @param maxLatency Seconds a command of this class may wait in the queue.
+     * @return The class number to be passed to execute() and executeBatch().
+     */
+    unsigned addClass(std::string const &name, double maxLatency);
     /**
      * 
      * Request to execute a command.
      * @param command A shared pointer to the command instance.
      */
     void execute(CommandPtr const &command);
+    /**
+     * 
+     * Request to execute a command and report its completion.
+     * @param command A shared pointer to the command instance.
+     * @param done Notified when the command has been executed.  May be NULL.
+     * @param cls Scheduling class returned by addClass().
+     */
+    void execute(CommandPtr const &command, Completion *done, unsigned cls = defaultClass);
+    /**
+     * 
+     * Request to call a function.
+     * Nothing is allocated.
+     * @param fn The function.
+     * @param arg The argument passed to fn.
+     * @param done Notified when the function has returned.  May be NULL.
+     * @param cls Scheduling class returned by addClass().
+     */
+    void execute(void (*fn)(void*), void *arg, Completion *done = 0, unsigned cls = defaultClass);
+    /**
+     * 
+     * Request to execute a sequence of commands.
+     * The queue is locked once for the whole sequence.
+     * @param first Iterator to the first CommandPtr.
+     * @param last Iterator past the last CommandPtr.
+     * @param done Notified when all of the commands have been executed.  May be NULL.
+     * @param cls Scheduling class returned by addClass().
+     * @throws std::invalid_argument if any of the commands is NULL.  Nothing is queued then.
+     */
+    template<typename Iter>
+    void executeBatch(Iter first, Iter last, Completion *done = 0, unsigned cls = defaultClass)
+    {
+        size_t n = 0;
+        for(Iter it = first; it!=last; ++it, ++n) {
+            if(!*it)
+                throw std::invalid_argument("Executor::executeBatch() NULL command");
+        }
+        Lock xx(mutex);
+        Queue& queue = getQueue(cls);
+        uint64 now = monotonicTimeNS();
+        // after this, push() can't throw, and all n are queued
+        reserve(queue, n);
+        for(; first!=last; ++first)
+            push(queue, *first, 0, 0, done, now);
+        // the executor thread can't pop before we unlock
+        if(done && n) done->add(n);
+    }
+    /**
+     * 
+     * Get the statistics of all scheduling classes, in the order they were added.
+     */
+    void getStats(std::vector<ClassStats>& stats);
+    /**
+     * 
+     * Clear the statistics of all scheduling classes.
+     */
+    void resetStats();
     /**
      * 
      * The thread run method.
      */
     virtual void run();
 private:
-    CommandPtr head;
-    CommandPtr tail;
-    epics::pvData::Mutex mutex;
+    struct Entry {
+        CommandPtr command;
+        void (*fn)(void*);
+        void *arg;
+        Completion *done;
+        uint64 queuedAt;
+    };
+    struct Queue {
+        std::string name;
+        uint64 maxLatency;
+        // ring buffer of queued commands
+        std::vector<Entry> ring;
+        size_t head;
+        size_t count;
+        // statistics, times in nanoseconds
+        uint64 executed, late;
+        uint64 latencyTotal, latencyMax;
+        uint64 runTotal, runMax;
+        Queue(std::string const &name, double maxLatency);
+        void resetStats();
+    };
+    // call with mutex locked
+    Queue& getQueue(unsigned cls);
+    // make room for n more entries
+    void reserve(Queue& queue, size_t n);
+    void push(Queue& queue, CommandPtr const &command, void (*fn)(void*), void *arg,
+              Completion *done, uint64 now);
+    std::vector<Queue> queues;
+    // total number of queued commands
+    size_t pending;
+    bool stopping;
+    epics::pvData::NamedMutex mutex;
     epics::pvData::Event moreWork;
     epics::pvData::Event stopped;
     epics::pvData::Thread thread;
@@ -0,0 +1,159 @@
+/* futex.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/**
+ *  Linux futex based Mutex and Event.
+ *
+ *  These are drop in replacements for epicsMutex and epicsEvent
+ *  which avoid the pthread condition variable used by EPICS base.
+ *  An uncontended lock/unlock or signal/wait is a single atomic
+ *  instruction. A contended acquire first spins for a short, adaptive,
+ *  number of iterations before parking the thread in the kernel.
+ *
+ *  Only available when PVDATA_HAVE_FUTEX is defined.
+ *  PVDATA_USE_FUTEX (see configure/CONFIG_SITE and pv/pvdataConfig.h)
+ *  makes epics::pvData::Mutex and epics::pvData::Event use them.
+ */
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#if defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#  define PVDATA_HAVE_FUTEX
+#endif
+
+#ifdef PVDATA_HAVE_FUTEX
+
+#include <pthread.h>
+
+#include <shareLib.h>
+
+#include <pv/noDefaultMethods.h>
+
+namespace epics { namespace pvData {
+
+/**
+ * @brief Recursive mutex which spins, then waits on a futex.
+ *
+ * Provides the same lock(), unlock() and tryLock() methods as epicsMutex.
+ */
+class epicsShareClass FutexMutex : private NoDefaultMethods {
+public:
+    FutexMutex() : state(0), spinEstimate(0), count(0), owner(0) {}
+    ~FutexMutex() {}
+    /**
+     * Take the lock.
+     * Recursive locks are supported but each lock must be matched with an unlock.
+     */
+    void lock()
+    {
+        pthread_t self = pthread_self();
+        if(__atomic_load_n(&owner, __ATOMIC_RELAXED)==self) {
+            count++;
+            return;
+        }
+        int expect = 0;
+        if(!__atomic_compare_exchange_n(&state, &expect, 1, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            lockSlow();
+        __atomic_store_n(&owner, self, __ATOMIC_RELAXED);
+        count = 1;
+    }
+    /**
+     * Release the lock.
+     */
+    void unlock()
+    {
+        if(--count) return;
+        __atomic_store_n(&owner, (pthread_t)0, __ATOMIC_RELAXED);
+        if(__atomic_exchange_n(&state, 0, __ATOMIC_RELEASE)==2)
+            wake();
+    }
+    /**
+     * Take the lock if this can be done without waiting.
+     * @return (false,true) if caller (does not have, has) the lock.
+     */
+    bool tryLock()
+    {
+        pthread_t self = pthread_self();
+        if(__atomic_load_n(&owner, __ATOMIC_RELAXED)==self) {
+            count++;
+            return true;
+        }
+        int expect = 0;
+        if(!__atomic_compare_exchange_n(&state, &expect, 1, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return false;
+        __atomic_store_n(&owner, self, __ATOMIC_RELAXED);
+        count = 1;
+        return true;
+    }
+    /** Upper bound for the number of spins before parking. */
+    static const int spinMax = 200;
+private:
+    void lockSlow();
+    void wake();
+    // 0 - unlocked, 1 - locked, 2 - locked and (maybe) waiters
+    int state;
+    // running average of spins needed to acquire
+    int spinEstimate;
+    // only accessed by the owner
+    unsigned count;
+    pthread_t owner;
+};
+
+/**
+ * @brief Binary semaphore with the semantics of epicsEvent.
+ *
+ * Any number of signal() calls are collapsed into a single event,
+ * which is consumed by one wait() or tryWait().
+ */
+class epicsShareClass FutexEvent : private NoDefaultMethods {
+public:
+    explicit FutexEvent(bool full = false) : state(full ? 1 : 0), waiters(0), spinEstimate(0) {}
+    ~FutexEvent() {}
+    /**
+     * Signal the event i.e. ensures that the next or current call to wait completes.
+     */
+    void signal()
+    {
+        __atomic_store_n(&state, 1, __ATOMIC_SEQ_CST);
+        if(__atomic_load_n(&waiters, __ATOMIC_SEQ_CST))
+            wake();
+    }
+    /**
+     * Wait for a signal.
+     * @return true
+     */
+    bool wait() { return tryWait() || waitSlow(-1.0); }
+    /**
+     * Wait for up to timeOut seconds.
+     * @param timeOut max number of seconds to wait
+     * @return (false, true) if (timeout, event signaled).
+     */
+    bool wait(double timeOut) { return tryWait() || waitSlow(timeOut<0.0 ? 0.0 : timeOut); }
+    /**
+     * Consume a pending signal, if any.
+     * @return (false, true) if (not signaled, event signaled).
+     */
+    bool tryWait()
+    {
+        int expect = 1;
+        return __atomic_compare_exchange_n(&state, &expect, 0, false,
+                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+private:
+    bool waitSlow(double timeOut);
+    void wake();
+    // 0 - empty, 1 - full
+    int state;
+    int waiters;
+    // running average of spins needed to see a signal
+    int spinEstimate;
+};
+
+}}
+
+#endif /* PVDATA_HAVE_FUTEX */
+#endif  /* FUTEX_H */
@@ -10,11 +10,20 @@
 #define LOCK_H
 
 #include <stdexcept>
+#include <iosfwd>
+#include <string>
+#include <vector>
 
 #include <epicsMutex.h>
 #include <shareLib.h>
 
+#include <pv/pvdataConfig.h>
 #include <pv/noDefaultMethods.h>
+#include <pv/futex.h>
+
+#ifdef PVDATA_LOCK_STATS
+#include <stdint.h>
+#endif
 
 
 /* This is based on item 14 of 
@@ -25,7 +34,106 @@
 
 namespace epics { namespace pvData { 
 
-typedef epicsMutex Mutex;
+#if defined(PVDATA_USE_FUTEX) && defined(PVDATA_HAVE_FUTEX)
+typedef FutexMutex BasicMutex;
+#else
+typedef epicsMutex BasicMutex;
+#endif
+
+#ifdef PVDATA_LOCK_STATS
+
+namespace detail {
+struct LockStatsEntry;
+}
+
+/**
+ * @brief Mutex which records contention statistics.
+ *
+ * Used as Mutex when pvData is built with PVDATA_LOCK_STATS.
+ * Statistics are kept per instance and reported per name.
+ * @see NamedMutex, reportLockStats()
+ */
+class epicsShareClass InstrumentedMutex : private NoDefaultMethods {
+public:
+    explicit InstrumentedMutex(const char *name = 0);
+    ~InstrumentedMutex();
+    void lock();
+    void unlock();
+    bool tryLock();
+private:
+    BasicMutex mutex;
+    detail::LockStatsEntry *stats;
+    // only accessed by the owner
+    unsigned depth;
+    uint64_t lockedAt;
+};
+
+typedef InstrumentedMutex Mutex;
+
+/**
+ * @brief Accumulated statistics of all mutexes with the same name.
+ *
+ * Times are in nanoseconds.
+ * Histogram bucket i counts times in [2^i, 2^(i+1)) nanoseconds.
+ */
+struct epicsShareClass LockStats {
+    enum {histogramSize = 32};
+    std::string name;
+    size_t instances;
+    uint64_t acquired;
+    uint64_t contended;
+    uint64_t waitTime;
+    uint64_t maxWait;
+    uint64_t holdTime;
+    uint64_t maxHold;
+    uint64_t waitHistogram[histogramSize];
+    uint64_t holdHistogram[histogramSize];
+    LockStats();
+};
+
+/**
+ * Snapshot of the statistics of all mutexes, grouped by name.
+ * @param stats Filled, sorted by decreasing number of contended acquisitions.
+ */
+epicsShareFunc void getLockStats(std::vector<LockStats>& stats);
+
+#else
+
+typedef BasicMutex Mutex;
+
+#endif
+
+/**
+ * @brief A Mutex with a name for contention statistics.
+ *
+ * The name is only used when built with PVDATA_LOCK_STATS.
+ * Otherwise this is a Mutex without any overhead.
+ */
+class NamedMutex : public Mutex {
+public:
+    explicit NamedMutex(const char *name)
+#ifdef PVDATA_LOCK_STATS
+        :Mutex(name)
+#endif
+    {
+#ifndef PVDATA_LOCK_STATS
+        (void)name;
+#endif
+    }
+};
+
+/**
+ * Print the most contended mutexes.
+ * Only prints a note unless built with PVDATA_LOCK_STATS.
+ * @param strm Output stream.
+ * @param top Maximum number of names to print.
+ */
+epicsShareFunc void reportLockStats(std::ostream& strm, size_t top = 10);
+
+/**
+ * Clear the statistics of all mutexes.
+ */
+epicsShareFunc void resetLockStats();
 
 /**
  * @brief A lock for multithreading
@@ -0,0 +1,89 @@
+/* mappedVector.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/**
+ *  shared_vector backed by a memory mapped file region.
+ *
+ *  Pages are read from the file lazily, when first accessed, and the
+ *  mapping is released with the last shared_vector referencing it.
+ *  So a large dataset can be given to PVValueArray<T>::replace()
+ *  without reading it into memory, or copying it.
+ *
+ *  Available on POSIX systems.  Elsewhere mapFileVector() throws std::logic_error.
+ */
+#ifndef MAPPEDVECTOR_H
+#define MAPPEDVECTOR_H
+
+#include <string>
+#include <stdexcept>
+
+#include <pv/pvType.h>
+#include <pv/sharedVector.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+//! How mapFileVector() maps, and uses, a file region.  Bit mask.
+enum MapFileFlags {
+    /** The mapping is read-only and shared with the page cache.
+     *  The vector is never unique(), so thaw() always copies.
+     */
+    mapReadOnly = 0,
+    /** The mapping is private and writable.  The file is never modified.
+     *  Pages are copied when first written, after a thaw() of the (unique) vector.
+     */
+    mapCopyOnWrite = 1,
+    //! Advise that the region will be read in order (MADV_SEQUENTIAL)
+    mapSequential = 2,
+    //! Advise that the region will be read in random order (MADV_RANDOM)
+    mapRandom = 4,
+    //! Start reading the region now (MADV_WILLNEED)
+    mapWillNeed = 8
+};
+
+namespace detail {
+/* Map 'bytes' bytes from 'offset' of a file.  bytes==(uint64)-1 maps to the end
+ * of the file, rounded down to a multiple of elemSize.
+ * The vector offset is in bytes, and a multiple of elemSize.
+ */
+epicsShareFunc
+shared_vector<const void> mapFileBytes(const std::string& filename, uint64 offset,
+                                       uint64 bytes, size_t elemSize, unsigned flags);
+}
+
+/** @brief Map a region of a file as an array of T
+ *
+ @code
+   // skip a 512 byte header
+   shared_vector<const double> wf(mapFileVector<double>("capture.dat", 512));
+   PVDoubleArrayPtr arr(...);
+   arr->replace(wf);
+ @endcode
+ *
+ * The file contents are used as is, in host byte order.
+ *
+ @param filename The file to map.
+ @param offset Byte offset in the file of the first element.  A multiple of sizeof(T).
+ @param count Number of elements.  The default maps all complete elements to the end of the file.
+ @param flags Bit mask of MapFileFlags
+ @throws std::invalid_argument if offset is not a multiple of sizeof(T)
+ @throws std::runtime_error if the file can't be opened or mapped, or is too short.
+ */
+template<typename T>
+shared_vector<const T>
+mapFileVector(const std::string& filename, uint64 offset = 0,
+              size_t count = (size_t)-1, unsigned flags = mapReadOnly|mapSequential)
+{
+    if(offset%sizeof(T))
+        throw std::invalid_argument("mapFileVector() offset must be a multiple of the element size");
+    uint64 bytes = count==(size_t)-1 ? (uint64)-1 : uint64(count)*sizeof(T);
+    shared_vector<const void> raw(detail::mapFileBytes(filename, offset, bytes, sizeof(T), flags));
+    return static_shared_vector_cast<const T>(raw);
+}
+
+}}
+
+#endif  /* MAPPEDVECTOR_H */
@@ -94,6 +94,18 @@ namespace epics {
             static std::string deserializeString(ByteBuffer* buffer,
                     DeserializableControl* control);
 
+            /**
+             * std::string deserialization helper method.
+             * As deserializeString(ByteBuffer*, DeserializableControl*),
+             * but assigns to an existing string, re-using its capacity.
+             *
+             * @param[out] value deserialized string
+             * @param[in] buffer deserialization buffer
+             * @param[in] control control
+             */
+            static void deserializeString(std::string& value, ByteBuffer* buffer,
+                    DeserializableControl* control);
+
         private:
             SerializeHelper() {};
             ~SerializeHelper() {};
@@ -57,6 +57,7 @@ namespace std {
         using std::static_pointer_cast;
         using std::dynamic_pointer_cast;
         using std::const_pointer_cast;
+        using std::get_deleter;
         using std::enable_shared_from_this;
     }
 }
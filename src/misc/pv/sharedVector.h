@@ -21,6 +21,7 @@
 #include "pv/pvIntrospect.h"
 #include "pv/typeCast.h"
 #include "pv/templateMeta.h"
+#include "pv/arrayAllocator.h"
 
 namespace epics { namespace pvData {
 
@@ -35,6 +36,59 @@ namespace detail {
     template<typename E>
     struct default_array_deleter {void operator()(E a){delete[] a;}};
 
+    /* Deleter of storage which must never be written (eg. a read-only
+     * file mapping).  The storage is released when owner is released.
+     * A vector of such storage is built with _shared_vector_readonly_tag,
+     * and is never unique(), so thaw() and make_unique() always copy.
+     */
+    struct readonly_storage_deleter {
+        std::tr1::shared_ptr<void> owner;
+        explicit readonly_storage_deleter(const std::tr1::shared_ptr<void>& owner) :owner(owner) {}
+        void operator()(const void*) { owner.reset(); }
+    };
+
+    /* Allocate uninitialized storage for n elements.
+     * With new[], except for numeric types when an ArrayAllocator is installed.
+     */
+    template<typename E>
+    struct array_storage {
+        static std::tr1::shared_ptr<E> allocate(size_t n)
+        {
+            return std::tr1::shared_ptr<E>(new E[n], default_array_deleter<E*>());
+        }
+    };
+
+    template<typename E>
+    struct allocator_array_storage {
+        static std::tr1::shared_ptr<E> allocate(size_t n)
+        {
+            ArrayAllocator *alloc = ArrayAllocator::get((ScalarType)ScalarTypeID<E>::value);
+            if(!alloc)
+                return std::tr1::shared_ptr<E>(new E[n], default_array_deleter<E*>());
+            if(n > ((size_t)-1)/sizeof(E))
+                throw std::bad_alloc();
+            size_t bytes = n*sizeof(E);
+            // on failure shared_ptr calls the deleter
+            return std::tr1::shared_ptr<E>(static_cast<E*>(alloc->allocate(bytes)),
+                                           allocator_array_deleter(alloc, bytes));
+        }
+    };
+
+#define PVD_ALLOCATOR_STORAGE(TYPE) \
+    template<> struct array_storage<TYPE> : public allocator_array_storage<TYPE> {}
+    PVD_ALLOCATOR_STORAGE(boolean);
+    PVD_ALLOCATOR_STORAGE(int8);
+    PVD_ALLOCATOR_STORAGE(int16);
+    PVD_ALLOCATOR_STORAGE(int32);
+    PVD_ALLOCATOR_STORAGE(int64);
+    PVD_ALLOCATOR_STORAGE(uint8);
+    PVD_ALLOCATOR_STORAGE(uint16);
+    PVD_ALLOCATOR_STORAGE(uint32);
+    PVD_ALLOCATOR_STORAGE(uint64);
+    PVD_ALLOCATOR_STORAGE(float);
+    PVD_ALLOCATOR_STORAGE(double);
+#undef PVD_ALLOCATOR_STORAGE
+
     // How values should be passed as arguments to shared_vector methods
     // really should use boost::call_traits
     template<typename T> struct call_with { typedef T type; };
@@ -45,6 +99,7 @@ namespace detail {
     struct _shared_vector_freeze_tag {};
     struct _shared_vector_thaw_tag {};
     struct _shared_vector_cast_tag {};
+    struct _shared_vector_readonly_tag {};
 
     /* All the parts of shared_vector which
      * don't need special handling for E=void
@@ -63,6 +118,8 @@ namespace detail {
         size_t m_count;
         //! Total number of elements between m_offset and the end of data
         size_t m_total;
+        //! The data must never be written.  Kept by copies, slices and casts.
+        bool m_readonly;
 
         /* invariants
          *  m_count <= m_total (enforced)
@@ -73,7 +130,7 @@ namespace detail {
 
         //! @brief Empty vector (not very interesting)
         shared_vector_base()
-            :m_sdata(), m_offset(0), m_count(0), m_total(0)
+            :m_sdata(), m_offset(0), m_count(0), m_total(0), m_readonly(false)
         {}
 
     protected:
@@ -94,30 +151,46 @@ namespace detail {
         template<typename A>
         shared_vector_base(A* v, size_t o, size_t c)
             :m_sdata(v, detail::default_array_deleter<A*>())
-            ,m_offset(o), m_count(c), m_total(c)
+            ,m_offset(o), m_count(c), m_total(c), m_readonly(false)
         {_null_input();}
 #else
         template<typename A>
         shared_vector_base(A v, size_t o, size_t c)
             :m_sdata(v, detail::default_array_deleter<A>())
-            ,m_offset(o), m_count(c), m_total(c)
+            ,m_offset(o), m_count(c), m_total(c), m_readonly(false)
         {_null_input();}
 #endif
         shared_vector_base(const std::tr1::shared_ptr<E>& d, size_t o, size_t c)
-            :m_sdata(d), m_offset(o), m_count(c), m_total(c)
+            :m_sdata(d), m_offset(o), m_count(c), m_total(c), m_readonly(false)
+        {_null_input();}
+
+        //! Storage which must never be written, see readonly_storage_deleter
+        shared_vector_base(const std::tr1::shared_ptr<E>& d, size_t o, size_t c,
+                           _shared_vector_readonly_tag)
+            :m_sdata(d), m_offset(o), m_count(c), m_total(c), m_readonly(!!d)
         {_null_input();}
 
 
         template<typename A, typename B>
         shared_vector_base(A d, B b, size_t o, size_t c)
-            :m_sdata(d,b), m_offset(o), m_count(c), m_total(c)
+            :m_sdata(d,b), m_offset(o), m_count(c), m_total(c), m_readonly(false)
         {_null_input();}
 
         shared_vector_base(const shared_vector_base& O)
             :m_sdata(O.m_sdata), m_offset(O.m_offset)
             ,m_count(O.m_count), m_total(O.m_total)
+            ,m_readonly(O.m_readonly)
         {}
 
+    protected:
+        // helper for the cast constructors
+        template<typename FROM>
+        void _cast_from(const shared_vector_base<FROM>& O)
+        {
+            m_readonly = O.m_readonly;
+        }
+    public:
+
     protected:
         typedef typename meta::strip_const<E>::type _E_non_const;
     public:
@@ -129,6 +202,7 @@ namespace detail {
             ,m_offset(O.m_offset)
             ,m_count(O.m_count)
             ,m_total(O.m_total)
+            ,m_readonly(false)
         {
             if(!O.unique())
                 throw std::runtime_error("Can't freeze non-unique vector");
@@ -141,12 +215,17 @@ namespace detail {
         shared_vector_base(shared_vector<const E>& O,
                            _shared_vector_thaw_tag)
             :m_sdata()
-            ,m_offset(O.m_offset)
-            ,m_count(O.m_count)
-            ,m_total(O.m_total)
+            ,m_offset(0)
+            ,m_count(0)
+            ,m_total(0)
+            ,m_readonly(false)
         {
             O.make_unique();
+            // make_unique() may have moved the data to offset 0
             m_sdata = std::tr1::const_pointer_cast<E>(O.m_sdata);
+            m_offset = O.m_offset;
+            m_count = O.m_count;
+            m_total = O.m_total;
             O.clear();
         }
 
@@ -158,6 +237,7 @@ namespace detail {
                 m_offset=o.m_offset;
                 m_count=o.m_count;
                 m_total=o.m_total;
+                m_readonly=o.m_readonly;
             }
             return *this;
         }
@@ -169,6 +249,7 @@ namespace detail {
                 std::swap(m_count, o.m_count);
                 std::swap(m_offset, o.m_offset);
                 std::swap(m_total, o.m_total);
+                std::swap(m_readonly, o.m_readonly);
             }
         }
 
@@ -177,10 +258,13 @@ namespace detail {
         void clear() {
             m_sdata.reset();
             m_offset = m_total = m_count = 0;
+            m_readonly = false;
         }
 
-        //! @brief Data is not shared?
-        bool unique() const {return !m_sdata || m_sdata.unique();}
+        //! @brief Data is not shared, and may be modified?
+        bool unique() const {
+            return !m_sdata || (m_sdata.unique() && !m_readonly);
+        }
 
 
         //! @brief Number of elements visible through this vector
@@ -276,14 +360,14 @@ public:
     //! @brief Empty vector (not very interesting)
     shared_vector() :base_t() {}
 
-    //! @brief Allocate (with new[]) a new vector of size c
+    //! @brief Allocate (with new[] or the ArrayAllocator) a new vector of size c
     explicit shared_vector(size_t c)
-        :base_t(new _E_non_const[c], 0, c)
+        :base_t(std::tr1::shared_ptr<E>(detail::array_storage<_E_non_const>::allocate(c)), 0, c)
     {}
 
-    //! @brief Allocate (with new[]) a new vector of size c and fill with value e
+    //! @brief Allocate (with new[] or the ArrayAllocator) a new vector of size c and fill with value e
     shared_vector(size_t c, param_type e)
-        :base_t(new _E_non_const[c], 0, c)
+        :base_t(std::tr1::shared_ptr<E>(detail::array_storage<_E_non_const>::allocate(c)), 0, c)
     {
         std::fill_n((_E_non_const*)this->m_sdata.get(), this->m_count, e);
     }
@@ -329,7 +413,7 @@ public:
         :base_t(std::tr1::static_pointer_cast<E>(src.dataPtr()),
                 src.dataOffset()/sizeof(E),
                 src.dataCount()/sizeof(E))
-    {}
+    {this->_cast_from(src);}
 
 
     shared_vector(shared_vector<typename base_t::_E_non_const>& O,
@@ -358,17 +442,13 @@ public:
         if(this->unique() && i<=this->m_total)
             return;
         size_t new_count = std::min(this->m_count, i);
-        _E_non_const* temp=new _E_non_const[i];
-        try{
-            std::copy(begin(), begin()+new_count, temp);
-            this->m_sdata.reset(temp, detail::default_array_deleter<E*>());
-        }catch(...){
-            delete[] temp;
-            throw;
-        }
+        std::tr1::shared_ptr<_E_non_const> temp(detail::array_storage<_E_non_const>::allocate(i));
+        std::copy(begin(), begin()+new_count, temp.get());
+        this->m_sdata = temp;
         this->m_offset = 0;
         this->m_count = new_count;
         this->m_total = i;
+        this->m_readonly = false;
     }
 
     /** @brief Grow or shrink array
@@ -383,7 +463,7 @@ public:
             make_unique();
             return;
         }
-        if(this->m_sdata && this->m_sdata.unique()) {
+        if(this->m_sdata && this->unique()) {
             // we have data and exclusive ownership of it
             if(i<=this->m_total) {
                 // We have room to grow (or shrink)!
@@ -393,21 +473,17 @@ public:
         }
         // must re-allocate :(
         size_t new_total = std::max(this->m_total, i);
-        _E_non_const* temp=new _E_non_const[new_total];
-        try{
-            // Copy as much as possible from old,
-            // remaining elements are uninitialized.
-            std::copy(begin(),
-                      begin()+std::min(i,this->size()),
-                      temp);
-            this->m_sdata.reset(temp, detail::default_array_deleter<pointer>());
-        }catch(...){
-            delete[] temp;
-            throw;
-        }
+        std::tr1::shared_ptr<_E_non_const> temp(detail::array_storage<_E_non_const>::allocate(new_total));
+        // Copy as much as possible from old,
+        // remaining elements are uninitialized.
+        std::copy(begin(),
+                  begin()+std::min(i,this->size()),
+                  temp.get());
+        this->m_sdata = temp;
         this->m_offset= 0;
         this->m_count = i;
         this->m_total = new_total;
+        this->m_readonly = false;
     }
 
     /** @brief Grow (and fill) or shrink array.
@@ -422,10 +498,48 @@ public:
         }
     }
 
+    /** @brief Set size without preserving contents.
+     *
+     * The existing array is re-used if it is uniquely owned and
+     * has capacity for i elements.  Otherwise a new array is allocated
+     * and nothing is copied.  Either way the element values are unspecified
+     * afterwards (uninitialized for POD types).
+     *
+     * Use in place of resize() when all elements will be overwritten.
+     */
+    void resize_uninitialized(size_t i) {
+        if(this->m_sdata && this->unique() && i<=this->m_total) {
+            this->m_count = i;
+            return;
+        }
+        if(i==0) {
+            this->clear();
+            return;
+        }
+        this->m_sdata = detail::array_storage<_E_non_const>::allocate(i);
+        this->m_offset = 0;
+        this->m_count = this->m_total = i;
+        this->m_readonly = false;
+    }
+
+    /** @brief Grow or shrink array, with geometric re-allocation.
+     *
+     * As resize(), except that when growth needs a new array its
+     * capacity is at least 1.5 times the current capacity.
+     * So a sequence of calls with increasing sizes (eg. appending)
+     * copies each element a constant number of times on average.
+     */
+    void resize_amortized(size_t i) {
+        if(i>this->m_total)
+            reserve(std::max(i, this->m_total + this->m_total/2));
+        resize(i);
+    }
+
     /** @brief Ensure (by copying) that this shared_vector is the sole
      *  owner of the data array.
      *
-     * If a copy is needed, memory is allocated with new[].  If this is
+     * If a copy is needed, memory is allocated with new[], or the
+     * ArrayAllocator installed for this type.  If this is
      * not desirable then do something like the following.
      @code
        shared_vector<E> original(...);
@@ -442,17 +556,13 @@ public:
     void make_unique() {
         if(this->unique())
             return;
-        _E_non_const *d = new _E_non_const[this->m_total];
-        try {
-            std::copy(this->m_sdata.get()+this->m_offset,
-                      this->m_sdata.get()+this->m_offset+this->m_count,
-                      d);
-        }catch(...){
-            delete[] d;
-            throw;
-        }
-        this->m_sdata.reset(d, detail::default_array_deleter<E*>());
+        std::tr1::shared_ptr<_E_non_const> d(detail::array_storage<_E_non_const>::allocate(this->m_total));
+        std::copy(this->m_sdata.get()+this->m_offset,
+                  this->m_sdata.get()+this->m_offset+this->m_count,
+                  d.get());
+        this->m_sdata = d;
         this->m_offset=0;
+        this->m_readonly = false;
     }
 
 
@@ -576,6 +686,13 @@ public:
     shared_vector(const std::tr1::shared_ptr<E1>& d, size_t o, size_t c)
         :base_t(d,o,c), m_vtype((ScalarType)-1) {}
 
+    //! @internal
+    //! Storage which must never be written, see detail::readonly_storage_deleter
+    template<typename E1>
+    shared_vector(const std::tr1::shared_ptr<E1>& d, size_t o, size_t c,
+                  detail::_shared_vector_readonly_tag t)
+        :base_t(d,o,c,t), m_vtype((ScalarType)-1) {}
+
     shared_vector(const shared_vector& o)
         :base_t(o), m_vtype(o.m_vtype) {}
 
@@ -588,7 +705,7 @@ public:
                 src.dataOffset()*sizeof(FROM),
                 src.dataCount()*sizeof(FROM))
         ,m_vtype((ScalarType)ScalarTypeID<FROM>::value)
-    {}
+    {this->_cast_from(src);}
 
     shared_vector(shared_vector<void>& O,
                   detail::_shared_vector_freeze_tag t)
@@ -933,6 +1050,10 @@ std::ostream& operator<<(std::ostream& strm, const epics::pvData::shared_vector<
  *
  * The slice() method selects a sub-set of the shared_vector.
  *
+ * resize_uninitialized() changes the size without preserving contents,
+ * re-using the array when possible.  resize_amortized() grows
+ * the capacity geometrically.
+ *
  * The low level accessors dataPtr(), dataOffset(), dataCount(),
  * and dataTotal().
  *
@@ -10,6 +10,7 @@
 #define TIMEFUNCTION_H
 
 #include <pv/sharedPtr.h>
+#include <pv/pvType.h>
 
 #include <shareLib.h>
 
@@ -39,6 +40,27 @@ public:
 };
 
 
+/**
+ * @brief Distribution of the time per call measured by TimeFunction::timeCalls().
+ *
+ * Times are in seconds.
+ */
+struct epicsShareClass TimeStatistics {
+    //! Number of timed batches of calls.
+    size_t samples;
+    //! Calls per batch.
+    size_t batch;
+    //! Total number of timed calls.
+    uint64 calls;
+    double mean;
+    double min;
+    double p50;
+    double p99;
+    double p999;
+    double max;
+    TimeStatistics();
+};
+
 /** 
  * @brief Class for measuring time it takes to execute a function.
  *
@@ -61,9 +83,26 @@ public:
      * Note that the function may be called many times.
      */
     double timeCall();
+    /**
+     * Time the function and collect the distribution of the time per call.
+     * The function is called in batches, each taking at least minBatchTime.
+     * The time of each batch, divided by the batch size, is one sample.
+     * @param warmup seconds to call the function before timing starts.
+     * @param duration seconds of timed calls.
+     * @param minBatchTime minimum seconds per batch.
+     * @return The statistics of the samples.
+     * @throws std::invalid_argument if minBatchTime is not positive, or a time is negative.
+     */
+    TimeStatistics timeCalls(double warmup, double duration, double minBatchTime = 1e-5);
 private:
     TimeFunctionRequesterPtr requester;
 };
+
+/**
+ * Read a monotonic clock, for measuring intervals.
+ * @return nanoseconds since an arbitrary point in the past.
+ */
+epicsShareFunc uint64 monotonicTimeNS();
   
 
 }}
@@ -121,7 +121,7 @@ public:
 private:
     void addElement(TimerCallbackPtr const &timerCallback);
     TimerCallbackPtr head;
-    Mutex mutex;
+    NamedMutex mutex;
     Event waitForWork;
     Event waitForDone;
     bool alive;
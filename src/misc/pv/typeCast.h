@@ -34,6 +34,27 @@ namespace detail {
     epicsShareExtern void parseToPOD(const std::string&, float *out);
     epicsShareExtern void parseToPOD(const std::string&, double *out);
 
+    /* formatPOD writes the same characters as std::ostream with default
+     * flags and precision (printf "%d" and "%g") into a buffer of at least
+     * formatPODSize chars.  No nil is appended.
+     * Returns a pointer past the last char written.
+     */
+    enum {formatPODSize = 32};
+    epicsShareExtern char* formatPOD(char *buf, boolean val);
+    epicsShareExtern char* formatPOD(char *buf, int8 val);
+    epicsShareExtern char* formatPOD(char *buf, uint8 val);
+    epicsShareExtern char* formatPOD(char *buf, int16_t val);
+    epicsShareExtern char* formatPOD(char *buf, uint16_t val);
+    epicsShareExtern char* formatPOD(char *buf, int32_t val);
+    epicsShareExtern char* formatPOD(char *buf, uint32_t val);
+    epicsShareExtern char* formatPOD(char *buf, int64_t val);
+    epicsShareExtern char* formatPOD(char *buf, uint64_t val);
+    epicsShareExtern char* formatPOD(char *buf, float val);
+    epicsShareExtern char* formatPOD(char *buf, double val);
+
+    //! Name of the castUnsafeV() kernels selected for this CPU ("generic" or "avx2")
+    epicsShareExtern const char* castUnsafeVKernels();
+
     /* want to pass POD types by value,
      * and std::string by const reference
      */
@@ -89,11 +110,8 @@ namespace detail {
     template<typename FROM>
     struct cast_helper<std::string, FROM, typename meta::not_same_type<std::string,FROM>::type> {
         static std::string op(FROM from) {
-            std::ostringstream strm;
-            strm << print_convolute<FROM>::op(from);
-            if(strm.fail())
-                throw std::runtime_error("Cast to string failed");
-            return strm.str();
+            char buf[formatPODSize];
+            return std::string(buf, formatPOD(buf, from));
         }
     };
 
@@ -0,0 +1,33 @@
+#!/usr/bin/env perl
+#
+# Copyright information and license terms for this software can be
+# found in the file LICENSE that is included with the distribution
+#
+# Writes pv/pvdataConfig.h from the build options set in configure/CONFIG_SITE.
+#
+# usage: pvdataConfig.pl <output file> NAME=VALUE ...
+#
+# Each NAME with VALUE YES is defined in the output.
+
+use strict;
+use warnings;
+
+my $out = shift or die "usage: $0 <output file> NAME=VALUE ...\n";
+
+my $text = "/* Generated by pvdataConfig.pl from configure/CONFIG_SITE.  Do not edit. */\n"
+         . "#ifndef PVDATACONFIG_H\n"
+         . "#define PVDATACONFIG_H\n\n";
+foreach my $arg (@ARGV) {
+    my ($name, $value) = split /=/, $arg, 2;
+    $value = '' unless defined $value;
+    if ($value eq 'YES') {
+        $text .= "#define $name\n";
+    } else {
+        $text .= "/* #undef $name */\n";
+    }
+}
+$text .= "\n#endif  /* PVDATACONFIG_H */\n";
+
+open(my $fh, '>', $out) or die "$0: can't create $out: $!\n";
+print $fh $text;
+close($fh) or die "$0: can't write $out: $!\n";
@@ -141,6 +141,38 @@ namespace epics {
             else
                 return emptyStringtring;
         }
+
+        void SerializeHelper::deserializeString(string& value, ByteBuffer* buffer,
+                DeserializableControl* control) {
+
+            std::size_t size = SerializeHelper::readSize(buffer, control);
+            if(size==(size_t)-1) {	// TODO null strings check, to be removed in the future
+                value.clear();
+            }
+            else if (buffer->getRemaining()>=size)
+            {
+                std::size_t pos = buffer->getPosition();
+                value.assign(buffer->getArray()+pos, size);
+                buffer->setPosition(pos+size);
+            }
+            else
+            {
+                value.clear();
+                value.reserve(size);
+                std::size_t i = 0;
+                while(true) {
+                    std::size_t toRead = min(size-i, buffer->getRemaining());
+                    std::size_t pos = buffer->getPosition();
+                    value.append(buffer->getArray()+pos, toRead);
+                    buffer->setPosition(pos+toRead);
+                    i += toRead;
+                    if(i<size)
+                        control->ensureData(1); // at least one
+                    else
+                        break;
+                }
+            }
+        }
     }
 }
 
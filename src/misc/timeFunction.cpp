@@ -11,6 +11,14 @@
 #include <cstddef>
 #include <string>
 #include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 #include <epicsTime.h>
 
@@ -48,4 +56,78 @@ double TimeFunction::timeCall()
 
 }
 
+TimeStatistics::TimeStatistics()
+: samples(0),
+  batch(0),
+  calls(0),
+  mean(0.0),
+  min(0.0),
+  p50(0.0),
+  p99(0.0),
+  p999(0.0),
+  max(0.0)
+{}
+
+TimeStatistics TimeFunction::timeCalls(double warmup, double duration, double minBatchTime)
+{
+    if(!(minBatchTime>0.0))
+        throw std::invalid_argument("TimeFunction::timeCalls() minBatchTime must be positive");
+    if(!(warmup>=0.0 && duration>=0.0))
+        throw std::invalid_argument("TimeFunction::timeCalls() negative time");
+    TimeStatistics stats;
+
+    // find a batch size which takes at least minBatchTime
+    size_t batch = 1;
+    while(true) {
+        uint64 start = monotonicTimeNS();
+        for(size_t i=0; i<batch; i++) requester->function();
+        if((monotonicTimeNS()-start)*1e-9>=minBatchTime) break;
+        batch *= 2;
+    }
+
+    uint64 end = monotonicTimeNS() + uint64(warmup*1e9);
+    while(monotonicTimeNS()<end) {
+        for(size_t i=0; i<batch; i++) requester->function();
+    }
+
+    std::vector<double> samples;
+    // an estimate, bounded for a very short minBatchTime
+    samples.reserve(size_t(std::min(duration/minBatchTime, 1e6))+1);
+    uint64 start = monotonicTimeNS();
+    end = start + uint64(duration*1e9);
+    uint64 now = start;
+    do {
+        uint64 prev = now;
+        for(size_t i=0; i<batch; i++) requester->function();
+        now = monotonicTimeNS();
+        samples.push_back((now-prev)*1e-9/batch);
+    } while(now<end);
+
+    std::sort(samples.begin(), samples.end());
+    size_t N = samples.size();
+    stats.samples = N;
+    stats.batch = batch;
+    stats.calls = uint64(N)*batch;
+    stats.mean = (now-start)*1e-9/stats.calls;
+    stats.min = samples[0];
+    stats.p50 = samples[N/2];
+    stats.p99 = samples[std::min(N-1, size_t(N*0.99))];
+    stats.p999 = samples[std::min(N-1, size_t(N*0.999))];
+    stats.max = samples[N-1];
+    return stats;
+}
+
+uint64 monotonicTimeNS()
+{
+#if defined(_POSIX_TIMERS) && _POSIX_TIMERS>0 && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64(ts.tv_sec)*1000000000u + ts.tv_nsec;
+#else
+    epicsTimeStamp ts;
+    epicsTimeGetCurrent(&ts);
+    return uint64(ts.secPastEpoch)*1000000000u + ts.nsec;
+#endif
+}
+
 }}
@@ -31,7 +31,8 @@ TimerCallback::TimerCallback()
 }
 
 Timer::Timer(string threadName,ThreadPriority priority)
-: waitForWork(false),
+: mutex("Timer"),
+  waitForWork(false),
   waitForDone(false),
   alive(true),
   thread(threadName,priority,this)
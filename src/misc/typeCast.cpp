@@ -6,6 +6,8 @@
 #include <algorithm>
 #include <sstream>
 
+#include <float.h>
+
 #include <epicsConvert.h>
 
 #define epicsExportSharedSymbols
@@ -16,6 +18,17 @@ using epics::pvData::ScalarType;
 using epics::pvData::pvString;
 using std::string;
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(__AVX2__) \
+    && (defined(__clang__) || __GNUC__*100+__GNUC_MINOR__>=409)
+#  define CASTV_AVX2
+#endif
+
+#ifdef CASTV_AVX2
+#  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
 namespace {
 
 static void noconvert(size_t, void*, const void*)
@@ -51,6 +64,19 @@ static void castVTyped(size_t count, void *draw, const void *sraw)
     }
 }
 
+/* Printing can't fail.  Assign in place so that the existing
+ * capacity of the destination strings is reused.
+ */
+template<typename FROM>
+static void printV(size_t count, void *draw, const void *sraw)
+{
+    string *dest=(string*)draw;
+    const FROM *src=(const FROM*)sraw;
+    char buf[epics::pvData::detail::formatPODSize];
+    for(size_t i=0; i<count; i++)
+        dest[i].assign(buf, epics::pvData::detail::formatPOD(buf, src[i]));
+}
+
 template<typename T>
 static void copyV(size_t count, void *draw, const void *sraw)
 {
@@ -59,182 +85,179 @@ static void copyV(size_t count, void *draw, const void *sraw)
     std::copy(src, src+count, dest);
 }
 
+/* Numeric to numeric conversions can't fail, so the loop needs no
+ * exception handling and is written so that the compiler can vectorize it.
+ */
+template<typename TO, typename FROM>
+struct castLoop {
+    static FORCE_INLINE void op(size_t count, TO *dest, const FROM *src)
+    {
+        for(size_t i=0; i<count; i++)
+            dest[i] = castUnsafe<TO,FROM>(src[i]);
+    }
+};
+
+template<typename T>
+struct castLoop<T,T> {
+    static FORCE_INLINE void op(size_t count, T *dest, const T *src)
+    {
+        std::copy(src, src+count, dest);
+    }
+};
+
+/* Same result as epicsConvertDoubleToFloat(), which is not inline.
+ * Values are clipped to [FLT_MIN, FLT_MAX] with the sign preserved.
+ * Zero (of either sign) gives +0, and NaN is passed through.
+ */
+FORCE_INLINE float convertDoubleToFloat(double val)
+{
+    double mag = val<0.0 ? -val : val;
+    if(mag>FLT_MAX) mag = FLT_MAX;
+    else if(mag<FLT_MIN) mag = FLT_MIN;
+    return float(val==0.0 ? 0.0 : val<0.0 ? -mag : mag);
+}
+
+#ifdef __SSE2__
+/* The comparisons above may trap, so the compiler won't turn them into
+ * selects.  Do it by hand.  MINPD/MAXPD return the second operand
+ * when either is NaN, so NaN passes through.
+ */
+FORCE_INLINE __m128d clipDoubleToFloat(__m128d val)
+{
+    const __m128d signbit = _mm_set1_pd(-0.0);
+    __m128d mag = _mm_andnot_pd(signbit, val);
+    mag = _mm_min_pd(_mm_set1_pd(FLT_MAX), mag);
+    mag = _mm_max_pd(_mm_set1_pd(FLT_MIN), mag);
+    mag = _mm_or_pd(mag, _mm_and_pd(signbit, val));
+    return _mm_andnot_pd(_mm_cmpeq_pd(val, _mm_setzero_pd()), mag);
+}
+#endif
+
+template<>
+struct castLoop<float,double> {
+    static FORCE_INLINE void op(size_t count, float *dest, const double *src)
+    {
+        size_t i=0;
+#ifdef __SSE2__
+        for(; i+2<=count; i+=2)
+            _mm_storel_pi((__m64*)(dest+i), _mm_cvtpd_ps(clipDoubleToFloat(_mm_loadu_pd(src+i))));
+#endif
+        for(; i<count; i++)
+            dest[i] = convertDoubleToFloat(src[i]);
+    }
+};
+
+template<typename TO, typename FROM>
+static void castVNumeric(size_t count, void *draw, const void *sraw)
+{
+    castLoop<TO,FROM>::op(count, (TO*)draw, (const FROM*)sraw);
+}
+
+#ifdef CASTV_AVX2
+/* The same loops compiled for AVX2, selected at runtime */
+template<typename TO, typename FROM>
+__attribute__((target("avx2")))
+static void castVNumericAVX2(size_t count, void *draw, const void *sraw)
+{
+    castLoop<TO,FROM>::op(count, (TO*)draw, (const FROM*)sraw);
+}
+
+template<>
+__attribute__((target("avx2")))
+void castVNumericAVX2<float,double>(size_t count, void *draw, const void *sraw)
+{
+    float *dest=(float*)draw;
+    const double *src=(const double*)sraw;
+    const __m256d signbit = _mm256_set1_pd(-0.0);
+    const __m256d fltmax = _mm256_set1_pd(FLT_MAX), fltmin = _mm256_set1_pd(FLT_MIN);
+    size_t i=0;
+    for(; i+4<=count; i+=4) {
+        __m256d val = _mm256_loadu_pd(src+i);
+        __m256d mag = _mm256_andnot_pd(signbit, val);
+        mag = _mm256_min_pd(fltmax, mag);
+        mag = _mm256_max_pd(fltmin, mag);
+        mag = _mm256_or_pd(mag, _mm256_and_pd(signbit, val));
+        mag = _mm256_andnot_pd(_mm256_cmp_pd(val, _mm256_setzero_pd(), _CMP_EQ_OQ), mag);
+        _mm_storeu_ps(dest+i, _mm256_cvtpd_ps(mag));
+    }
+    for(; i<count; i++)
+        dest[i] = convertDoubleToFloat(src[i]);
+}
+#endif
+
 typedef void (*convertfn)(size_t, void*, const void*);
+typedef convertfn convertTable[pvString+1][pvString+1];
 
-/* lookup table of converter functions.
+#define NUMERIC_ROW(KERNEL, TO) \
+    {&noconvert, \
+     &KERNEL<TO, int8_t>, \
+     &KERNEL<TO, int16_t>, \
+     &KERNEL<TO, int32_t>, \
+     &KERNEL<TO, int64_t>, \
+     &KERNEL<TO, uint8_t>, \
+     &KERNEL<TO, uint16_t>, \
+     &KERNEL<TO, uint32_t>, \
+     &KERNEL<TO, uint64_t>, \
+     &KERNEL<TO, float>, \
+     &KERNEL<TO, double>, \
+     &castVTyped<TO, string>, \
+    }
+
+#define CONVERT_TABLE(KERNEL) \
+{ \
+    /* to pvBoolean */ \
+    {&copyV<epics::pvData::boolean>, \
+     &noconvert, &noconvert, &noconvert, &noconvert, &noconvert, \
+     &noconvert, &noconvert, &noconvert, &noconvert, &noconvert, \
+     &castVTyped<epics::pvData::boolean, string>, \
+    }, \
+    NUMERIC_ROW(KERNEL, int8_t), \
+    NUMERIC_ROW(KERNEL, int16_t), \
+    NUMERIC_ROW(KERNEL, int32_t), \
+    NUMERIC_ROW(KERNEL, int64_t), \
+    NUMERIC_ROW(KERNEL, uint8_t), \
+    NUMERIC_ROW(KERNEL, uint16_t), \
+    NUMERIC_ROW(KERNEL, uint32_t), \
+    NUMERIC_ROW(KERNEL, uint64_t), \
+    NUMERIC_ROW(KERNEL, float), \
+    NUMERIC_ROW(KERNEL, double), \
+    /* to pvString */ \
+    {&printV<epics::pvData::boolean>, \
+     &printV<int8_t>, \
+     &printV<int16_t>, \
+     &printV<int32_t>, \
+     &printV<int64_t>, \
+     &printV<uint8_t>, \
+     &printV<uint16_t>, \
+     &printV<uint32_t>, \
+     &printV<uint64_t>, \
+     &printV<float>, \
+     &printV<double>, \
+     &copyV<string>, \
+    }, \
+}
+
+/* lookup tables of converter functions.
  * first dimension is TO, second is FROM
  */
-static convertfn converters[pvString+1][pvString+1] =
+static convertTable converters = CONVERT_TABLE(castVNumeric);
+
+#ifdef CASTV_AVX2
+static convertTable convertersAVX2 = CONVERT_TABLE(castVNumericAVX2);
+#endif
+
+#undef CONVERT_TABLE
+#undef NUMERIC_ROW
+
+const convertTable& selectConverters()
 {
-    // to pvBoolean
-    { &copyV<epics::pvData::boolean>,
-      &noconvert,
-      &noconvert,
-      &noconvert,
-      &noconvert,
-      &noconvert,
-      &noconvert,
-      &noconvert,
-      &noconvert,
-      &noconvert,
-      &noconvert,
-      &castVTyped<epics::pvData::boolean, string>,
-    },
-    // to pvByte
-    {&noconvert,
-     &copyV<int8_t>,
-     &castVTyped<int8_t, int16_t>,
-     &castVTyped<int8_t, int32_t>,
-     &castVTyped<int8_t, int64_t>,
-     &castVTyped<int8_t, uint8_t>,
-     &castVTyped<int8_t, uint16_t>,
-     &castVTyped<int8_t, uint32_t>,
-     &castVTyped<int8_t, uint64_t>,
-     &castVTyped<int8_t, float>,
-     &castVTyped<int8_t, double>,
-     &castVTyped<int8_t, string>,
-    },
-    // to pvShort
-    {&noconvert,
-     &castVTyped<int16_t, int8_t>,
-     &copyV<int16_t>,
-     &castVTyped<int16_t, int32_t>,
-     &castVTyped<int16_t, int64_t>,
-     &castVTyped<int16_t, uint8_t>,
-     &castVTyped<int16_t, uint16_t>,
-     &castVTyped<int16_t, uint32_t>,
-     &castVTyped<int16_t, uint64_t>,
-     &castVTyped<int16_t, float>,
-     &castVTyped<int16_t, double>,
-     &castVTyped<int16_t, string>,
-    },
-    // to pvInt
-    {&noconvert,
-     &castVTyped<int32_t, int8_t>,
-     &castVTyped<int32_t, int16_t>,
-     &copyV<int32_t>,
-     &castVTyped<int32_t, int64_t>,
-     &castVTyped<int32_t, uint8_t>,
-     &castVTyped<int32_t, uint16_t>,
-     &castVTyped<int32_t, uint32_t>,
-     &castVTyped<int32_t, uint64_t>,
-     &castVTyped<int32_t, float>,
-     &castVTyped<int32_t, double>,
-     &castVTyped<int32_t, string>,
-    },
-    // to pvLong
-    {&noconvert,
-     &castVTyped<int64_t, int8_t>,
-     &castVTyped<int64_t, int16_t>,
-     &castVTyped<int64_t, int32_t>,
-     &copyV<int64_t>,
-     &castVTyped<int64_t, uint8_t>,
-     &castVTyped<int64_t, uint16_t>,
-     &castVTyped<int64_t, uint32_t>,
-     &castVTyped<int64_t, uint64_t>,
-     &castVTyped<int64_t, float>,
-     &castVTyped<int64_t, double>,
-     &castVTyped<int64_t, string>,
-    },
-    // to pvUByte
-    {&noconvert,
-     &castVTyped<uint8_t, int8_t>,
-     &castVTyped<uint8_t, int16_t>,
-     &castVTyped<uint8_t, int32_t>,
-     &castVTyped<uint8_t, uint64_t>,
-     &copyV<uint8_t>,
-     &castVTyped<uint8_t, uint16_t>,
-     &castVTyped<uint8_t, uint32_t>,
-     &castVTyped<uint8_t, uint64_t>,
-     &castVTyped<uint8_t, float>,
-     &castVTyped<uint8_t, double>,
-     &castVTyped<uint8_t, string>,
-    },
-    // to pvUShort
-    {&noconvert,
-     &castVTyped<uint16_t, int8_t>,
-     &castVTyped<uint16_t, int16_t>,
-     &castVTyped<uint16_t, int32_t>,
-     &castVTyped<uint16_t, uint64_t>,
-     &castVTyped<uint16_t, uint8_t>,
-     &copyV<uint16_t>,
-     &castVTyped<uint16_t, uint32_t>,
-     &castVTyped<uint16_t, uint64_t>,
-     &castVTyped<uint16_t, float>,
-     &castVTyped<uint16_t, double>,
-     &castVTyped<uint16_t, string>,
-    },
-    // to pvUInt
-    {&noconvert,
-     &castVTyped<uint32_t, int8_t>,
-     &castVTyped<uint32_t, int16_t>,
-     &castVTyped<uint32_t, int32_t>,
-     &castVTyped<uint32_t, uint64_t>,
-     &castVTyped<uint32_t, uint8_t>,
-     &castVTyped<uint32_t, uint16_t>,
-     &copyV<uint32_t>,
-     &castVTyped<uint32_t, uint64_t>,
-     &castVTyped<uint32_t, float>,
-     &castVTyped<uint32_t, double>,
-     &castVTyped<uint32_t, string>,
-    },
-    // to pvULong
-    {&noconvert,
-     &castVTyped<uint64_t, int8_t>,
-     &castVTyped<uint64_t, int16_t>,
-     &castVTyped<uint64_t, int32_t>,
-     &castVTyped<uint64_t, uint64_t>,
-     &castVTyped<uint64_t, uint8_t>,
-     &castVTyped<uint64_t, uint16_t>,
-     &castVTyped<uint64_t, uint32_t>,
-     &copyV<uint64_t>,
-     &castVTyped<uint64_t, float>,
-     &castVTyped<uint64_t, double>,
-     &castVTyped<uint64_t, string>,
-    },
-    // to pvFloat
-    {&noconvert,
-     &castVTyped<float, int8_t>,
-     &castVTyped<float, int16_t>,
-     &castVTyped<float, int32_t>,
-     &castVTyped<float, uint64_t>,
-     &castVTyped<float, uint8_t>,
-     &castVTyped<float, uint16_t>,
-     &castVTyped<float, uint32_t>,
-     &castVTyped<float, uint64_t>,
-     &copyV<float>,
-     &castVTyped<float, double>,
-     &castVTyped<float, string>,
-    },
-    // to pvDouble
-    {&noconvert,
-     &castVTyped<double, int8_t>,
-     &castVTyped<double, int16_t>,
-     &castVTyped<double, int32_t>,
-     &castVTyped<double, uint64_t>,
-     &castVTyped<double, uint8_t>,
-     &castVTyped<double, uint16_t>,
-     &castVTyped<double, uint32_t>,
-     &castVTyped<double, uint64_t>,
-     &castVTyped<double, float>,
-     &copyV<double>,
-     &castVTyped<double, string>,
-    },
-    // to pvString
-    {&castVTyped<string, epics::pvData::boolean>,
-     &castVTyped<string, int8_t>,
-     &castVTyped<string, int16_t>,
-     &castVTyped<string, int32_t>,
-     &castVTyped<string, uint64_t>,
-     &castVTyped<string, uint8_t>,
-     &castVTyped<string, uint16_t>,
-     &castVTyped<string, uint32_t>,
-     &castVTyped<string, uint64_t>,
-     &castVTyped<string, float>,
-     &castVTyped<string, double>,
-     &copyV<string>,
-    },
-};
+#ifdef CASTV_AVX2
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return convertersAVX2;
+#endif
+    return converters;
+}
 
 } // end namespace
 
@@ -247,7 +270,19 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
     if(ito>pvString || ifrom>pvString)
         throw std::runtime_error("castUnsafeV: Invalid types");
 
-    converters[ito][ifrom](count, dest, src);
+    static const convertTable& table = selectConverters();
+    table[ito][ifrom](count, dest, src);
+}
+
+namespace detail {
+const char* castUnsafeVKernels()
+{
+#ifdef CASTV_AVX2
+    if(&selectConverters()==&convertersAVX2)
+        return "avx2";
+#endif
+    return "generic";
+}
 }
 
 }}
@@ -0,0 +1,489 @@
+/* monitorFilter.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <string>
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+
+#define epicsExportSharedSymbols
+#include <pv/pvData.h>
+#include <pv/typeCast.h>
+#include <pv/monitorFilter.h>
+
+using std::string;
+
+namespace epics { namespace pvData {
+
+namespace {
+
+// options in effect for a field, inherited from enclosing structures
+struct Options {
+    bool onChange, trigger, hasDeadband, relative;
+    double deadband;
+    Options() :onChange(false), trigger(true), hasDeadband(false), relative(false), deadband(0.0) {}
+};
+
+bool parseBool(const string& name, const string& value)
+{
+    if(value=="true")
+        return true;
+    else if(value=="false")
+        return false;
+    throw std::invalid_argument(name + "=" + value + " is not true or false");
+}
+
+double parseNumber(const string& name, const string& value)
+{
+    try {
+        return castUnsafe<double>(value);
+    } catch(std::exception&) {
+        throw std::invalid_argument(name + "=" + value + " is not a number");
+    }
+}
+
+template<typename T>
+inline double valueOf(const PVField *field)
+{
+    return static_cast<double>(static_cast<const PVScalarValue<T>*>(field)->get());
+}
+
+double numericValue(const PVField *field, ScalarType type)
+{
+    switch(type) {
+    case pvBoolean: return valueOf<boolean>(field);
+    case pvByte:    return valueOf<int8>(field);
+    case pvShort:   return valueOf<int16>(field);
+    case pvInt:     return valueOf<int32>(field);
+    case pvLong:    return valueOf<int64>(field);
+    case pvUByte:   return valueOf<uint8>(field);
+    case pvUShort:  return valueOf<uint16>(field);
+    case pvUInt:    return valueOf<uint32>(field);
+    case pvULong:   return valueOf<uint64>(field);
+    case pvFloat:   return valueOf<float>(field);
+    case pvDouble:  return valueOf<double>(field);
+    case pvString:  break;
+    }
+    throw std::logic_error("MonitorFilter: not a numeric field");
+}
+
+template<typename T>
+void decimateArray(PVScalarArray *field, uint32 N)
+{
+    PVValueArray<T> *arr = static_cast<PVValueArray<T>*>(field);
+    typename PVValueArray<T>::const_svector in(arr->view());
+    typename PVValueArray<T>::svector out((in.size()+N-1)/N);
+    for(size_t i=0, j=0; j<out.size(); i+=N, j++)
+        out[j] = in[i];
+    arr->replace(freeze(out));
+}
+
+// true if field holds arr, rather than a copy of its values
+bool sameArray(const PVField *field, const shared_vector<const void>& arr)
+{
+    shared_vector<const void> current;
+    static_cast<const PVScalarArray*>(field)->getAs<void>(current);
+    return current.data()==arr.data() && current.size()==arr.size();
+}
+
+void decimateArray(PVField *field, ScalarType type, uint32 N)
+{
+    PVScalarArray *arr = static_cast<PVScalarArray*>(field);
+    switch(type) {
+    case pvBoolean: decimateArray<boolean>(arr, N); break;
+    case pvByte:    decimateArray<int8>(arr, N); break;
+    case pvShort:   decimateArray<int16>(arr, N); break;
+    case pvInt:     decimateArray<int32>(arr, N); break;
+    case pvLong:    decimateArray<int64>(arr, N); break;
+    case pvUByte:   decimateArray<uint8>(arr, N); break;
+    case pvUShort:  decimateArray<uint16>(arr, N); break;
+    case pvUInt:    decimateArray<uint32>(arr, N); break;
+    case pvULong:   decimateArray<uint64>(arr, N); break;
+    case pvFloat:   decimateArray<float>(arr, N); break;
+    case pvDouble:  decimateArray<double>(arr, N); break;
+    case pvString:  decimateArray<string>(arr, N); break;
+    }
+}
+
+} // namespace
+
+struct MonitorFilter::Program {
+    enum kind_t {
+        always,   // passes, only trigger=false
+        onChange, // passes if not equal to the last value
+        deadband, // passes if further than arg from the last value
+        relative  // passes if further than arg*|last| from the last value
+    };
+    struct Test {
+        uint32 offset;
+        kind_t kind;
+        bool trigger;
+        bool numeric; // use numericValue() and lastValue
+        ScalarType type;
+        double arg;
+        uint32 decimate; // when sent, keep every decimate'th array element
+        size_t path, depth; // child indices from the top, in paths[path, path+depth)
+    };
+    // ordered by offset
+    std::vector<Test> tests;
+    std::vector<uint32> paths;
+    // by field offset.  One past the last offset within the field,
+    // and whether any field within has no test
+    std::vector<uint32> nextOffset;
+    std::vector<char> plain;
+    // timeStamp with a throttle option
+    bool throttle;
+    double interval;
+    Test seconds, nanoseconds;
+
+    explicit Program(PVCopy& pvCopy)
+        :throttle(false)
+        ,interval(0.0)
+    {
+        std::vector<uint32> path;
+        compile(pvCopy, pvCopy.getStructure(), 0, Options(), path);
+    }
+
+    // returns the next offset after field
+    uint32 compile(PVCopy& pvCopy, const FieldConstPtr& field, uint32 offset,
+                   Options opts, std::vector<uint32>& path)
+    {
+        // fields are visited in offset order
+        nextOffset.resize(offset+1);
+        plain.resize(offset+1);
+
+        bool directDeadband = false;
+        double throttleInterval = -1.0;
+        uint32 decimate = 0;
+        PVStructurePtr pvOptions(pvCopy.getOptions(offset));
+        if(pvOptions) {
+            const PVFieldPtrArray& fields = pvOptions->getPVFields();
+            for(size_t i=0; i<fields.size(); i++) {
+                const string& name = fields[i]->getFieldName();
+                if(fields[i]->getField()->getType()!=scalar)
+                    continue;
+                string value(static_cast<const PVScalar&>(*fields[i]).getAs<string>());
+                if(name=="onChange") {
+                    opts.onChange = parseBool(name, value);
+                } else if(name=="trigger") {
+                    opts.trigger = parseBool(name, value);
+                } else if(name=="deadband") {
+                    // abs:<x>, rel:<percent>, <percent>%, or <x>
+                    opts.relative = false;
+                    if(value.compare(0, 4, "abs:")==0) {
+                        value.erase(0, 4);
+                    } else if(value.compare(0, 4, "rel:")==0) {
+                        value.erase(0, 4);
+                        opts.relative = true;
+                    } else if(!value.empty() && value[value.size()-1]=='%') {
+                        value.erase(value.size()-1);
+                        opts.relative = true;
+                    }
+                    opts.deadband = parseNumber(name, value);
+                    if(!(opts.deadband>=0.0))
+                        throw std::invalid_argument(name + " must not be negative");
+                    if(opts.relative)
+                        opts.deadband /= 100.0;
+                    opts.hasDeadband = directDeadband = true;
+                } else if(name=="throttle") {
+                    throttleInterval = parseNumber(name, value);
+                    if(!(throttleInterval>=0.0))
+                        throw std::invalid_argument(name + " must not be negative");
+                } else if(name=="decimate") {
+                    double N = parseNumber(name, value);
+                    if(!(N>=1.0 && N<=4294967295.0) || N!=std::floor(N))
+                        throw std::invalid_argument(name + "=" + value + " is not a positive integer");
+                    decimate = static_cast<uint32>(N);
+                }
+            }
+        }
+
+        if(throttleInterval>=0.0)
+            compileThrottle(field, throttleInterval, path);
+        if(decimate && field->getType()!=scalarArray)
+            throw std::invalid_argument("decimate applies only to scalar array fields");
+
+        if(field->getType()==structure) {
+            const Structure& S = static_cast<const Structure&>(*field);
+            uint32 next = offset+1;
+            bool anyPlain = false;
+            for(size_t i=0, N=S.getNumberFields(); i<N; i++) {
+                path.push_back(static_cast<uint32>(i));
+                uint32 child = next;
+                next = compile(pvCopy, S.getField(i), child, opts, path);
+                path.pop_back();
+                anyPlain |= !!plain[child];
+            }
+            nextOffset[offset] = next;
+            // an empty structure has no value to test
+            plain[offset] = anyPlain || S.getNumberFields()==0;
+            return next;
+        }
+
+        nextOffset[offset] = offset+1;
+
+        Test T;
+        T.offset = offset;
+        T.trigger = opts.trigger;
+        T.numeric = false;
+        T.type = pvString;
+        T.arg = opts.deadband;
+        T.decimate = decimate>1 ? decimate : 0;
+        if(field->getType()==scalar) {
+            T.type = static_cast<const Scalar&>(*field).getScalarType();
+            T.numeric = T.type!=pvString;
+        } else if(field->getType()==scalarArray) {
+            T.type = static_cast<const ScalarArray&>(*field).getElementType();
+        }
+        bool canDeadband = T.numeric && T.type!=pvBoolean;
+
+        if(opts.hasDeadband && canDeadband) {
+            T.kind = opts.relative ? relative : deadband;
+        } else if(directDeadband) {
+            throw std::invalid_argument("deadband applies only to numeric scalar fields");
+        } else if(opts.onChange) {
+            T.kind = onChange;
+        } else if(!opts.trigger || T.decimate) {
+            T.kind = always;
+        } else {
+            plain[offset] = 1;
+            return offset+1;
+        }
+        plain[offset] = 0;
+
+        T.path = paths.size();
+        T.depth = path.size();
+        paths.insert(paths.end(), path.begin(), path.end());
+        tests.push_back(T);
+        return offset+1;
+    }
+
+    void compileThrottle(const FieldConstPtr& field, double throttleInterval,
+                         const std::vector<uint32>& path)
+    {
+        if(throttle)
+            throw std::invalid_argument("only one throttle may be given");
+        if(field->getType()!=structure)
+            throw std::invalid_argument("throttle applies only to a timeStamp structure");
+        const Structure& S = static_cast<const Structure&>(*field);
+        const char *names[2] = {"secondsPastEpoch", "nanoseconds"};
+        Test *tests[2] = {&seconds, &nanoseconds};
+        for(unsigned i=0; i<2; i++) {
+            size_t index = S.getFieldIndex(names[i]);
+            if(index==size_t(-1) || S.getField(index)->getType()!=scalar
+                    || !ScalarTypeFunc::isInteger(static_cast<const Scalar&>(*S.getField(index)).getScalarType()))
+                throw std::invalid_argument(string("throttle needs a timeStamp structure with integer ") + names[i]);
+            Test& T = *tests[i];
+            T.type = static_cast<const Scalar&>(*S.getField(index)).getScalarType();
+            T.path = paths.size();
+            T.depth = path.size()+1;
+            paths.insert(paths.end(), path.begin(), path.end());
+            paths.push_back(static_cast<uint32>(index));
+        }
+        throttle = true;
+        interval = throttleInterval;
+    }
+
+    double timeOf(PVStructure& top) const
+    {
+        return numericValue(resolve(top, seconds), seconds.type)
+                + 1e-9*numericValue(resolve(top, nanoseconds), nanoseconds.type);
+    }
+
+    PVField* resolve(PVStructure& top, const Test& T) const
+    {
+        PVField *field = &top;
+        for(size_t i=0; i<T.depth; i++)
+            field = static_cast<const PVStructure*>(field)->getPVFields()[paths[T.path+i]].get();
+        return field;
+    }
+};
+
+MonitorFilter::MonitorFilter(PVCopy& pvCopy)
+    :program(new Program(pvCopy))
+{
+    reset();
+}
+
+MonitorFilter::MonitorFilter(const MonitorFilter& other)
+    :program(other.program)
+{
+    reset();
+}
+
+MonitorFilter& MonitorFilter::operator=(const MonitorFilter& other)
+{
+    if(this!=&other) {
+        program = other.program;
+        reset();
+    }
+    return *this;
+}
+
+MonitorFilter::~MonitorFilter() {}
+
+bool MonitorFilter::empty() const
+{
+    return program->tests.empty() && !program->throttle;
+}
+
+void MonitorFilter::reset()
+{
+    size_t N = program->tests.size();
+    lastValue.assign(N, 0.0);
+    lastField.assign(N, PVFieldPtr());
+    haveLast.assign(N, 0);
+    decimatedFrom.assign(N, shared_vector<const void>());
+    sending.clear();
+    sending.reserve(N);
+    held.clear();
+    heldTests.clear();
+    heldTrigger = false;
+    lastTime = 0.0;
+    haveLastTime = false;
+}
+
+bool MonitorFilter::filter(PVStructure& copy, BitSet& changed)
+{
+    const Program& P = *program;
+    if(P.tests.empty() && !P.throttle)
+        return !changed.isEmpty();
+    if(copy.getNumberFields()!=P.nextOffset.size())
+        throw std::invalid_argument("MonitorFilter: structure does not match PVCopy");
+
+    const size_t ntests = P.tests.size();
+    bool trigger = false;
+    size_t t = 0;
+    sending.clear();
+
+    for(int32 bit = changed.nextSetBit(0); bit>=0; ) {
+        const uint32 offset = static_cast<uint32>(bit),
+                     next = P.nextOffset[offset];
+        while(t<ntests && P.tests[t].offset<offset)
+            t++;
+
+        if(t<ntests && P.tests[t].offset==offset) {
+            // a field with a test
+            const Program::Test& T = P.tests[t];
+            bool pass = T.kind==Program::always || !haveLast[t];
+            if(!pass) {
+                const PVField *field = P.resolve(copy, T);
+                if(T.numeric) {
+                    double value = numericValue(field, T.type),
+                           last = lastValue[t];
+                    bool nan = value!=value && last!=last;
+                    if(T.kind==Program::deadband)
+                        pass = !nan && !(std::fabs(value-last)<=T.arg);
+                    else if(T.kind==Program::relative)
+                        pass = !nan && !(std::fabs(value-last)<=T.arg*std::fabs(last));
+                    else
+                        pass = !nan && value!=last;
+                } else {
+                    pass = !(*field==*lastField[t]);
+                }
+            }
+            // PVCopy::updateCopySetBitSet() puts back the array decimated last
+            if(pass && T.decimate && haveLast[t])
+                pass = !sameArray(P.resolve(copy, T), decimatedFrom[t]);
+            if(pass) {
+                sending.push_back(t);
+                trigger |= T.trigger;
+            } else {
+                changed.clear(offset);
+            }
+            t++;
+
+        } else {
+            // a field without test, or a structure sent in full
+            // including any fields with tests, which are sent regardless
+            trigger |= !!P.plain[offset];
+            for(; t<ntests && P.tests[t].offset<next; t++) {
+                sending.push_back(t);
+                trigger |= P.tests[t].trigger;
+            }
+        }
+
+        bit = changed.nextSetBit(next);
+    }
+
+    if(!trigger && !heldTrigger)
+        return false;
+
+    if(P.throttle) {
+        double now = P.timeOf(copy);
+        // a timeStamp which went backwards ends the interval
+        if(haveLastTime && now>=lastTime && now-lastTime<P.interval) {
+            // hold back until an update arrives after the interval
+            held |= changed;
+            heldTests.insert(heldTests.end(), sending.begin(), sending.end());
+            heldTrigger = true;
+            return false;
+        }
+        lastTime = now;
+        haveLastTime = true;
+        if(heldTrigger)
+            takeHeld(changed);
+    }
+
+    send(copy);
+    return true;
+}
+
+bool MonitorFilter::flush(PVStructure& copy, BitSet& changed)
+{
+    const Program& P = *program;
+    if(!heldTrigger)
+        return false;
+    if(copy.getNumberFields()!=P.nextOffset.size())
+        throw std::invalid_argument("MonitorFilter: structure does not match PVCopy");
+    sending.clear();
+    takeHeld(changed);
+    lastTime = P.timeOf(copy);
+    haveLastTime = true;
+    send(copy);
+    return true;
+}
+
+void MonitorFilter::takeHeld(BitSet& changed)
+{
+    changed |= held;
+    sending.insert(sending.end(), heldTests.begin(), heldTests.end());
+    std::sort(sending.begin(), sending.end());
+    sending.erase(std::unique(sending.begin(), sending.end()), sending.end());
+    held.clear();
+    heldTests.clear();
+    heldTrigger = false;
+}
+
+void MonitorFilter::send(PVStructure& copy)
+{
+    const Program& P = *program;
+    for(size_t i=0; i<sending.size(); i++) {
+        size_t s = sending[i];
+        const Program::Test& T = P.tests[s];
+        PVField *field = P.resolve(copy, T);
+        if(T.numeric) {
+            lastValue[s] = numericValue(field, T.type);
+        } else {
+            if(!lastField[s])
+                lastField[s] = getPVDataCreate()->createPVField(field->getField());
+            lastField[s]->copyUnchecked(*field);
+        }
+        haveLast[s] = 1;
+    }
+    // after the last values are taken, so that onChange compares whole arrays
+    for(size_t i=0; i<sending.size(); i++) {
+        size_t s = sending[i];
+        const Program::Test& T = P.tests[s];
+        if(T.decimate) {
+            PVField *field = P.resolve(copy, T);
+            static_cast<PVScalarArray*>(field)->getAs<void>(decimatedFrom[s]);
+            decimateArray(field, T.type, T.decimate);
+        }
+    }
+}
+
+}}
@@ -21,7 +21,7 @@ namespace epics { namespace pvData {
 MonitorPluginManagerPtr MonitorPluginManager::get()
 {
     static MonitorPluginManagerPtr pluginManager;
-    static Mutex mutex;
+    static NamedMutex mutex("MonitorPluginManager::get");
     Lock xx(mutex);
     if(!pluginManager) {
         pluginManager = MonitorPluginManagerPtr(new MonitorPluginManager());
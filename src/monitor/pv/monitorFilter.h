@@ -0,0 +1,148 @@
+/* monitorFilter.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef MONITORFILTER_H
+#define MONITORFILTER_H
+
+#include <vector>
+
+#include <pv/pvData.h>
+#include <pv/bitSet.h>
+#include <pv/monitor.h>
+#include <pv/pvCopy.h>
+#include <pv/sharedPtr.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+class MonitorFilter;
+typedef std::tr1::shared_ptr<MonitorFilter> MonitorFilterPtr;
+
+/** @brief Filters monitor updates according to the field options of a pvRequest.
+ *
+ * The options of each field of a PVCopy, as given by PVCopy::getOptions(),
+ * are compiled once into a list of built-in tests ordered by field offset.
+ * filter() then makes one pass over the changed BitSet of an update,
+ * without virtual calls, which makes it cheap enough to run
+ * for every subscriber of every update.
+ *
+ * Field options understood:
+ *
+ * - onChange=true  The field is only sent if its value differs from the last value sent.
+ * - deadband=<x>   For numeric scalars.  The field is only sent if it differs
+ *                  by more than x from the last value sent.  "abs:<x>" is accepted as well.
+ * - deadband=<p>%  As deadband=<x>, with x being p percent of the last value sent.
+ *                  "rel:<p>" is accepted as well.
+ * - trigger=false  The field is sent with other changes, but can't cause an update by itself.
+ * - decimate=<n>   For scalar arrays.  Only every n'th element is sent.
+ * - throttle=<s>   For a timeStamp structure.  Updates are sent at most once every s seconds
+ *                  of timeStamp.  Updates arriving sooner are held back, and merged into
+ *                  the next update which arrives after the interval, or sent by flush().
+ *
+ * Options given to a structure apply to all of its fields, unless overridden.
+ * Other options are ignored.
+ *
+ @code
+   PVStructurePtr pvRequest(CreateRequest::create()->createRequest(
+                                "field(value[deadband=0.5],alarm,timeStamp[trigger=false,throttle=1.0])"));
+   MonitorFilter filter(*pvCopy);
+   ...
+   if(filter.filter(*element))
+       queue(element);
+ @endcode
+ *
+ * Each subscriber needs its own MonitorFilter, as the last values sent are kept.
+ * Copies share the compiled tests, but not the last values.
+ */
+class epicsShareClass MonitorFilter {
+public:
+    POINTER_DEFINITIONS(MonitorFilter);
+
+    /**
+     * @param pvCopy Provides the structure of the copy and the options of each field.
+     * @throws std::invalid_argument for an option value which can't be parsed,
+     *         or which does not apply to the type of its field.
+     */
+    explicit MonitorFilter(PVCopy& pvCopy);
+    //! Shares the compiled tests of other, with no last values.
+    MonitorFilter(const MonitorFilter& other);
+    MonitorFilter& operator=(const MonitorFilter& other);
+    ~MonitorFilter();
+
+    //! True if no field has an option, and filter() only tests for an empty BitSet.
+    bool empty() const;
+
+    /** Filter one update.
+     *
+     * The bits of fields which don't pass their test are cleared from changed.
+     * When the update is to be sent, the values of all fields sent
+     * are remembered for the next update, and arrays with decimate are replaced
+     * by their decimated values.  The arrays replaced are remembered as well,
+     * so that one put back into the copy by PVCopy::updateCopySetBitSet()
+     * is not taken as a change.
+     *
+     * With a throttle, changed is extended by the fields of updates held back.
+     * This expects that the copy holds the current values of all fields,
+     * as kept by PVCopy::updateCopySetBitSet().
+     *
+     * @param copy The copy PVStructure holding the update.
+     * @param changed The fields of copy which have changed.
+     * @returns true if the update should be sent, false if it should be discarded.
+     */
+    bool filter(PVStructure& copy, BitSet& changed);
+    //! Shorthand for filter(*element.pvStructurePtr, *element.changedBitSet)
+    bool filter(MonitorElement& element)
+    {
+        return filter(*element.pvStructurePtr, *element.changedBitSet);
+    }
+
+    //! True if a throttle holds back changes, which flush() would send.
+    bool hasHeld() const { return heldTrigger; }
+    /** Send the changes held back by a throttle, without waiting for another update.
+     *
+     * Updates held back are otherwise only sent with the next update which arrives
+     * after the interval.  So that the last update of a burst is not kept indefinitely,
+     * a timer should call flush() once the interval has passed.
+     * The interval then starts again at the timeStamp of copy.
+     *
+     * @param copy The copy PVStructure, holding the current values of all fields.
+     * @param changed Extended by the fields held back.
+     * @returns true if there were changes held back, which should now be sent.
+     */
+    bool flush(PVStructure& copy, BitSet& changed);
+    //! Shorthand for flush(*element.pvStructurePtr, *element.changedBitSet)
+    bool flush(MonitorElement& element)
+    {
+        return flush(*element.pvStructurePtr, *element.changedBitSet);
+    }
+
+    //! Forget the last values sent and any updates held back.  The next update is sent unfiltered.
+    void reset();
+
+private:
+    void takeHeld(BitSet& changed);
+    void send(PVStructure& copy);
+
+    struct Program;
+    std::tr1::shared_ptr<const Program> program;
+    // per test, last value sent
+    std::vector<double> lastValue;
+    std::vector<PVFieldPtr> lastField;
+    std::vector<char> haveLast;
+    // per test with decimate, the array last decimated
+    std::vector<shared_vector<const void> > decimatedFrom;
+    // tests of fields sent with this update
+    std::vector<size_t> sending;
+    // throttle
+    BitSet held;
+    std::vector<size_t> heldTests;
+    bool heldTrigger, haveLastTime;
+    double lastTime;
+};
+
+}}
+
+#endif  /* MONITORFILTER_H */
@@ -169,9 +169,9 @@ public:
      */
     void showNames();
 private:
-     MonitorPluginManager(){}
+     MonitorPluginManager() :mutex("MonitorPluginManager") {}
      std::list<MonitorPluginCreatorPtr> monitorPluginList;
-     epics::pvData::Mutex mutex;
+     epics::pvData::NamedMutex mutex;
 };
 
 #undef USAGE_DEPRECATED
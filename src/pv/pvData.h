@@ -43,6 +43,7 @@ typedef class std::ios std::ios_base;
 namespace epics { namespace pvData { 
 
 class PostHandler;
+class GroupPutHandler;
 
 class PVField;
 class PVScalar;
@@ -63,6 +64,10 @@ template<typename T> class PVValueArray;
  * typedef for a pointer to a PostHandler.
  */
 typedef std::tr1::shared_ptr<PostHandler> PostHandlerPtr;
+/**
+ * typedef for a pointer to a GroupPutHandler.
+ */
+typedef std::tr1::shared_ptr<GroupPutHandler> GroupPutHandlerPtr;
 
 /**
  * typedef for a pointer to a PVField.
@@ -129,7 +134,7 @@ class PVDataCreate;
 typedef std::tr1::shared_ptr<PVDataCreate> PVDataCreatePtr;
 
 /**
- * @brief This class is implemented by code that calls setPostHander
+ * @brief This class is implemented by code that calls setPostHandler() or addPostHandler()
  *
  */
 class epicsShareClass PostHandler 
@@ -146,6 +151,24 @@ public:
     virtual void postPut() = 0;
 };
 
+/**
+ * @brief Notified once for each group of puts to a top-level PVStructure.
+ *
+ * See PVStructure::addGroupPutHandler()
+ */
+class epicsShareClass GroupPutHandler
+{
+public:
+    POINTER_DEFINITIONS(GroupPutHandler);
+    virtual ~GroupPutHandler(){}
+    /**
+     * Called after the outermost PVStructure::endGroupPut(), or after a put outside of a group.
+     * @param top The top-level structure.
+     * @param changed The offsets of the fields changed by the group.  Never empty.
+     */
+    virtual void postGroupPut(const PVStructure& top, const BitSet& changed) = 0;
+};
+
 /**
  * @brief PVField is the base class for each PVData field.
  *
@@ -160,7 +183,7 @@ public:
     /**
      * Constructor
      */
-    PVField() {};
+    PVField() :posting(false), tracker(NULL), postHandlers(NULL), postHandler(NULL) {};
     /**
      * Destructor
      */
@@ -169,7 +192,7 @@ public:
      * Get the fieldName for this field.
      * @return The name or empty string if top-level field.
      */
-    inline const std::string& getFieldName() const {return fieldName;}
+    inline const std::string& getFieldName() const {return *fieldName;}
     /**
      * Fully expand the name of this field using the
      * names of its parent fields with a dot '.' separating
@@ -219,14 +242,40 @@ public:
     PVStructure * getParent() const ;
     /**
      * postPut. Called when the field is updated by the implementation.
+     * Records the change if the top-level structure is tracking changes,
+     * then calls the PostHandlers, if any.  During PVStructure::beginGroupPut()
+     * the PostHandlers are called later, by PVStructure::endGroupPut().
+     *
+     * Costs one test when neither is in use.
      */
-    void postPut() ;
+    void postPut()
+    {
+        if(tracker || postHandlers)
+            notifyPut();
+    }
     /**
      * Set the handler for postPut.
-     * At most one handler can be set.
+     * At most one handler can be set this way.
      * @param postHandler The handler.
+     * @throws std::logic_error if a different handler is already registered.
      */
     void setPostHandler(PostHandlerPtr const &postHandler);
+    /**
+     * Add a handler for postPut.  Any number of handlers may be added,
+     * and are called in the order added.  Adding a handler twice has no effect.
+     *
+     * The list of handlers is copied on change, and postPut() takes no lock.
+     * Handlers may be added or removed while the field is being posted,
+     * eg. by a PostHandler removing itself, and take effect with the next postPut().
+     * Handlers removed are kept alive until the call of the field's handlers returns.
+     *
+     * This is not thread safe.  As with put(), adding and removing handlers
+     * must be serialized with postPut() and each other, typically by
+     * holding the lock of the record the field belongs to.
+     */
+    void addPostHandler(PostHandlerPtr const &postHandler);
+    //! Remove a handler added by setPostHandler() or addPostHandler().  No effect if not present.
+    void removePostHandler(PostHandlerPtr const &postHandler);
     /**
      * Is this field equal to another field.
      * @param pv other field
@@ -240,7 +289,20 @@ public:
      */
     virtual std::ostream& dumpValue(std::ostream& o) const = 0;
 
+    /**
+     * Copy the value of another field with the same introspection interface.
+     *
+     * Array values are copied by reference.  The cost of copying an array
+     * does not depend on its length.  Afterwards both fields share the same
+     * (frozen) storage until one of them is modified, eg. through reuse(),
+     * which then makes a private copy.  Elements of structure and union
+     * arrays are shared in the same way.
+     *
+     * @param from The source field.
+     * @throws std::invalid_argument if this field is immutable.
+     */
     void copy(const PVField& from);
+    //! As copy() without checks for compatibility or immutability.
     void copyUnchecked(const PVField& from);
 
 protected:
@@ -249,19 +311,35 @@ protected:
         return shared_from_this();
     }
     explicit PVField(FieldConstPtr field);
-    void setParentAndName(PVStructure *parent, std::string const & fieldName);
+    //! fieldName is owned by the Structure of parent.  NULL for a top-level field.
+    void setParentAndName(PVStructure *parent, const std::string *fieldName);
+    //! Record a change of value which is not followed by postPut(), eg. by deserialize()
+    void markChanged();
 private:
+    void notifyPut();
+    void callPostHandlers();
+    struct PostHandlerList;
+    void setPostHandlers(PostHandlerList *next);
+    void callHandlers(PostHandlerList *list);
+    void endPosting(PostHandlerList *called);
+    void detachFromParent();
     static void computeOffset(const PVField *pvField);
     static void computeOffset(const PVField *pvField,std::size_t offset);
-    std::string fieldName;
+    const std::string *fieldName; // an element of Structure::getFieldNames() of parent, unless ownsName
     PVStructure *parent;
     FieldConstPtr field;
     size_t fieldOffset;
     size_t nextFieldOffset;
     bool immutable;
-    PostHandlerPtr postHandler;
+    bool posting; // in callPostHandlers()
+    bool ownsName; // fieldName was copied by detachFromParent()
+    PVStructure *tracker; // top-level structure, when tracking changes, with GroupPutHandlers or during a group put
+    // copy on write, NULL when empty
+    PostHandlerList *postHandlers;
+    PostHandler *postHandler; // of postHandlers, when it is the only one
     friend class PVDataCreate;
     friend class PVStructure;
+    friend class PVUnion;
 };
 
 epicsShareExtern std::ostream& operator<<(std::ostream& o, const PVField& f);
@@ -411,6 +489,10 @@ public:
     {
         if(this==&from)
             return;
+        if(from.getScalar()->getScalarType()==typeCode) {
+            put(static_cast<const PVScalarValue<T>&>(from).get());
+            return;
+        }
         T result;
         from.getAs((void*)&result, typeCode);
         put(result);
@@ -844,13 +926,107 @@ public:
 
     virtual std::ostream& dumpValue(std::ostream& o) const;
 
+    /**
+     * Copy the values of all sub-fields.  See PVField::copy().
+     * Arrays are copied by reference, so the cost depends only on the number of fields.
+     */
     void copy(const PVStructure& from);
 
     void copyUnchecked(const PVStructure& from);
+    /**
+     * Copy only the sub-fields selected by maskBitSet (or not selected if inverse==true).
+     */
     void copyUnchecked(const PVStructure& from, const BitSet& maskBitSet, bool inverse = false);
 
+    /**
+     * Start, or stop, recording which fields of this top-level structure change.
+     *
+     * While enabled, the bit getFieldOffset() of a field is set each time its
+     * value is changed through put(), replace(), copy()/copyUnchecked(),
+     * PVUnion::set()/select(), or deserialize().  This works
+     * alongside setPostHandler(), without allocating a PostHandler for each field.
+     *
+     * Changes made within the value of a PVUnion, or within the elements of a
+     * structure or union array, are not recorded.  Nor are changes made through
+     * the shared_vector of a PVScalarArray without a call to replace() or postPut().
+     *
+     * Changes made during beginGroupPut() are recorded by the outermost endGroupPut().
+     *
+     * Not thread safe.  Callers must serialize access to the structure, as for put().
+     *
+     * @throws std::logic_error if this is not a top-level structure.
+     */
+    void setTrackChanges(bool track);
+    //! Is setTrackChanges() enabled
+    bool isTrackingChanges() const { return !!changes; }
+    /**
+     * Move the fields changed since the last call (or since setTrackChanges(true)) into
+     * changed, and clear.  The previous contents of changed are discarded.
+     * changed is left empty when change tracking is not enabled.
+     *
+     @code
+       BitSet changed;
+       for(each record) {
+           record->takeChanges(changed);
+           if(!changed.isEmpty())
+               ...
+       }
+     @endcode
+     */
+    void takeChanges(BitSet& changed);
+
+    /**
+     * Start a group of puts to the fields of this top-level structure,
+     * which are notified together by endGroupPut().
+     *
+     * Until then, calls to the PostHandlers of sub-fields, and the recording
+     * of changes for setTrackChanges() and GroupPutHandlers, are deferred.
+     *
+     * Calls may be nested.  Only the outermost endGroupPut() notifies.
+     * Unless changes are tracked, or there are GroupPutHandlers, the outermost
+     * beginGroupPut() and endGroupPut() each visit every sub-field.
+     *
+     @code
+       top->beginGroupPut();
+       value->put(v);
+       severity->put(s);
+       ...
+       top->endGroupPut(); // one GroupPutHandler::postGroupPut()
+     @endcode
+     *
+     * @throws std::logic_error if this is not a top-level structure.
+     */
+    void beginGroupPut();
+    /**
+     * End a beginGroupPut().  The outermost call
+     *
+     * 1. adds the changes to those of setTrackChanges(),
+     * 2. calls the PostHandlers of each field posted, once,
+     *    in the order first posted, no matter how many times it was put,
+     * 3. calls each GroupPutHandler with the combined changes, if any.
+     *
+     * @throws std::logic_error if there was no matching beginGroupPut().
+     */
+    void endGroupPut();
+    /**
+     * Add a handler called once per group of puts, with all of the fields changed.
+     * A put outside of beginGroupPut() is a group of one.
+     * Adding a handler twice has no effect.
+     *
+     * Changes are recorded as for setTrackChanges(), and handlers are called in the order added.
+     * Handlers may add or remove handlers, which takes effect with the next group.
+     *
+     * @throws std::logic_error if this is not a top-level structure.
+     */
+    void addGroupPutHandler(GroupPutHandlerPtr const &handler);
+    //! Remove a handler added by addGroupPutHandler().  No effect if not present.
+    void removeGroupPutHandler(GroupPutHandlerPtr const &handler);
+
 private:
     PVField *getSubFieldImpl(const char *name, bool throws = true) const;
+    void setTracker(PVStructure *tracker);
+    void updateTracker();
+    void trackPut(PVField *pvField, bool post);
 
     static PVFieldPtr nullPVField;
     static PVBooleanPtr nullPVBoolean;
@@ -874,7 +1050,12 @@ private:
     PVFieldPtrArray pvFields;
     StructureConstPtr structurePtr;
     std::string extendsStructureName;
+    std::tr1::shared_ptr<BitSet> changes; // when tracking changes
+    struct GroupPut;
+    std::tr1::shared_ptr<GroupPut> groupPut; // allocated by the first beginGroupPut()
+    bool deferPost(PVField *pvField);
     friend class PVDataCreate;
+    friend class PVField;
 };
 
 
@@ -1042,8 +1223,31 @@ public:
     void copy(const PVUnion& from);
     void copyUnchecked(const PVUnion& from);
 
+    /**
+     * Set the number of previously selected members each PVUnion keeps,
+     * to be re-used by select(), deserialize() and copy() instead of
+     * allocating a new member when the selection changes.
+     * Members of variant unions are matched by Field identity.
+     * Cached members are reset to the values of a new member, and hold no
+     * strings or array values.  Members are only kept if no one else
+     * holds them or any of their sub-fields, none of those is immutable or has
+     * a PostHandler, and a structure member does not track changes, has no
+     * GroupPutHandlers and is not in a group put.  Default 4.  0 disables the cache.
+     * Should be set before any PVUnion is used.
+     */
+    static void setMemberCacheSize(std::size_t entries);
+    static std::size_t memberCacheSize();
+
 private:
     static PVDataCreatePtr pvDataCreate;
+    static std::size_t memberCacheLimit;
+
+    // no one else holds field or a sub-field, and none is immutable, has PostHandlers or a tracker
+    static bool reusable(const PVFieldPtr& field);
+    // keep a member which is no longer selected, if it is reusable()
+    void stash(PVFieldPtr& member);
+    // a cached member with this introspection interface, or a new one
+    PVFieldPtr take(FieldConstPtr const & field);
 
     friend class PVDataCreate;
     UnionConstPtr unionPtr;
@@ -1051,6 +1255,8 @@ private:
 	int32 selector;
 	PVFieldPtr value;
 	bool variant;  
+    // previously selected members, least recently used first
+    std::vector<PVFieldPtr> memberCache;
 };
 
 
@@ -1617,6 +1823,12 @@ private:
  */
 epicsShareExtern PVDataCreatePtr getPVDataCreate();
 
+/**
+ * Compare the values of two fields.
+ * float and double values are compared as by C++, so NaN is not equal to NaN,
+ * even in arrays sharing storage.  However a PVField is always equal to itself,
+ * which includes the shared elements of structure and union arrays.
+ */
 bool epicsShareExtern operator==(const PVField&, const PVField&);
 
 static inline bool operator!=(const PVField& a, const PVField& b)
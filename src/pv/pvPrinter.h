@@ -0,0 +1,82 @@
+/* pvPrinter.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef PVPRINTER_H
+#define PVPRINTER_H
+
+#include <string>
+#include <ostream>
+
+#include <pv/pvData.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+/** @brief Text or JSON output of a PVField
+ *
+ * Appends to a caller supplied std::string, which may be re-used
+ * to avoid allocations when printing many values, eg. for logging.
+ * Numbers are printed with formatPOD() instead of iostreams.
+ *
+ * With the default options, text output is the same as operator<<(std::ostream&, const PVField&)
+ * with default stream flags.
+ *
+ @code
+   std::string line;
+   PVPrinter printer;
+   printer.maxArrayElements(10);
+   for(...) {
+       line.clear();
+       printer.print(line, *pvStructure);
+       fputs(line.c_str(), stdout);
+   }
+ @endcode
+ *
+ * JSON output maps structures to objects, arrays to arrays, unions to their
+ * selected value (or null), and scalars to numbers, strings or booleans.
+ * NaN and infinite values are printed as null.  Floating point values
+ * are printed with enough digits to be read back exactly.
+ */
+class epicsShareClass PVPrinter {
+public:
+    enum Format {
+        text, //!< As dumpValue()
+        json  //!< Compact JSON
+    };
+
+    PVPrinter();
+
+    PVPrinter& format(Format fmt) { m_format = fmt; return *this; }
+    /** Print at most n elements of each array.  0 (the default) for no limit.
+     *
+     * Truncated text output ends with "..."
+     */
+    PVPrinter& maxArrayElements(size_t n) { m_maxElements = n; return *this; }
+    /** Expand at most n levels of structures and unions, starting with
+     *  the field printed.  0 (the default) for no limit.
+     *
+     * Text output has "..." in place of the sub-fields.  JSON output has {} or null.
+     */
+    PVPrinter& maxDepth(size_t n) { m_maxDepth = n; return *this; }
+    //! Initial indentation level of text output
+    PVPrinter& indent(unsigned level) { m_indent = level; return *this; }
+
+    //! Append the printed field to out.
+    void print(std::string& out, const PVField& field) const;
+    //! Print the field to a stream.  Does not use the flags or indent level of strm.
+    std::ostream& print(std::ostream& strm, const PVField& field) const;
+    std::string toString(const PVField& field) const;
+
+private:
+    Format m_format;
+    size_t m_maxElements;
+    size_t m_maxDepth;
+    unsigned m_indent;
+};
+
+}}
+
+#endif  /* PVPRINTER_H */
@@ -0,0 +1,89 @@
+/* pvSerializedUpdate.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef PVSERIALIZEDUPDATE_H
+#define PVSERIALIZEDUPDATE_H
+
+#include <pv/pvData.h>
+#include <pv/bitSet.h>
+#include <pv/byteBuffer.h>
+#include <pv/sharedVector.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+/** @brief A monitor update, serialized once for many subscribers.
+ *
+ * Holds the encoding of the triple (changed BitSet, changed fields, overrun BitSet)
+ * as written by
+ @code
+   changed.serialize(buffer, control);
+   value.serialize(buffer, control, &changed);
+   overrun.serialize(buffer, control);
+ @endcode
+ * The encoding is done by the constructor, into a single immutable block
+ * which is shared by all copies of the SerializedUpdate::shared_pointer.
+ * Each connection then only copies bytes into its send buffer.
+ *
+ @code
+   SerializedUpdate::shared_pointer update(new SerializedUpdate(*value, changed, overrun));
+   for(each subscriber)
+       update->serialize(subscriber.buffer, subscriber.control, subscriber.wasOverrun);
+ @endcode
+ *
+ * Two variants of the overrun BitSet are kept.  Connections which have
+ * missed updates receive the overrun BitSet given to the constructor,
+ * those which are up to date receive an empty BitSet.
+ *
+ * The block is written in one byte order.  Create one SerializedUpdate
+ * for each byte order in use.
+ *
+ * Introspection data of variant union values is written in full,
+ * as the SerializableControl::cachedSerialize() cache of each connection
+ * can't be used.
+ */
+class epicsShareClass SerializedUpdate {
+public:
+    POINTER_DEFINITIONS(SerializedUpdate);
+    typedef shared_vector<const char> block_t;
+
+    /**
+     * @param value The top level structure.
+     * @param changed The fields of value to be sent.
+     * @param overrun Fields which changed more than once since the last update.
+     * @param byteOrder EPICS_ENDIAN_LITTLE or EPICS_ENDIAN_BIG
+     */
+    SerializedUpdate(const PVStructure& value,
+                     const BitSet& changed,
+                     const BitSet& overrun,
+                     int byteOrder = EPICS_BYTE_ORDER);
+
+    int getByteOrder() const { return m_byteOrder; }
+
+    //! The changed BitSet followed by the changed fields.
+    const block_t& getChanged() const { return m_changed; }
+    //! The overrun BitSet if overrun, otherwise an empty BitSet.
+    const block_t& getOverrun(bool overrun) const { return overrun ? m_overrun : m_noOverrun; }
+    //! Number of bytes appended by serialize()
+    size_t size(bool overrun) const { return m_changed.size() + getOverrun(overrun).size(); }
+
+    /** Append the update to a send buffer.
+     *
+     * Large blocks are offered to SerializableControl::directSerialize(),
+     * otherwise copied with flushSerializeBuffer() as needed.
+     *
+     * @throws std::logic_error if the byte order of buffer is not getByteOrder()
+     */
+    void serialize(ByteBuffer *buffer, SerializableControl *control, bool overrun) const;
+
+private:
+    int m_byteOrder;
+    block_t m_changed, m_overrun, m_noOverrun;
+};
+
+}}
+
+#endif  /* PVSERIALIZEDUPDATE_H */
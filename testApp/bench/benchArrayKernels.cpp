@@ -0,0 +1,78 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <pv/arrayKernels.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+struct ArrayKernelsBench {
+    enum {count = 1024*1024};
+    shared_vector<const double> D;
+    shared_vector<const int16> I;
+    shared_vector<uint64> bins;
+    double sum;
+    ArrayKernelsBench()
+        :bins(100, 0)
+        ,sum(0.0)
+    {
+        shared_vector<double> d(count);
+        shared_vector<int16> i(count);
+        for(size_t n=0; n<count; n++) {
+            d[n] = double(n%1000) - 500.0;
+            i[n] = int16(n%1000);
+        }
+        D = freeze(d);
+        I = freeze(i);
+    }
+    // what user code does without the kernels
+    void loopStats()
+    {
+        double mn = D[0], mx = D[0], s = 0.0, q = 0.0;
+        for(size_t n=0; n<D.size(); n++) {
+            double v = D[n];
+            if(v<mn) mn = v;
+            if(v>mx) mx = v;
+            s += v;
+            q += v*v;
+        }
+        sum += mn + mx + s + q;
+    }
+    void statsDouble()
+    {
+        sum += arrayStatistics(D).sum;
+    }
+    void statsInt16()
+    {
+        sum += arrayStatistics(I).sum;
+    }
+    void affineInt16()
+    {
+        shared_vector<double> out(arrayAffine<double>(I, 0.5, -1.0));
+        sum += out[0];
+    }
+    void histogram()
+    {
+        arrayHistogram(D, -500.0, 500.0, bins);
+    }
+};
+typedef std::tr1::shared_ptr<ArrayKernelsBench> ArrayKernelsBenchPtr;
+}
+
+void benchArrayKernels(BenchRunner& runner)
+{
+    ArrayKernelsBenchPtr B(new ArrayKernelsBench);
+    runner.run("plain loop stats double[1M]", B, &ArrayKernelsBench::loopStats);
+    runner.run("arrayStatistics double[1M]", B, &ArrayKernelsBench::statsDouble);
+    runner.run("arrayStatistics int16[1M]", B, &ArrayKernelsBench::statsInt16);
+    runner.run("arrayAffine int16->double[1M]", B, &ArrayKernelsBench::affineInt16);
+    runner.run("arrayHistogram double[1M] 100 bins", B, &ArrayKernelsBench::histogram);
+
+    ArrayKernels::setParallel(4, 64*1024);
+    runner.runThreaded("arrayStatistics double[1M] x4", B, &ArrayKernelsBench::statsDouble);
+    runner.runThreaded("arrayAffine int16->double[1M] x4", B, &ArrayKernelsBench::affineInt16);
+    ArrayKernels::setParallel(1);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <pv/bitSet.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+struct BitSetBench {
+    enum {nbits = 1024};
+    BitSet sparse, dense, work;
+    uint32 found;
+    BitSetBench()
+        :sparse(nbits), dense(nbits), work(nbits), found(0)
+    {
+        for(uint32 i=0; i<nbits; i+=37)
+            sparse.set(i);
+        for(uint32 i=0; i<nbits; i++)
+            if(i%3) dense.set(i);
+    }
+    void setClear()
+    {
+        for(uint32 i=0; i<nbits; i+=3)
+            work.set(i);
+        work.clear();
+    }
+    void iterateSparse()
+    {
+        for(int32 i=sparse.nextSetBit(0); i>=0; i=sparse.nextSetBit(i+1))
+            found++;
+    }
+    void iterateDense()
+    {
+        for(int32 i=dense.nextSetBit(0); i>=0; i=dense.nextSetBit(i+1))
+            found++;
+    }
+    void orAssign()
+    {
+        work = sparse;
+        work |= dense;
+    }
+    void cardinality()
+    {
+        found += dense.cardinality();
+    }
+};
+typedef std::tr1::shared_ptr<BitSetBench> BitSetBenchPtr;
+}
+
+void benchBitSet(BenchRunner& runner)
+{
+    BitSetBenchPtr B(new BitSetBench);
+    runner.run("BitSet set+clear 1024", B, &BitSetBench::setClear);
+    runner.run("BitSet nextSetBit sparse 1024", B, &BitSetBench::iterateSparse);
+    runner.run("BitSet nextSetBit dense 1024", B, &BitSetBench::iterateDense);
+    runner.run("BitSet assign+or 1024", B, &BitSetBench::orAssign);
+    runner.run("BitSet cardinality 1024", B, &BitSetBench::cardinality);
+}
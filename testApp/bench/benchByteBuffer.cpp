@@ -0,0 +1,62 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <epicsEndian.h>
+
+#include <pv/byteBuffer.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+struct ByteBufferBench {
+    enum {count = 1024};
+    ByteBuffer buf;
+    double values[count];
+    explicit ByteBufferBench(int byteOrder)
+        :buf(count*sizeof(double), byteOrder)
+    {
+        for(size_t i=0; i<count; i++)
+            values[i] = i*1.5;
+    }
+    void putDouble()
+    {
+        buf.clear();
+        for(size_t i=0; i<count; i++)
+            buf.putDouble(values[i]);
+    }
+    void getDouble()
+    {
+        buf.clear();
+        for(size_t i=0; i<count; i++)
+            values[i] = buf.getDouble();
+    }
+    void putArray()
+    {
+        buf.clear();
+        buf.putArray(values, count);
+    }
+    void getArray()
+    {
+        buf.clear();
+        buf.getArray(values, count);
+    }
+};
+typedef std::tr1::shared_ptr<ByteBufferBench> ByteBufferBenchPtr;
+}
+
+void benchByteBuffer(BenchRunner& runner)
+{
+    ByteBufferBenchPtr native(new ByteBufferBench(EPICS_BYTE_ORDER));
+    runner.run("ByteBuffer putDouble x1024", native, &ByteBufferBench::putDouble);
+    runner.run("ByteBuffer getDouble x1024", native, &ByteBufferBench::getDouble);
+    runner.run("ByteBuffer putArray double x1024", native, &ByteBufferBench::putArray);
+    runner.run("ByteBuffer getArray double x1024", native, &ByteBufferBench::getArray);
+
+    ByteBufferBenchPtr swapped(new ByteBufferBench(
+        EPICS_BYTE_ORDER==EPICS_ENDIAN_LITTLE ? EPICS_ENDIAN_BIG : EPICS_ENDIAN_LITTLE));
+    runner.run("ByteBuffer putDouble swap x1024", swapped, &ByteBufferBench::putDouble);
+    runner.run("ByteBuffer putArray double swap x1024", swapped, &ByteBufferBench::putArray);
+}
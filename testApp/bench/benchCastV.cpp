@@ -0,0 +1,51 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <string>
+#include <vector>
+
+#include <pv/pvIntrospect.h>
+#include <pv/typeCast.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+// castUnsafeV() of every numeric type pair
+struct CastVBench : public TimeFunctionRequester {
+    enum {count = 4096};
+    ScalarType to, from;
+    std::vector<double> in, out; // storage for count of the largest type
+    CastVBench(ScalarType to, ScalarType from)
+        :to(to), from(from), in(count), out(count)
+    {
+        // small positive values are in range for every type
+        std::vector<uint8> bytes(count);
+        for(size_t i=0; i<count; i++)
+            bytes[i] = uint8(i%100);
+        castUnsafeV(count, from, &in[0], pvUByte, &bytes[0]);
+    }
+    virtual ~CastVBench() {}
+    virtual void function()
+    {
+        castUnsafeV(count, to, &out[0], from, &in[0]);
+    }
+};
+}
+
+void benchCastV(BenchRunner& runner)
+{
+    for(int to=pvByte; to<=pvDouble; to++) {
+        for(int from=pvByte; from<=pvDouble; from++) {
+            std::string name("castUnsafeV ");
+            name += ScalarTypeFunc::name(ScalarType(from));
+            name += "->";
+            name += ScalarTypeFunc::name(ScalarType(to));
+            name += " x4096";
+            TimeFunctionRequesterPtr fn(new CastVBench(ScalarType(to), ScalarType(from)));
+            runner.run(name, fn);
+        }
+    }
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <sstream>
+
+#include <pv/pvData.h>
+#include <pv/convert.h>
+#include <pv/typeCast.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+struct ConvertBench {
+    enum {count = 1024};
+    ConvertPtr convert;
+    PVScalarPtr scalarDouble, scalarString;
+    PVScalarArrayPtr arrayShort;
+    shared_vector<const int16> shorts;
+    shared_vector<const double> doubles;
+    shared_vector<const int32> ints;
+    shared_vector<const std::string> strings, intStrings;
+    shared_vector<double> doubleOut;
+    shared_vector<int16> shortOut;
+    shared_vector<int32> intOut;
+    shared_vector<std::string> stringOut;
+    double sum;
+
+    ConvertBench()
+        :convert(getConvert())
+        ,scalarDouble(getPVDataCreate()->createPVScalar(pvDouble))
+        ,scalarString(getPVDataCreate()->createPVScalar(pvString))
+        ,arrayShort(getPVDataCreate()->createPVScalarArray(pvShort))
+        ,doubleOut(count)
+        ,shortOut(count)
+        ,intOut(count)
+        ,stringOut(count)
+        ,sum(0.0)
+    {
+        shared_vector<int16> S(count);
+        shared_vector<double> D(count);
+        shared_vector<std::string> T(count), IT(count);
+        shared_vector<int32> I(count);
+        for(size_t i=0; i<count; i++) {
+            S[i] = int16(i*31);
+            I[i] = int32(i*7919) - 4000000;
+            IT[i] = castUnsafe<std::string>(I[i]);
+            D[i] = i*1.25;
+            std::ostringstream strm;
+            strm<<D[i];
+            T[i] = strm.str();
+        }
+        shorts = freeze(S);
+        doubles = freeze(D);
+        strings = freeze(T);
+        ints = freeze(I);
+        intStrings = freeze(IT);
+        arrayShort->putFrom(shorts);
+        scalarDouble->putFrom<double>(3.14159);
+        scalarString->putFrom<std::string>("2.71828");
+    }
+    void scalarToString()
+    {
+        std::string val(scalarDouble->getAs<std::string>());
+        sum += val.size();
+    }
+    void scalarFromString()
+    {
+        convert->fromString(scalarDouble, "3.14159");
+    }
+    void scalarStringToDouble()
+    {
+        sum += scalarString->getAs<double>();
+    }
+    void shortToDouble()
+    {
+        castUnsafeV(count, pvDouble, doubleOut.data(), pvShort, shorts.data());
+    }
+    void doubleToShort()
+    {
+        castUnsafeV(count, pvShort, shortOut.data(), pvDouble, doubles.data());
+    }
+    void doubleToString()
+    {
+        castUnsafeV(count, pvString, stringOut.data(), pvDouble, doubles.data());
+    }
+    void stringToDouble()
+    {
+        castUnsafeV(count, pvDouble, doubleOut.data(), pvString, strings.data());
+    }
+    void intToString()
+    {
+        castUnsafeV(count, pvString, stringOut.data(), pvInt, ints.data());
+    }
+    void stringToInt()
+    {
+        castUnsafeV(count, pvInt, intOut.data(), pvString, intStrings.data());
+    }
+    void arrayGetAs()
+    {
+        shared_vector<const double> out;
+        arrayShort->getAs(out);
+        sum += out[0];
+    }
+};
+typedef std::tr1::shared_ptr<ConvertBench> ConvertBenchPtr;
+}
+
+void benchConvert(BenchRunner& runner)
+{
+    ConvertBenchPtr B(new ConvertBench);
+    runner.run("Convert double getAs<string>", B, &ConvertBench::scalarToString);
+    runner.run("Convert double fromString", B, &ConvertBench::scalarFromString);
+    runner.run("Convert string getAs<double>", B, &ConvertBench::scalarStringToDouble);
+    runner.run("Convert cast short->double x1024", B, &ConvertBench::shortToDouble);
+    runner.run("Convert cast double->short x1024", B, &ConvertBench::doubleToShort);
+    runner.run("Convert cast double->string x1024", B, &ConvertBench::doubleToString);
+    runner.run("Convert cast string->double x1024", B, &ConvertBench::stringToDouble);
+    runner.run("Convert cast int->string x1024", B, &ConvertBench::intToString);
+    runner.run("Convert cast string->int x1024", B, &ConvertBench::stringToInt);
+    runner.run("Convert short[1024] getAs<double>", B, &ConvertBench::arrayGetAs);
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <pv/pvData.h>
+#include <pv/createRequest.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+struct CreateRequestBench {
+    CreateRequest::shared_pointer creator;
+    std::string simple, complex;
+    PVStructurePtr result;
+    CreateRequestBench()
+        :creator(CreateRequest::create())
+        ,simple("field(value,alarm,timeStamp)")
+        ,complex("record[process=true,xxx=yyy]putField(power.value)"
+                 "getField(alarm,timeStamp,power{value,alarm},current{value,alarm},voltage{value,alarm},"
+                 "ps0{alarm,timeStamp[shareData=true],power{value,alarm},current{value,alarm}})")
+    {}
+    void create(const std::string& request)
+    {
+        result = creator->createRequest(request);
+        if(!result)
+            throw std::runtime_error(creator->getMessage());
+    }
+    void simpleCached() { create(simple); }
+    void complexCached() { create(complex); }
+    void simpleParsed() { CreateRequest::setCacheSize(0); create(simple); }
+    void complexParsed() { CreateRequest::setCacheSize(0); create(complex); }
+};
+typedef std::tr1::shared_ptr<CreateRequestBench> CreateRequestBenchPtr;
+}
+
+void benchCreateRequest(BenchRunner& runner)
+{
+    CreateRequestBenchPtr B(new CreateRequestBench);
+    runner.run("createRequest field(value,alarm,timeStamp)", B, &CreateRequestBench::simpleCached);
+    runner.run("createRequest 3 sections, 28 fields", B, &CreateRequestBench::complexCached);
+    runner.run("createRequest field(value,alarm,timeStamp) no cache", B, &CreateRequestBench::simpleParsed);
+    runner.run("createRequest 3 sections, 28 fields no cache", B, &CreateRequestBench::complexParsed);
+    CreateRequest::setCacheSize(128);
+}
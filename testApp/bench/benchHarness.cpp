@@ -0,0 +1,186 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <map>
+#include <fstream>
+#include <sstream>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+#if __cplusplus>=201103L
+#  define BENCH_THROW_BADALLOC
+#  define BENCH_NOTHROW noexcept
+#else
+#  define BENCH_THROW_BADALLOC throw(std::bad_alloc)
+#  define BENCH_NOTHROW throw()
+#endif
+
+namespace {
+// only read and written by the thread running the benchmarks,
+// see BenchRunner::runThreaded()
+size_t allocCount;
+
+void *countedAlloc(std::size_t n)
+{
+    allocCount++;
+    void *ret = malloc(n ? n : 1);
+    if(!ret)
+        throw std::bad_alloc();
+    return ret;
+}
+}
+
+void* operator new(std::size_t n) BENCH_THROW_BADALLOC { return countedAlloc(n); }
+void* operator new[](std::size_t n) BENCH_THROW_BADALLOC { return countedAlloc(n); }
+void operator delete(void *p) BENCH_NOTHROW { free(p); }
+void operator delete[](void *p) BENCH_NOTHROW { free(p); }
+
+size_t benchAllocations()
+{
+    return allocCount;
+}
+
+BenchRunner::BenchRunner(int argc, char *argv[])
+    :warmup(0.2)
+    ,duration(1.0)
+    ,tolerance(0.1)
+    ,badArgs(false)
+{
+    for(int i=1; i<argc; i++) {
+        const char *arg = argv[i];
+        if(arg[0]!='-' || !arg[1] || arg[2] || i+1>=argc) {
+            badArgs = true;
+            break;
+        }
+        const char *val = argv[++i];
+        switch(arg[1]) {
+        case 'w': warmup = atof(val); break;
+        case 't': duration = atof(val); break;
+        case 'r': tolerance = atof(val); break;
+        case 'f': filter = val; break;
+        case 'o': output = val; break;
+        case 'b': baseline = val; break;
+        default: badArgs = true;
+        }
+    }
+    if(badArgs)
+        fprintf(stderr, "Usage: %s [-w warmup] [-t seconds] [-f filter] [-o results.txt]"
+                        " [-b baseline.txt] [-r tolerance]\n", argv[0]);
+    else
+        printf("%-36s %12s %10s %10s %10s %10s %8s\n",
+               "benchmark", "calls", "mean ns", "p50 ns", "p99 ns", "p999 ns", "allocs");
+}
+
+void BenchRunner::run(const std::string& name, TimeFunctionRequesterPtr const & fn)
+{
+    runBench(name, fn, true);
+}
+
+void BenchRunner::runThreaded(const std::string& name, TimeFunctionRequesterPtr const & fn)
+{
+    runBench(name, fn, false);
+}
+
+void BenchRunner::runBench(const std::string& name, TimeFunctionRequesterPtr const & fn,
+                           bool countAllocs)
+{
+    if(badArgs || name.find(filter)==std::string::npos)
+        return;
+
+    Result R;
+    R.name = name;
+    R.allocs = -1.0;
+
+    if(countAllocs) {
+        const size_t allocCalls = 1000;
+        size_t before = benchAllocations();
+        for(size_t i=0; i<allocCalls; i++)
+            fn->function();
+        R.allocs = double(benchAllocations()-before)/allocCalls;
+    }
+
+    TimeFunction timer(fn);
+    R.stats = timer.timeCalls(warmup, duration);
+    results.push_back(R);
+
+    printf("%-36s %12llu %10.1f %10.1f %10.1f %10.1f ",
+           name.c_str(), (unsigned long long)R.stats.calls,
+           R.stats.mean*1e9, R.stats.p50*1e9, R.stats.p99*1e9, R.stats.p999*1e9);
+    if(countAllocs)
+        printf("%8.2f\n", R.allocs);
+    else
+        printf("%8s\n", "-");
+    fflush(stdout);
+}
+
+int BenchRunner::finish()
+{
+    if(badArgs)
+        return 2;
+
+    if(!output.empty()) {
+        std::ofstream strm(output.c_str());
+        strm<<"# name\tcalls\tmean_ns\tp50_ns\tp99_ns\tp999_ns\tallocs_per_call\n";
+        for(size_t i=0; i<results.size(); i++) {
+            const Result& R = results[i];
+            strm<<R.name<<'\t'<<R.stats.calls
+                <<'\t'<<R.stats.mean*1e9<<'\t'<<R.stats.p50*1e9
+                <<'\t'<<R.stats.p99*1e9<<'\t'<<R.stats.p999*1e9
+                <<'\t'<<R.allocs<<'\n';
+        }
+        if(!strm.good()) {
+            fprintf(stderr, "Error writing %s\n", output.c_str());
+            return 2;
+        }
+    }
+
+    int ret = 0;
+    if(!baseline.empty()) {
+        std::ifstream strm(baseline.c_str());
+        if(!strm.is_open()) {
+            fprintf(stderr, "Can't read %s\n", baseline.c_str());
+            return 2;
+        }
+        // name -> (p50, allocs)
+        std::map<std::string, std::pair<double, double> > base;
+        std::string line;
+        while(std::getline(strm, line)) {
+            if(line.empty() || line[0]=='#')
+                continue;
+            std::istringstream fields(line);
+            std::string name;
+            double calls, mean, p50, p99, p999, allocs;
+            if(std::getline(fields, name, '\t')
+                    && fields>>calls>>mean>>p50>>p99>>p999>>allocs)
+                base[name] = std::make_pair(p50, allocs);
+        }
+
+        printf("\n%-36s %10s %10s %8s\n", "compared with baseline", "p50 ns", "base ns", "ratio");
+        for(size_t i=0; i<results.size(); i++) {
+            const Result& R = results[i];
+            std::map<std::string, std::pair<double, double> >::const_iterator it = base.find(R.name);
+            if(it==base.end()) {
+                printf("%-36s %10.1f %10s\n", R.name.c_str(), R.stats.p50*1e9, "-");
+                continue;
+            }
+            double ratio = R.stats.p50*1e9/it->second.first;
+            bool slower = ratio>1.0+tolerance;
+            bool moreAllocs = R.allocs>=0.0 && it->second.second>=0.0
+                    && R.allocs>it->second.second;
+            printf("%-36s %10.1f %10.1f %8.3f%s%s\n", R.name.c_str(), R.stats.p50*1e9,
+                   it->second.first, ratio,
+                   slower ? " SLOWER" : "",
+                   moreAllocs ? " MORE ALLOCATIONS" : "");
+            if(slower || moreAllocs)
+                ret = 1;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/*
+ * Micro-benchmark harness built on TimeFunction::timeCalls().
+ * Not a unit test.
+ */
+#ifndef BENCHHARNESS_H
+#define BENCHHARNESS_H
+
+#include <string>
+#include <vector>
+
+#include <pv/sharedPtr.h>
+#include <pv/timeFunction.h>
+
+//! Adapts a method of a benchmark fixture to TimeFunctionRequester
+template<typename C>
+class BenchMethod : public epics::pvData::TimeFunctionRequester {
+public:
+    typedef void (C::*meth_t)();
+    BenchMethod(std::tr1::shared_ptr<C> const & inst, meth_t meth)
+        :inst(inst), meth(meth)
+    {}
+    virtual void function() { ((*inst).*meth)(); }
+private:
+    std::tr1::shared_ptr<C> inst;
+    meth_t meth;
+};
+
+/**
+ * Runs benchmarks and reports per call statistics.
+ *
+ @code
+   pvDataBench [-w warmup] [-t seconds] [-f filter] [-o results.txt]
+               [-b baseline.txt] [-r tolerance]
+ @endcode
+ * -w Seconds of warmup before each benchmark.  Default 0.2
+ * -t Seconds to time each benchmark.  Default 1.0
+ * -f Only run benchmarks whose name contains this string.
+ * -o Write results as tab separated values.  allocs is -1 when not counted.
+ * -b Compare median times with a file written by -o.
+ * -r Fraction by which a median may exceed the baseline.  Default 0.1
+ *
+ * The heap allocations per call are counted in a separate untimed pass.
+ * The count is not thread safe, so a benchmark which runs code on other
+ * threads (eg. ArrayKernels::setParallel()) must use runThreaded(),
+ * which skips the counting pass.
+ */
+class BenchRunner {
+public:
+    BenchRunner(int argc, char *argv[]);
+    //! Time one benchmark, unless excluded by the filter
+    void run(const std::string& name,
+             epics::pvData::TimeFunctionRequesterPtr const & fn);
+    //! Time calls of inst->meth()
+    template<typename C>
+    void run(const std::string& name, std::tr1::shared_ptr<C> const & inst, void (C::*meth)())
+    {
+        run(name, epics::pvData::TimeFunctionRequesterPtr(new BenchMethod<C>(inst, meth)));
+    }
+    //! Time one benchmark which uses other threads.  Allocations are not counted.
+    void runThreaded(const std::string& name,
+                     epics::pvData::TimeFunctionRequesterPtr const & fn);
+    //! Time calls of inst->meth(), which uses other threads
+    template<typename C>
+    void runThreaded(const std::string& name, std::tr1::shared_ptr<C> const & inst, void (C::*meth)())
+    {
+        runThreaded(name, epics::pvData::TimeFunctionRequesterPtr(new BenchMethod<C>(inst, meth)));
+    }
+    //! Write results and compare with the baseline.
+    //! @return exit code.  Non-zero for bad arguments or a regression.
+    int finish();
+private:
+    struct Result {
+        std::string name;
+        epics::pvData::TimeStatistics stats;
+        // per call, or negative if not counted
+        double allocs;
+    };
+    void runBench(const std::string& name,
+                  epics::pvData::TimeFunctionRequesterPtr const & fn,
+                  bool countAllocs);
+    std::vector<Result> results;
+    double warmup, duration, tolerance;
+    std::string filter, output, baseline;
+    bool badArgs;
+};
+
+//! Number of calls to the global operator new so far
+size_t benchAllocations();
+
+#endif /* BENCHHARNESS_H */
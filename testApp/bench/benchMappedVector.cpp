@@ -0,0 +1,70 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <cstdio>
+#include <vector>
+
+#include <pv/mappedVector.h>
+#include <pv/pvData.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+// file is in the page cache, so these compare copying with mapping
+struct MappedVectorBench {
+    enum {count = 1024*1024};
+    std::string fname;
+    PVDoubleArrayPtr arr;
+    double sum;
+    MappedVectorBench()
+        :fname("pvDataBench.tmp")
+        ,arr(getPVDataCreate()->createPVScalarArray<PVDoubleArray>())
+        ,sum(0.0)
+    {
+        std::vector<double> data(count, 1.0);
+        FILE *fp = fopen(fname.c_str(), "wb");
+        if(fp) {
+            fwrite(&data[0], sizeof(double), count, fp);
+            fclose(fp);
+        }
+    }
+    ~MappedVectorBench()
+    {
+        remove(fname.c_str());
+    }
+    void readReplace()
+    {
+        PVDoubleArray::svector temp(count);
+        FILE *fp = fopen(fname.c_str(), "rb");
+        if(fp) {
+            size_t n = fread(temp.data(), sizeof(double), count, fp);
+            temp.resize(n);
+            fclose(fp);
+        }
+        arr->replace(freeze(temp));
+    }
+    void mapReplace()
+    {
+        arr->replace(mapFileVector<double>(fname));
+    }
+    void mapSum()
+    {
+        shared_vector<const double> temp(mapFileVector<double>(fname));
+        // touch one element per page
+        for(size_t i=0; i<temp.size(); i+=512)
+            sum += temp[i];
+    }
+};
+typedef std::tr1::shared_ptr<MappedVectorBench> MappedVectorBenchPtr;
+}
+
+void benchMappedVector(BenchRunner& runner)
+{
+    MappedVectorBenchPtr B(new MappedVectorBench);
+    runner.run("PVDoubleArray fread+replace 8MB", B, &MappedVectorBench::readReplace);
+    runner.run("PVDoubleArray mapFile+replace 8MB", B, &MappedVectorBench::mapReplace);
+    runner.run("mapFileVector touch pages 8MB", B, &MappedVectorBench::mapSum);
+}
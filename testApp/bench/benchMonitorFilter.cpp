@@ -0,0 +1,173 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <vector>
+#include <cmath>
+
+#include <pv/pvData.h>
+#include <pv/standardPVField.h>
+#include <pv/bitSet.h>
+#include <pv/pvCopy.h>
+#include <pv/createRequest.h>
+#include <pv/monitor.h>
+#include <pv/monitorFilter.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+
+// The shape of MonitorPlugin::causeMonitor(), called for each changed field
+struct FieldPlugin {
+    virtual ~FieldPlugin() {}
+    virtual bool causeMonitor(PVFieldPtr const &pvField,
+                              PVStructurePtr const &pvTop,
+                              MonitorElementPtr const &monitorElement) = 0;
+};
+
+struct DeadbandPlugin : public FieldPlugin {
+    double deadband, last;
+    bool first;
+    explicit DeadbandPlugin(double deadband) :deadband(deadband), last(0.0), first(true) {}
+    virtual ~DeadbandPlugin() {}
+    virtual bool causeMonitor(PVFieldPtr const &pvField,
+                              PVStructurePtr const &pvTop,
+                              MonitorElementPtr const &monitorElement)
+    {
+        double value = std::tr1::static_pointer_cast<PVDouble>(pvField)->get();
+        if(!first && std::fabs(value-last)<=deadband) {
+            monitorElement->changedBitSet->clear(pvField->getFieldOffset());
+            return false;
+        }
+        first = false;
+        last = value;
+        return true;
+    }
+};
+
+struct QuietPlugin : public FieldPlugin {
+    virtual ~QuietPlugin() {}
+    virtual bool causeMonitor(PVFieldPtr const &, PVStructurePtr const &, MonitorElementPtr const &)
+    { return false; }
+};
+
+/* One update of an NTScalar double, with a value deadband and timeStamp[trigger=false],
+ * checked for 2000 subscribers.  The value moves by less than the deadband
+ * on most updates.
+ */
+struct MonitorFilterBench {
+    enum {nsubscribers = 2000};
+    PVStructurePtr master, copy;
+    MonitorElementPtr element;
+    BitSet changed;
+    uint32 valueOffset;
+    double value;
+    size_t sent;
+
+    std::vector<MonitorFilter> filters, throttled;
+    typedef std::vector<std::tr1::shared_ptr<FieldPlugin> > plugins_t;
+    std::vector<plugins_t> plugins;
+
+    MonitorFilterBench()
+        :master(getStandardPVField()->scalar(pvDouble, "alarm,timeStamp"))
+        ,value(0.0)
+        ,sent(0)
+    {
+        PVCopyPtr pvCopy(PVCopy::create(master,
+                                        CreateRequest::create()->createRequest(
+                                            "field(value[deadband=0.5],alarm,timeStamp[trigger=false])"),
+                                        ""));
+        copy = pvCopy->createPVStructure();
+        element.reset(new MonitorElement(copy));
+        valueOffset = static_cast<uint32>(copy->getSubFieldT("value")->getFieldOffset());
+        changed.set(valueOffset);
+        changed.set(static_cast<uint32>(copy->getSubFieldT("timeStamp.secondsPastEpoch")->getFieldOffset()));
+        changed.set(static_cast<uint32>(copy->getSubFieldT("timeStamp.nanoseconds")->getFieldOffset()));
+
+        MonitorFilter filter(*pvCopy);
+        filters.resize(nsubscribers, filter);
+        PVCopyPtr throttleCopy(PVCopy::create(master,
+                                              CreateRequest::create()->createRequest(
+                                                  "field(value[deadband=5%],alarm,timeStamp[trigger=false,throttle=1])"),
+                                              ""));
+        MonitorFilter throttle(*throttleCopy);
+        throttled.resize(nsubscribers, throttle);
+
+        plugins_t P(copy->getNumberFields());
+        P[valueOffset].reset(new DeadbandPlugin(0.5));
+        PVStructurePtr timeStamp(copy->getSubFieldT<PVStructure>("timeStamp"));
+        for(size_t i=timeStamp->getFieldOffset(); i<timeStamp->getNextFieldOffset(); i++)
+            P[i].reset(new QuietPlugin);
+        for(unsigned i=0; i<nsubscribers; i++) {
+            plugins_t S(P.size());
+            for(size_t f=0; f<P.size(); f++) {
+                if(dynamic_cast<DeadbandPlugin*>(P[f].get()))
+                    S[f].reset(new DeadbandPlugin(0.5));
+                else
+                    S[f] = P[f];
+            }
+            plugins.push_back(S);
+        }
+    }
+
+    // 10 updates per second of timeStamp
+    void nextValue()
+    {
+        value += 0.1;
+        copy->getSubFieldT<PVDouble>("value")->put(value);
+        int64 tenths = static_cast<int64>(value*10.0+0.5);
+        copy->getSubFieldT<PVLong>("timeStamp.secondsPastEpoch")->put(tenths/10);
+        copy->getSubFieldT<PVInt>("timeStamp.nanoseconds")->put(static_cast<int32>(tenths%10)*100000000);
+    }
+
+    void plugin()
+    {
+        nextValue();
+        BitSet& elemChanged = *element->changedBitSet;
+        for(unsigned s=0; s<nsubscribers; s++) {
+            elemChanged = changed;
+            plugins_t& P = plugins[s];
+            bool trigger = false;
+            for(int32 bit = changed.nextSetBit(0); bit>=0; bit = changed.nextSetBit(bit+1)) {
+                PVFieldPtr field(copy->getSubField(bit));
+                if(!P[bit])
+                    trigger = true;
+                else if(P[bit]->causeMonitor(field, copy, element))
+                    trigger = true;
+            }
+            sent += trigger;
+        }
+    }
+
+    void compiled()
+    {
+        nextValue();
+        BitSet& elemChanged = *element->changedBitSet;
+        for(unsigned s=0; s<nsubscribers; s++) {
+            elemChanged = changed;
+            sent += filters[s].filter(*element);
+        }
+    }
+
+    void throttle()
+    {
+        nextValue();
+        BitSet& elemChanged = *element->changedBitSet;
+        for(unsigned s=0; s<nsubscribers; s++) {
+            elemChanged = changed;
+            sent += throttled[s].filter(*element);
+        }
+    }
+};
+typedef std::tr1::shared_ptr<MonitorFilterBench> MonitorFilterBenchPtr;
+}
+
+void benchMonitorFilter(BenchRunner& runner)
+{
+    MonitorFilterBenchPtr B(new MonitorFilterBench);
+    runner.run("monitor filter x2000 per-field virtual", B, &MonitorFilterBench::plugin);
+    runner.run("monitor filter x2000 MonitorFilter", B, &MonitorFilterBench::compiled);
+    runner.run("monitor filter x2000 deadband+throttle", B, &MonitorFilterBench::throttle);
+}
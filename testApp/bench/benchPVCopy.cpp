@@ -0,0 +1,121 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <sstream>
+
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+#include <pv/bitSet.h>
+#include <pv/pvCopy.h>
+#include <pv/createRequest.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+// 200 channels of {value,alarm,timeStamp}, of which the copy has {value,alarm}
+struct PVCopyBench {
+    enum {nchannels = 200};
+    PVStructurePtr master, copy;
+    PVCopyPtr pvCopy;
+    BitSetPtr changed1, changed10, changed100;
+    PVFieldPtrArray masterValues;
+    size_t sum;
+
+    PVCopyBench()
+        :sum(0)
+    {
+        StringArray names;
+        FieldConstPtrArray fields;
+        std::ostringstream request;
+        for(unsigned i=0; i<nchannels; i++) {
+            std::ostringstream name;
+            name<<"ch"<<i;
+            names.push_back(name.str());
+            fields.push_back(getStandardField()->scalar(pvDouble, "alarm,timeStamp"));
+            request<<(i ? "," : "")<<name.str()<<"{value,alarm}";
+        }
+        master = getPVDataCreate()->createPVStructure(getFieldCreate()->createStructure(names, fields));
+        pvCopy = PVCopy::create(master, CreateRequest::create()->createRequest(request.str()), "");
+        copy = pvCopy->createPVStructure();
+        changed1 = changed(100);
+        changed10 = changed(10);
+        changed100 = changed(1);
+        for(unsigned i=0; i<nchannels; i++)
+            masterValues.push_back(master->getSubFieldT(names[i]+".value"));
+    }
+    // the value of every n'th channel
+    BitSetPtr changed(unsigned n)
+    {
+        BitSetPtr ret(new BitSet(copy->getNumberFields()));
+        for(unsigned i=0; i<nchannels; i+=n) {
+            std::ostringstream name;
+            name<<"ch"<<i<<".value";
+            ret->set(copy->getSubFieldT(name.str())->getFieldOffset());
+        }
+        return ret;
+    }
+    void toCopy1() { pvCopy->updateCopyFromBitSet(copy, changed1); }
+    void toCopy10() { pvCopy->updateCopyFromBitSet(copy, changed10); }
+    void toCopy100() { pvCopy->updateCopyFromBitSet(copy, changed100); }
+    void toMaster1() { pvCopy->updateMaster(copy, changed1); }
+    void toMaster10() { pvCopy->updateMaster(copy, changed10); }
+    void toMaster100() { pvCopy->updateMaster(copy, changed100); }
+    void setBitSet() { changed100->clear(); pvCopy->updateCopySetBitSet(copy, changed100); }
+    // as a monitor does when a master field is put
+    void copyOffsets()
+    {
+        for(size_t i=0; i<masterValues.size(); i++)
+            sum += pvCopy->getCopyOffset(masterValues[i]);
+    }
+    void masterFields()
+    {
+        for(size_t i=1; i<copy->getNumberFields(); i++)
+            sum += pvCopy->getMasterPVField(i)->getFieldOffset();
+    }
+};
+typedef std::tr1::shared_ptr<PVCopyBench> PVCopyBenchPtr;
+
+// A subscriber connecting: PVCopy, its copy structure, and a BitSet
+struct PVCopySubscribeBench {
+    PVStructurePtr master, request;
+    PVCopyPtr held; // another subscriber
+    PVStructurePtr copy;
+    BitSetPtr changed;
+    PVCopySubscribeBench()
+        :master(getPVDataCreate()->createPVStructure(
+                    getStandardField()->scalar(pvDouble, "alarm,timeStamp,display,control,valueAlarm")))
+        ,request(CreateRequest::create()->createRequest("field(value,alarm,timeStamp)"))
+        ,held(PVCopy::createShared(master, request, ""))
+    {}
+    void subscribe(const PVCopyPtr& pvCopy)
+    {
+        copy = pvCopy->createPVStructure();
+        changed.reset(new BitSet(copy->getNumberFields()));
+        pvCopy->initCopy(copy, changed);
+    }
+    void create() { subscribe(PVCopy::create(master, request, "")); }
+    void createShared() { subscribe(PVCopy::createShared(master, request, "")); }
+};
+typedef std::tr1::shared_ptr<PVCopySubscribeBench> PVCopySubscribeBenchPtr;
+}
+
+void benchPVCopy(BenchRunner& runner)
+{
+    PVCopyBenchPtr B(new PVCopyBench);
+    runner.run("PVCopy updateCopyFromBitSet 1%", B, &PVCopyBench::toCopy1);
+    runner.run("PVCopy updateCopyFromBitSet 10%", B, &PVCopyBench::toCopy10);
+    runner.run("PVCopy updateCopyFromBitSet 100%", B, &PVCopyBench::toCopy100);
+    runner.run("PVCopy updateMaster 1%", B, &PVCopyBench::toMaster1);
+    runner.run("PVCopy updateMaster 10%", B, &PVCopyBench::toMaster10);
+    runner.run("PVCopy updateMaster 100%", B, &PVCopyBench::toMaster100);
+    runner.run("PVCopy updateCopySetBitSet", B, &PVCopyBench::setBitSet);
+    runner.run("PVCopy getCopyOffset x200", B, &PVCopyBench::copyOffsets);
+    runner.run("PVCopy getMasterPVField x1200", B, &PVCopyBench::masterFields);
+
+    PVCopySubscribeBenchPtr S(new PVCopySubscribeBench);
+    runner.run("PVCopy subscribe create", S, &PVCopySubscribeBench::create);
+    runner.run("PVCopy subscribe createShared", S, &PVCopySubscribeBench::createShared);
+}
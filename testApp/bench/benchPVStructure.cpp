@@ -0,0 +1,383 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <vector>
+#include <cstdio>
+
+#include <pv/pvData.h>
+#include <pv/standardPVField.h>
+#include <pv/byteBuffer.h>
+#include <pv/bitSet.h>
+#include <pv/serialize.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+struct BufferControl : public SerializableControl, public DeserializableControl {
+    virtual void flushSerializeBuffer() {}
+    virtual void ensureBuffer(std::size_t) {}
+    virtual void alignBuffer(std::size_t alignment) { buffer->align(alignment); }
+    virtual bool directSerialize(ByteBuffer*, const char*, std::size_t, std::size_t) { return false; }
+    virtual void cachedSerialize(std::tr1::shared_ptr<const Field> const & field, ByteBuffer* buffer)
+    { field->serialize(buffer, this); }
+    virtual void ensureData(std::size_t) {}
+    virtual void alignData(std::size_t alignment) { buffer->align(alignment); }
+    virtual bool directDeserialize(ByteBuffer*, char*, std::size_t, std::size_t) { return false; }
+    virtual std::tr1::shared_ptr<const Field> cachedDeserialize(ByteBuffer* buffer)
+    { return getFieldCreate()->deserialize(buffer, this); }
+    ByteBuffer *buffer;
+};
+
+struct PVStructureBench {
+    StandardPVFieldPtr standard;
+    ScalarType type;
+    std::string properties;
+    PVStructurePtr src, dest;
+    PVFieldPtr destValue;
+    BitSet changed;
+    ByteBuffer buf;
+    BufferControl control;
+
+    PVStructureBench(ScalarType type, bool array, size_t count)
+        :standard(getStandardPVField())
+        ,type(type)
+        ,properties("alarm,timeStamp,display,control")
+        ,src(array ? standard->scalarArray(type, properties) : standard->scalar(type, properties))
+        ,dest(getPVDataCreate()->createPVStructure(src->getStructure()))
+        ,buf(64*1024 + count*8)
+    {
+        control.buffer = &buf;
+        destValue = dest->getSubFieldT("value");
+        if(type==pvString && !array) {
+            const char *names[] = {"value", "display.description", "display.format", "display.units"};
+            for(size_t i=0; i<4; i++)
+                src->getSubFieldT<PVString>(names[i])->put("a string which is too long for SSO");
+        }
+        if(array) {
+            PVScalarArrayPtr value(src->getSubFieldT<PVScalarArray>("value"));
+            if(type==pvString) {
+                value->setLength(count);
+            } else {
+                // initialized, so compare() does not meet NaN
+                shared_vector<double> init(count, 1.0);
+                value->putFrom(freeze(init));
+            }
+        }
+        // value and alarm.severity
+        changed.set(src->getSubFieldT("value")->getFieldOffset());
+        changed.set(src->getSubFieldT("alarm.severity")->getFieldOffset());
+        dest->copyUnchecked(*src);
+    }
+    void create()
+    {
+        PVStructurePtr temp(getPVDataCreate()->createPVStructure(src->getStructure()));
+    }
+    void copy()
+    {
+        dest->copyUnchecked(*src);
+    }
+    // as done by PVCopy for every monitor update
+    void compare()
+    {
+        if(*dest!=*src)
+            throw std::logic_error("not equal");
+    }
+    void serialize()
+    {
+        buf.clear();
+        src->serialize(&buf, &control);
+    }
+    void serializeChanged()
+    {
+        buf.clear();
+        src->serialize(&buf, &control, &changed);
+    }
+    void roundTrip()
+    {
+        buf.clear();
+        src->serialize(&buf, &control);
+        buf.flip();
+        dest->deserialize(&buf, &control);
+    }
+    // as when the previous value is still queued for a client
+    void roundTripShared()
+    {
+        buf.clear();
+        src->serialize(&buf, &control);
+        buf.flip();
+        PVDoubleArray::const_svector held(std::tr1::static_pointer_cast<PVDoubleArray>(destValue)->view());
+        dest->deserialize(&buf, &control);
+    }
+};
+typedef std::tr1::shared_ptr<PVStructureBench> PVStructureBenchPtr;
+
+// 1000 records, each with value and alarm.severity put, then the changes collected
+struct TrackChangesBench {
+    enum {nrecords = 1000};
+    struct Marker : public PostHandler {
+        BitSet *changed;
+        uint32 offset;
+        Marker(BitSet *changed, uint32 offset) :changed(changed), offset(offset) {}
+        virtual ~Marker() {}
+        virtual void postPut() { changed->set(offset); }
+    };
+    struct Record {
+        PVStructurePtr top;
+        PVDoublePtr value;
+        PVIntPtr severity;
+        BitSet changed; // when using PostHandlers
+    };
+    std::vector<Record> handlers, tracked;
+    BitSet collected;
+    size_t count;
+
+    TrackChangesBench()
+        :handlers(nrecords)
+        ,tracked(nrecords)
+        ,count(0)
+    {
+        for(size_t i=0; i<nrecords; i++) {
+            init(handlers[i]);
+            // as a monitor provider does
+            PVFieldPtrArray fields;
+            fields.push_back(handlers[i].top->getSubFieldT("value"));
+            fields.push_back(handlers[i].top->getSubFieldT("alarm.severity"));
+            fields.push_back(handlers[i].top->getSubFieldT("alarm.status"));
+            fields.push_back(handlers[i].top->getSubFieldT("alarm.message"));
+            for(size_t f=0; f<fields.size(); f++)
+                fields[f]->setPostHandler(PostHandlerPtr(new Marker(&handlers[i].changed,
+                                                                    fields[f]->getFieldOffset())));
+            init(tracked[i]);
+            tracked[i].top->setTrackChanges(true);
+        }
+    }
+    static void init(Record& rec)
+    {
+        rec.top = getStandardPVField()->scalar(pvDouble, "alarm,timeStamp");
+        rec.value = rec.top->getSubFieldT<PVDouble>("value");
+        rec.severity = rec.top->getSubFieldT<PVInt>("alarm.severity");
+    }
+    void postHandler()
+    {
+        for(size_t i=0; i<nrecords; i++) {
+            handlers[i].value->put(i);
+            handlers[i].severity->put(1);
+        }
+        for(size_t i=0; i<nrecords; i++) {
+            collected.swap(handlers[i].changed);
+            handlers[i].changed.clear();
+            count += collected.cardinality();
+        }
+    }
+    void trackChanges()
+    {
+        for(size_t i=0; i<nrecords; i++) {
+            tracked[i].value->put(i);
+            tracked[i].severity->put(1);
+        }
+        for(size_t i=0; i<nrecords; i++) {
+            tracked[i].top->takeChanges(collected);
+            count += collected.cardinality();
+        }
+    }
+};
+typedef std::tr1::shared_ptr<TrackChangesBench> TrackChangesBenchPtr;
+
+// 100 put()s of a field with 0, 1, or 3 PostHandlers
+struct PostHandlerBench {
+    struct Counter : public PostHandler {
+        size_t count;
+        Counter() :count(0) {}
+        virtual ~Counter() {}
+        virtual void postPut() { count++; }
+    };
+    PVStructurePtr none, one, three;
+    PVDoublePtr noneValue, oneValue, threeValue;
+
+    PostHandlerBench()
+        :none(getStandardPVField()->scalar(pvDouble, "alarm,timeStamp"))
+        ,one(getStandardPVField()->scalar(pvDouble, "alarm,timeStamp"))
+        ,three(getStandardPVField()->scalar(pvDouble, "alarm,timeStamp"))
+        ,noneValue(none->getSubFieldT<PVDouble>("value"))
+        ,oneValue(one->getSubFieldT<PVDouble>("value"))
+        ,threeValue(three->getSubFieldT<PVDouble>("value"))
+    {
+        oneValue->addPostHandler(PostHandlerPtr(new Counter));
+        for(unsigned i=0; i<3; i++)
+            threeValue->addPostHandler(PostHandlerPtr(new Counter));
+    }
+    static void puts(PVDouble& value)
+    {
+        for(unsigned i=0; i<100; i++)
+            value.put(i);
+    }
+    void putNone() { puts(*noneValue); }
+    void putOne() { puts(*oneValue); }
+    void putThree() { puts(*threeValue); }
+    void groupPutThree()
+    {
+        three->beginGroupPut();
+        puts(*threeValue);
+        three->endGroupPut();
+    }
+};
+typedef std::tr1::shared_ptr<PostHandlerBench> PostHandlerBenchPtr;
+
+// A record update writing 30 fields, seen by a monitor
+struct GroupPutBench {
+    struct Monitor : public PostHandler, public GroupPutHandler {
+        BitSet changed;
+        size_t wakeups;
+        Monitor() :wakeups(0) {}
+        virtual ~Monitor() {}
+        virtual void postPut() { wakeups++; }
+        virtual void postGroupPut(const PVStructure&, const BitSet& changed) { this->changed |= changed; wakeups++; }
+    };
+    std::tr1::shared_ptr<Monitor> monitor;
+    PVStructurePtr each, grouped;
+    std::vector<PVDoublePtr> eachFields, groupedFields;
+
+    GroupPutBench()
+        :monitor(new Monitor)
+    {
+        FieldBuilderPtr builder(getFieldCreate()->createFieldBuilder());
+        for(unsigned i=0; i<30; i++) {
+            char name[8];
+            sprintf(name, "f%u", i);
+            builder->add(name, pvDouble);
+        }
+        StructureConstPtr type(builder->createStructure());
+        each = getPVDataCreate()->createPVStructure(type);
+        grouped = getPVDataCreate()->createPVStructure(type);
+        for(size_t i=0; i<type->getNumberFields(); i++) {
+            eachFields.push_back(std::tr1::static_pointer_cast<PVDouble>(each->getPVFields()[i]));
+            eachFields.back()->addPostHandler(monitor);
+            groupedFields.push_back(std::tr1::static_pointer_cast<PVDouble>(grouped->getPVFields()[i]));
+        }
+        grouped->addGroupPutHandler(monitor);
+    }
+    void postEach()
+    {
+        for(size_t i=0; i<eachFields.size(); i++)
+            eachFields[i]->put(i);
+    }
+    void groupPut()
+    {
+        grouped->beginGroupPut();
+        for(size_t i=0; i<groupedFields.size(); i++)
+            groupedFields[i]->put(i);
+        grouped->endGroupPut();
+    }
+};
+typedef std::tr1::shared_ptr<GroupPutBench> GroupPutBenchPtr;
+
+// An NTNDArray-like value union receiving updates which alternate between two types
+struct UnionFlipBench {
+    PVUnionPtr regular[2], variant[2], dest, variantDest;
+    std::vector<char> encoded[4];
+    BufferControl control;
+
+    UnionFlipBench()
+    {
+        UnionConstPtr type(getFieldCreate()->createFieldBuilder()
+                           ->addArray("ubyteValue", pvUByte)
+                           ->addArray("shortValue", pvShort)
+                           ->addArray("floatValue", pvFloat)
+                           ->addArray("doubleValue", pvDouble)
+                           ->createUnion());
+        for(unsigned i=0; i<2; i++) {
+            regular[i] = getPVDataCreate()->createPVUnion(type);
+            variant[i] = getPVDataCreate()->createPVUnion(getFieldCreate()->createVariantUnion());
+        }
+        shared_vector<uint8> bytes(16, 1);
+        shared_vector<double> doubles(16, 1.0);
+        regular[0]->select<PVUByteArray>("ubyteValue")->replace(freeze(bytes));
+        regular[1]->select<PVDoubleArray>("doubleValue")->replace(freeze(doubles));
+        variant[0]->set(regular[0]->get());
+        variant[1]->set(regular[1]->get());
+        dest = getPVDataCreate()->createPVUnion(type);
+        variantDest = getPVDataCreate()->createPVUnion(getFieldCreate()->createVariantUnion());
+
+        // the encoded updates
+        PVUnionPtr *sources[2] = {regular, variant};
+        for(unsigned i=0; i<4; i++) {
+            ByteBuffer buf(1024);
+            control.buffer = &buf;
+            sources[i/2][i%2]->serialize(&buf, &control);
+            encoded[i].assign(buf.getBuffer(), buf.getBuffer()+buf.getPosition());
+        }
+    }
+    void receive(PVUnion& to, std::vector<char>& from)
+    {
+        ByteBuffer buf(&from[0], from.size());
+        control.buffer = &buf;
+        to.deserialize(&buf, &control);
+    }
+    void deserialize()
+    {
+        receive(*dest, encoded[0]);
+        receive(*dest, encoded[1]);
+    }
+    void deserializeVariant()
+    {
+        receive(*variantDest, encoded[2]);
+        receive(*variantDest, encoded[3]);
+    }
+    void select()
+    {
+        dest->select(0);
+        dest->select(3);
+    }
+};
+typedef std::tr1::shared_ptr<UnionFlipBench> UnionFlipBenchPtr;
+}
+
+void benchPVStructure(BenchRunner& runner)
+{
+    PVStructureBenchPtr scalar(new PVStructureBench(pvDouble, false, 0));
+    runner.run("PVStructure create scalar", scalar, &PVStructureBench::create);
+    runner.run("PVStructure copy scalar", scalar, &PVStructureBench::copy);
+    runner.run("PVStructure serialize scalar", scalar, &PVStructureBench::serialize);
+    runner.run("PVStructure serialize changed scalar", scalar, &PVStructureBench::serializeChanged);
+    runner.run("PVStructure ser+deser scalar", scalar, &PVStructureBench::roundTrip);
+
+    PVStructureBenchPtr array(new PVStructureBench(pvDouble, true, 1024));
+    runner.run("PVStructure copy double[1024]", array, &PVStructureBench::copy);
+    runner.run("PVStructure serialize double[1024]", array, &PVStructureBench::serialize);
+    runner.run("PVStructure ser+deser double[1024]", array, &PVStructureBench::roundTrip);
+    runner.run("PVStructure ser+deser held double[1024]", array, &PVStructureBench::roundTripShared);
+
+    PVStructureBenchPtr big(new PVStructureBench(pvDouble, true, 1024*1024));
+    runner.run("PVStructure copy double[1M]", big, &PVStructureBench::copy);
+    runner.run("PVStructure compare copied double[1M]", big, &PVStructureBench::compare);
+
+    PVStructureBenchPtr string(new PVStructureBench(pvString, false, 0));
+    runner.run("PVStructure create string scalar", string, &PVStructureBench::create);
+    runner.run("PVStructure copy string scalar", string, &PVStructureBench::copy);
+    runner.run("PVStructure ser+deser string scalar", string, &PVStructureBench::roundTrip);
+
+    PVStructureBenchPtr strings(new PVStructureBench(pvString, true, 64));
+    runner.run("PVStructure ser+deser string[64]", strings, &PVStructureBench::roundTrip);
+
+    TrackChangesBenchPtr track(new TrackChangesBench);
+    runner.run("PVStructure x1000 put, PostHandler", track, &TrackChangesBench::postHandler);
+    runner.run("PVStructure x1000 put, setTrackChanges", track, &TrackChangesBench::trackChanges);
+
+    PostHandlerBenchPtr post(new PostHandlerBench);
+    runner.run("PVField x100 put, no PostHandler", post, &PostHandlerBench::putNone);
+    runner.run("PVField x100 put, 1 PostHandler", post, &PostHandlerBench::putOne);
+    runner.run("PVField x100 put, 3 PostHandlers", post, &PostHandlerBench::putThree);
+    runner.run("PVField x100 group put, 3 PostHandlers", post, &PostHandlerBench::groupPutThree);
+
+    GroupPutBenchPtr group(new GroupPutBench);
+    runner.run("PVStructure 30 puts, PostHandler each", group, &GroupPutBench::postEach);
+    runner.run("PVStructure 30 puts, GroupPutHandler", group, &GroupPutBench::groupPut);
+
+    UnionFlipBenchPtr flip(new UnionFlipBench);
+    runner.run("PVUnion x2 select, alternating", flip, &UnionFlipBench::select);
+    runner.run("PVUnion x2 deserialize, alternating", flip, &UnionFlipBench::deserialize);
+    runner.run("PVUnion x2 deserialize variant, alternating", flip, &UnionFlipBench::deserializeVariant);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <sstream>
+
+#include <pv/pvData.h>
+#include <pv/pvPrinter.h>
+#include <pv/standardPVField.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+struct PrinterBench {
+    PVStructurePtr scalar, table;
+    PVDoubleArrayPtr waveform;
+    std::string line;
+    PVPrinter text, json, limited;
+    PrinterBench()
+        :scalar(getStandardPVField()->scalar(pvDouble, "alarm,timeStamp,display,control,valueAlarm"))
+        ,table(getPVDataCreate()->createPVStructure(getFieldCreate()->createFieldBuilder()
+               ->setId("epics:nt/NTTable:1.0")
+               ->addArray("labels", pvString)
+               ->addNestedStructure("value")
+                   ->addArray("name", pvString)
+                   ->addArray("position", pvDouble)
+                   ->addArray("status", pvInt)
+               ->endNested()
+               ->createStructure()))
+        ,waveform(getPVDataCreate()->createPVScalarArray<PVDoubleArray>())
+    {
+        scalar->getSubFieldT<PVDouble>("value")->put(1.2345678);
+        PVStringArray::svector labels(3), names(100);
+        labels[0] = "name";
+        labels[1] = "position";
+        labels[2] = "status";
+        PVDoubleArray::svector pos(100);
+        PVIntArray::svector status(100);
+        for(size_t i=0; i<names.size(); i++) {
+            names[i] = "motor";
+            names[i] += char('0' + i%10);
+            pos[i] = i*0.37 - 10.0;
+            status[i] = int32(i%3);
+        }
+        table->getSubFieldT<PVStringArray>("labels")->replace(freeze(labels));
+        table->getSubFieldT<PVStringArray>("value.name")->replace(freeze(names));
+        table->getSubFieldT<PVDoubleArray>("value.position")->replace(freeze(pos));
+        table->getSubFieldT<PVIntArray>("value.status")->replace(freeze(status));
+
+        PVDoubleArray::svector wf(10000);
+        for(size_t i=0; i<wf.size(); i++)
+            wf[i] = i*1.001;
+        waveform->replace(freeze(wf));
+
+        json.format(PVPrinter::json);
+        limited.maxArrayElements(10);
+    }
+    void stream(const PVField& field)
+    {
+        std::ostringstream strm;
+        strm << field;
+        line = strm.str();
+    }
+    void print(const PVPrinter& P, const PVField& field)
+    {
+        line.clear();
+        P.print(line, field);
+    }
+    void scalarStream() { stream(*scalar); }
+    void scalarPrint() { print(text, *scalar); }
+    void tableStream() { stream(*table); }
+    void tablePrint() { print(text, *table); }
+    void tableJSON() { print(json, *table); }
+    void waveformStream() { stream(*waveform); }
+    void waveformPrint() { print(text, *waveform); }
+    void waveformLimited() { print(limited, *waveform); }
+};
+typedef std::tr1::shared_ptr<PrinterBench> PrinterBenchPtr;
+}
+
+void benchPrinter(BenchRunner& runner)
+{
+    PrinterBenchPtr B(new PrinterBench);
+    runner.run("print NTScalar ostream", B, &PrinterBench::scalarStream);
+    runner.run("print NTScalar PVPrinter", B, &PrinterBench::scalarPrint);
+    runner.run("print NTTable 100 rows ostream", B, &PrinterBench::tableStream);
+    runner.run("print NTTable 100 rows PVPrinter", B, &PrinterBench::tablePrint);
+    runner.run("print NTTable 100 rows PVPrinter json", B, &PrinterBench::tableJSON);
+    runner.run("print double[10000] ostream", B, &PrinterBench::waveformStream);
+    runner.run("print double[10000] PVPrinter", B, &PrinterBench::waveformPrint);
+    runner.run("print double[10000] PVPrinter max 10", B, &PrinterBench::waveformLimited);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <vector>
+
+#include <pv/pvData.h>
+#include <pv/standardPVField.h>
+#include <pv/bitSet.h>
+#include <pv/pvSerializedUpdate.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+// One update of a 1000 element waveform with alarm and timeStamp, sent to 100 subscribers
+struct FanOutBench : public SerializableControl {
+    enum {nsubscribers = 100};
+    PVStructurePtr value;
+    BitSet changed, overrun;
+    std::vector<char> scratch;
+    ByteBuffer buffer;
+    size_t sent;
+
+    FanOutBench()
+        :value(getStandardPVField()->scalarArray(pvDouble, "alarm,timeStamp"))
+        ,scratch(64*1024)
+        ,buffer(&scratch[0], scratch.size())
+        ,sent(0)
+    {
+        PVDoubleArray::svector arr(1000, 1.0);
+        value->getSubFieldT<PVDoubleArray>("value")->replace(freeze(arr));
+        changed.set(value->getSubFieldT("value")->getFieldOffset());
+        changed.set(value->getSubFieldT("alarm")->getFieldOffset());
+        changed.set(value->getSubFieldT("timeStamp")->getFieldOffset());
+    }
+    virtual ~FanOutBench() {}
+
+    // each subscriber's transport sends, then re-uses, the buffer
+    virtual void flushSerializeBuffer() { sent += buffer.getPosition(); buffer.clear(); }
+    virtual void ensureBuffer(std::size_t size) { flushSerializeBuffer(); }
+    virtual void alignBuffer(std::size_t alignment) { buffer.align(alignment); }
+    virtual bool directSerialize(ByteBuffer*, const char*, std::size_t, std::size_t) { return false; }
+    virtual void cachedSerialize(std::tr1::shared_ptr<const Field> const & field, ByteBuffer* buffer)
+    { field->serialize(buffer, this); }
+
+    void perSubscriber()
+    {
+        for(unsigned i=0; i<nsubscribers; i++) {
+            changed.serialize(&buffer, this);
+            value->serialize(&buffer, this, &changed);
+            overrun.serialize(&buffer, this);
+            flushSerializeBuffer();
+        }
+    }
+    void once()
+    {
+        SerializedUpdate update(*value, changed, overrun);
+        for(unsigned i=0; i<nsubscribers; i++) {
+            update.serialize(&buffer, this, false);
+            flushSerializeBuffer();
+        }
+    }
+};
+typedef std::tr1::shared_ptr<FanOutBench> FanOutBenchPtr;
+}
+
+void benchSerializedUpdate(BenchRunner& runner)
+{
+    FanOutBenchPtr B(new FanOutBench);
+    runner.run("fan-out x100 serialize each", B, &FanOutBench::perSubscriber);
+    runner.run("fan-out x100 SerializedUpdate", B, &FanOutBench::once);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <algorithm>
+
+#include <pv/sharedVector.h>
+#include <pv/arrayAllocator.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+struct SharedVectorBench {
+    enum {count = 1024};
+    shared_vector<const double> frozen;
+    double sum;
+    SharedVectorBench()
+        :sum(0.0)
+    {
+        shared_vector<double> temp(count, 1.0);
+        frozen = freeze(temp);
+    }
+    void allocate()
+    {
+        shared_vector<double> temp(count);
+        temp[0] = 1.0;
+    }
+    void allocateFill()
+    {
+        shared_vector<double> temp(count, 2.0);
+    }
+    void share()
+    {
+        shared_vector<const double> temp(frozen);
+        sum += temp[0];
+    }
+    void slice()
+    {
+        shared_vector<const double> temp(frozen);
+        temp.slice(count/4, count/2);
+        sum += temp[0];
+    }
+    void thawCopy()
+    {
+        shared_vector<const double> temp(frozen);
+        shared_vector<double> copy(thaw(temp));
+        sum += copy[0];
+    }
+    void resize()
+    {
+        shared_vector<double> temp;
+        for(size_t i=1; i<=count; i*=2)
+            temp.resize(i);
+    }
+    void allocateMedium()
+    {
+        shared_vector<double> temp(64*1024);
+        temp[0] = 1.0;
+    }
+    void allocateFillLarge()
+    {
+        shared_vector<double> temp(1024*1024, 2.0);
+    }
+    void iterate()
+    {
+        for(shared_vector<const double>::const_iterator it=frozen.begin(), end=frozen.end(); it!=end; ++it)
+            sum += *it;
+    }
+};
+typedef std::tr1::shared_ptr<SharedVectorBench> SharedVectorBenchPtr;
+}
+
+void benchSharedVector(BenchRunner& runner)
+{
+    SharedVectorBenchPtr B(new SharedVectorBench);
+    runner.run("shared_vector alloc double[1024]", B, &SharedVectorBench::allocate);
+    runner.run("shared_vector alloc+fill double[1024]", B, &SharedVectorBench::allocateFill);
+    runner.run("shared_vector share", B, &SharedVectorBench::share);
+    runner.run("shared_vector slice", B, &SharedVectorBench::slice);
+    runner.run("shared_vector thaw copy double[1024]", B, &SharedVectorBench::thawCopy);
+    runner.run("shared_vector resize 1..1024", B, &SharedVectorBench::resize);
+    runner.run("shared_vector iterate double[1024]", B, &SharedVectorBench::iterate);
+    runner.run("shared_vector alloc double[64k]", B, &SharedVectorBench::allocateMedium);
+    runner.run("shared_vector alloc+fill double[1M]", B, &SharedVectorBench::allocateFillLarge);
+
+    ArrayAllocator::set(pvDouble, ArrayAllocator::shared_pointer(new AlignedAllocator(64, 0, 1024*1024)));
+    runner.run("shared_vector pooled alloc dbl[1024]", B, &SharedVectorBench::allocate);
+    runner.run("shared_vector pooled alloc dbl[64k]", B, &SharedVectorBench::allocateMedium);
+    ArrayAllocator::set(pvDouble, ArrayAllocator::shared_pointer(new AlignedAllocator(64, 1024*1024)));
+    runner.run("shared_vector huge alloc+fill dbl[1M]", B, &SharedVectorBench::allocateFillLarge);
+    ArrayAllocator::set(pvDouble, ArrayAllocator::shared_pointer());
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <pv/pvData.h>
+#include <pv/pvSubArrayCopy.h>
+#include <pv/arrayKernels.h>
+
+#include "benchHarness.h"
+
+using namespace epics::pvData;
+
+namespace {
+// Region of interest extraction from a 2048x2048 uint16 image (8MB)
+struct SubArrayCopyBench {
+    enum {width = 2048, height = 2048};
+    PVUShortArrayPtr image, roi;
+    SubArrayCopyBench()
+        :image(getPVDataCreate()->createPVScalarArray<PVUShortArray>())
+        ,roi(getPVDataCreate()->createPVScalarArray<PVUShortArray>())
+    {
+        PVUShortArray::svector pixels(width*height);
+        for(size_t i=0; i<pixels.size(); i++)
+            pixels[i] = uint16(i);
+        image->replace(freeze(pixels));
+    }
+    // n x n pixels, one copy per row
+    void rows(size_t n)
+    {
+        for(size_t r=0; r<n; r++)
+            copy(*image, (r+100)*width + 100, 1, *roi, r*n, 1, n);
+    }
+    void rows64() { rows(64); }
+    void rows512() { rows(512); }
+    // every second pixel of every second row
+    void binned()
+    {
+        for(size_t r=0; r<height/2; r++)
+            copy(*image, 2*r*width, 2, *roi, r*width/2, 1, width/2);
+    }
+    // one column
+    void column()
+    {
+        copy(*image, 1000, width, *roi, 0, 1, height);
+    }
+    // every fourth pixel of the whole frame
+    void decimate()
+    {
+        copy(*image, 0, 4, *roi, 0, 1, width*height/4);
+    }
+    void frame()
+    {
+        copy(*image, 0, 1, *roi, 0, 1, width*height);
+    }
+};
+typedef std::tr1::shared_ptr<SubArrayCopyBench> SubArrayCopyBenchPtr;
+}
+
+void benchSubArrayCopy(BenchRunner& runner)
+{
+    SubArrayCopyBenchPtr B(new SubArrayCopyBench);
+    runner.run("subArrayCopy ROI 64x64 rows", B, &SubArrayCopyBench::rows64);
+    runner.run("subArrayCopy ROI 512x512 rows", B, &SubArrayCopyBench::rows512);
+    runner.run("subArrayCopy 2x2 binned 1024x1024", B, &SubArrayCopyBench::binned);
+    runner.run("subArrayCopy column 2048", B, &SubArrayCopyBench::column);
+    runner.run("subArrayCopy decimate 4 frame", B, &SubArrayCopyBench::decimate);
+    runner.run("subArrayCopy frame 2048x2048", B, &SubArrayCopyBench::frame);
+
+    ArrayKernels::setParallel(4, 64*1024);
+    runner.run("subArrayCopy decimate 4 frame x4", B, &SubArrayCopyBench::decimate);
+    runner.run("subArrayCopy frame 2048x2048 x4", B, &SubArrayCopyBench::frame);
+    ArrayKernels::setParallel(1);
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/*
+ * Micro-benchmarks of pvData.  See benchHarness.h for arguments.
+ *
+ * Record a baseline with
+ *   pvDataBench -o baseline.txt
+ * and check a later build against it with
+ *   pvDataBench -b baseline.txt
+ */
+#include "benchHarness.h"
+
+void benchByteBuffer(BenchRunner& runner);
+void benchBitSet(BenchRunner& runner);
+void benchPVStructure(BenchRunner& runner);
+void benchSharedVector(BenchRunner& runner);
+void benchConvert(BenchRunner& runner);
+void benchCastV(BenchRunner& runner);
+void benchMappedVector(BenchRunner& runner);
+void benchArrayKernels(BenchRunner& runner);
+void benchSubArrayCopy(BenchRunner& runner);
+void benchPrinter(BenchRunner& runner);
+void benchCreateRequest(BenchRunner& runner);
+void benchPVCopy(BenchRunner& runner);
+void benchSerializedUpdate(BenchRunner& runner);
+void benchMonitorFilter(BenchRunner& runner);
+
+int main(int argc, char *argv[])
+{
+    BenchRunner runner(argc, argv);
+    benchByteBuffer(runner);
+    benchBitSet(runner);
+    benchPVStructure(runner);
+    benchSharedVector(runner);
+    benchConvert(runner);
+    benchCastV(runner);
+    benchMappedVector(runner);
+    benchArrayKernels(runner);
+    benchSubArrayCopy(runner);
+    benchPrinter(runner);
+    benchCreateRequest(runner);
+    benchPVCopy(runner);
+    benchSerializedUpdate(runner);
+    benchMonitorFilter(runner);
+    return runner.finish();
+}
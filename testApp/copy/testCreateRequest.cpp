@@ -324,10 +324,55 @@ static void testCreateRequestInternal() {
     testPass("request %s",request.c_str());
 }
 
+static void testCache()
+{
+    printf("testCache... \n");
+    CreateRequest::shared_pointer  createRequest = CreateRequest::create();
+    string request = "record[process=true]field(value,alarm,timeStamp[shareData=true])";
+
+    CreateRequest::setCacheSize(2);
+    PVStructurePtr first = createRequest->createRequest(request);
+    PVStructurePtr second = CreateRequest::create()->createRequest(request);
+    testOk1(first && second && first!=second);
+    testOk1(first->getStructure()==second->getStructure());
+    testOk1(CreateRequest::cacheSize()>=1 && CreateRequest::cacheSize()<=2);
+
+    // each caller gets a copy
+    first->getSubFieldT<PVString>("record._options.process")->put("false");
+    PVStructurePtr third = createRequest->createRequest(request);
+    testOk1(third->getSubFieldT<PVString>("record._options.process")->get()=="true");
+    testOk1(*third==*second);
+
+    // blanks are ignored
+    PVStructurePtr spaced = createRequest->createRequest(
+                " record [ process = true ] field ( value , alarm , timeStamp [ shareData = true ] ) ");
+    testOk1(spaced && *spaced==*second);
+
+    createRequest->createRequest("value");
+    createRequest->createRequest("alarm");
+    testOk1(CreateRequest::cacheSize()==2);
+
+    // errors are not remembered
+    testOk1(!createRequest->createRequest("field(value)junk"));
+    testOk1(!createRequest->getMessage().empty());
+    testOk1(!createRequest->createRequest("field(value)field(alarm)"));
+    testOk1(!createRequest->createRequest("value{}"));
+    testOk1(!createRequest->createRequest("value[]"));
+    testOk1(CreateRequest::cacheSize()==2);
+
+    CreateRequest::setCacheSize(0);
+    testOk1(CreateRequest::cacheSize()==0);
+    PVStructurePtr uncached = createRequest->createRequest(request);
+    testOk1(uncached && *uncached==*second);
+    testOk1(CreateRequest::cacheSize()==0);
+    CreateRequest::setCacheSize(128);
+}
+
 MAIN(testCreateRequest)
 {
-    testPlan(121);
+    testPlan(137);
     testCreateRequestInternal();
+    testCache();
     return testDone();
 }
 
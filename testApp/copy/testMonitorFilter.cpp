@@ -0,0 +1,418 @@
+/* testMonitorFilter.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <string>
+#include <stdexcept>
+#include <limits>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/pvData.h>
+#include <pv/standardPVField.h>
+#include <pv/pvCopy.h>
+#include <pv/createRequest.h>
+#include <pv/monitorFilter.h>
+
+using namespace epics::pvData;
+using std::string;
+
+namespace {
+
+// a subscriber's copy of an NTScalar double, or of another master
+struct Subscriber {
+    PVStructurePtr master;
+    PVCopyPtr pvCopy;
+    PVStructurePtr copy;
+    BitSet changed;
+
+    explicit Subscriber(const string& request,
+                        const PVStructurePtr& master = getStandardPVField()->scalar(pvDouble, "alarm,timeStamp"))
+        :master(master)
+    {
+        PVStructurePtr pvRequest(CreateRequest::create()->createRequest(request));
+        if(!pvRequest)
+            throw std::logic_error("bad request");
+        pvCopy = PVCopy::create(master, pvRequest, "");
+        copy = pvCopy->createPVStructure();
+    }
+
+    uint32 offset(const char *name)
+    {
+        return static_cast<uint32>(copy->getSubFieldT(name)->getFieldOffset());
+    }
+
+    // mark name as changed
+    Subscriber& mark(const char *name)
+    {
+        changed.set(offset(name));
+        return *this;
+    }
+
+    template<typename T>
+    Subscriber& put(const char *name, T value)
+    {
+        copy->getSubFieldT<PVScalar>(name)->putFrom(value);
+        return mark(name);
+    }
+
+    Subscriber& put(const char *name, const char *value)
+    {
+        return put(name, string(value));
+    }
+
+    bool update(MonitorFilter& filter)
+    {
+        return filter.filter(*copy, changed);
+    }
+};
+
+void testDeadband()
+{
+    testDiag("testDeadband");
+    Subscriber S("field(value[deadband=0.5],alarm,timeStamp[trigger=false])");
+    MonitorFilter F(*S.pvCopy);
+    testOk1(!F.empty());
+
+    S.changed.set(0);
+    testOk(S.update(F), "initial update sent");
+    testOk1(S.changed.get(0));
+
+    S.changed.clear();
+    S.put("value", 0.3).put("timeStamp.nanoseconds", 1);
+    testOk(!S.update(F), "within deadband");
+    testOk1(!S.changed.get(S.offset("value")));
+
+    S.changed.clear();
+    S.put("value", 0.6).put("timeStamp.nanoseconds", 2);
+    testOk(S.update(F), "outside deadband");
+    testOk1(S.changed.get(S.offset("value")));
+    testOk(S.changed.get(S.offset("timeStamp.nanoseconds")), "timeStamp sent along");
+
+    // compared with the last value sent, 0.6
+    S.changed.clear();
+    S.put("value", 0.9);
+    testOk(!S.update(F), "0.9 within deadband");
+    S.changed.clear();
+    S.put("value", 1.2);
+    testOk(S.update(F), "1.2 outside deadband");
+    S.changed.clear();
+    S.put("value", 0.8);
+    testOk(!S.update(F), "0.8 within deadband");
+
+    S.changed.clear();
+    S.put("value", 1.0).put("alarm.severity", 1);
+    testOk(S.update(F), "alarm always sent");
+    testOk(!S.changed.get(S.offset("value")), "value still filtered");
+
+    S.changed.clear();
+    S.put("value", std::numeric_limits<double>::quiet_NaN());
+    testOk(S.update(F), "NaN sent");
+    S.changed.clear();
+    S.put("value", std::numeric_limits<double>::quiet_NaN());
+    testOk(!S.update(F), "NaN not repeated");
+}
+
+void testOnChange()
+{
+    testDiag("testOnChange");
+    Subscriber S("field(value[onChange=true],alarm.message[onChange=true])");
+    MonitorFilter F(*S.pvCopy);
+
+    S.put("value", 1.0).put("alarm.message", "HIGH");
+    testOk(S.update(F), "first update sent");
+
+    S.changed.clear();
+    S.put("value", 1.0).put("alarm.message", "HIGH");
+    testOk(!S.update(F), "same values not sent");
+    testOk1(S.changed.isEmpty());
+
+    S.changed.clear();
+    S.put("value", 1.0).put("alarm.message", "LOW");
+    testOk(S.update(F), "string changed");
+    testOk1(!S.changed.get(S.offset("value")));
+    testOk1(S.changed.get(S.offset("alarm.message")));
+
+    S.changed.clear();
+    S.put("alarm.message", "LOW");
+    testOk(!S.update(F), "string compared with last sent");
+}
+
+void testStructureOptions()
+{
+    testDiag("testStructureOptions");
+    Subscriber S("field(value,timeStamp[trigger=false])");
+    MonitorFilter F(*S.pvCopy);
+
+    S.put("timeStamp.secondsPastEpoch", 1).put("timeStamp.nanoseconds", 2);
+    testOk(!S.update(F), "timeStamp alone is not sent");
+    testOk1(S.changed.get(S.offset("timeStamp.nanoseconds")));
+
+    S.changed.clear();
+    S.mark("timeStamp");
+    testOk(!S.update(F), "whole timeStamp alone is not sent");
+
+    S.mark("value");
+    testOk(S.update(F), "sent with value");
+    testOk1(S.changed.get(S.offset("timeStamp")));
+
+    S.changed.clear();
+    S.changed.set(0);
+    testOk(S.update(F), "whole structure sent");
+
+    // options of fields override those of the enclosing structure
+    Subscriber O("field(value,alarm[onChange=true]{severity[onChange=false],message})");
+    MonitorFilter G(*O.pvCopy);
+    O.put("alarm.severity", 1).put("alarm.message", "x");
+    testOk1(O.update(G));
+    O.changed.clear();
+    O.put("alarm.severity", 1).put("alarm.message", "x");
+    testOk(O.update(G), "severity not filtered");
+    testOk1(O.changed.get(O.offset("alarm.severity")));
+    testOk1(!O.changed.get(O.offset("alarm.message")));
+}
+
+void testRelativeDeadband()
+{
+    testDiag("testRelativeDeadband");
+    const char *requests[] = {"field(value[deadband=10%])", "field(value[deadband=rel:10])"};
+    for(size_t i=0; i<2; i++) {
+        Subscriber S(requests[i]);
+        MonitorFilter F(*S.pvCopy);
+
+        S.put("value", 100.0);
+        testOk1(S.update(F));
+        S.changed.clear();
+        S.put("value", 109.0);
+        testOk(!S.update(F), "%s 9%% within", requests[i]);
+        S.changed.clear();
+        S.put("value", 111.0);
+        testOk(S.update(F), "%s 11%% outside", requests[i]);
+        S.changed.clear();
+        S.put("value", 101.0);
+        testOk(!S.update(F), "%s relative to last sent", requests[i]);
+    }
+}
+
+void testDecimate()
+{
+    testDiag("testDecimate");
+    Subscriber S("field(value[decimate=3],timeStamp)",
+                 getStandardPVField()->scalarArray(pvInt, "timeStamp"));
+    MonitorFilter F(*S.pvCopy);
+    PVIntArrayPtr value(S.copy->getSubFieldT<PVIntArray>("value"));
+
+    PVIntArray::svector arr(10);
+    for(size_t i=0; i<arr.size(); i++)
+        arr[i] = int32(i);
+    value->replace(freeze(arr));
+    S.mark("value");
+    testOk1(S.update(F));
+    PVIntArray::const_svector result(value->view());
+    testOk(result.size()==4 && result[0]==0 && result[1]==3 && result[3]==9,
+           "every third element, size %u", unsigned(result.size()));
+
+    // not changed, not decimated
+    S.changed.clear();
+    S.mark("timeStamp.nanoseconds");
+    testOk1(S.update(F));
+    testOk1(value->view().size()==4);
+
+    PVIntArray::svector empty;
+    value->replace(freeze(empty));
+    S.changed.clear();
+    S.mark("value");
+    testOk1(S.update(F));
+    testOk1(value->view().size()==0);
+}
+
+// as a server would, with PVCopy::updateCopySetBitSet() before each filter()
+void testDecimateUpdateCopy()
+{
+    testDiag("testDecimateUpdateCopy");
+    Subscriber S("field(value[decimate=2],timeStamp)",
+                 getStandardPVField()->scalarArray(pvInt, "timeStamp"));
+    MonitorFilter F(*S.pvCopy);
+    PVIntArrayPtr value(S.master->getSubFieldT<PVIntArray>("value"));
+    PVIntPtr nanoseconds(S.master->getSubFieldT<PVInt>("timeStamp.nanoseconds"));
+    BitSetPtr changed(new BitSet);
+
+    PVIntArray::svector arr(6);
+    for(size_t i=0; i<arr.size(); i++)
+        arr[i] = int32(i);
+    value->replace(freeze(arr));
+    S.pvCopy->updateCopySetBitSet(S.copy, changed);
+    testOk1(F.filter(*S.copy, *changed));
+    testOk1(S.copy->getSubFieldT<PVIntArray>("value")->view().size()==3);
+
+    nanoseconds->put(1);
+    changed->clear();
+    S.pvCopy->updateCopySetBitSet(S.copy, changed);
+    testOk1(F.filter(*S.copy, *changed));
+    testOk(!changed->get(S.offset("value")), "decimated array not sent again");
+
+    changed->clear();
+    S.pvCopy->updateCopySetBitSet(S.copy, changed);
+    testOk(!F.filter(*S.copy, *changed), "no change");
+
+    PVIntArray::svector other(4, 7);
+    value->replace(freeze(other));
+    changed->clear();
+    S.pvCopy->updateCopySetBitSet(S.copy, changed);
+    testOk1(F.filter(*S.copy, *changed));
+    testOk(changed->get(S.offset("value"))
+           && S.copy->getSubFieldT<PVIntArray>("value")->view().size()==2, "new array sent");
+}
+
+// a copy which always holds the current values, and an update at time 'when'
+bool throttled(Subscriber& S, MonitorFilter& F, double value, int64 when)
+{
+    S.changed.clear();
+    S.put("value", value).put("timeStamp.secondsPastEpoch", when);
+    return S.update(F);
+}
+
+void testThrottle()
+{
+    testDiag("testThrottle");
+    Subscriber S("field(value,alarm,timeStamp[throttle=2.5])");
+    MonitorFilter F(*S.pvCopy);
+    testOk1(!F.empty());
+
+    testOk(throttled(S, F, 1.0, 100), "first update sent");
+    testOk(!throttled(S, F, 2.0, 101), "held back at +1s");
+    // held back changes are merged
+    S.changed.clear();
+    S.put("alarm.severity", 1).put("timeStamp.secondsPastEpoch", 102);
+    testOk(!S.update(F), "held back at +2s");
+    testOk(throttled(S, F, 3.0, 103), "sent at +3s");
+    testOk1(S.changed.get(S.offset("alarm.severity")));
+    testOk1(S.changed.get(S.offset("value")));
+
+    testOk(!throttled(S, F, 4.0, 104), "interval starts at the last update sent");
+    testOk(throttled(S, F, 5.0, 99), "timeStamp going backwards");
+
+    F.reset();
+    testOk(throttled(S, F, 6.0, 100), "sent after reset()");
+
+    // with a deadband, only updates passing the deadband are held back
+    Subscriber D("field(value[deadband=1],timeStamp[throttle=10,trigger=false])");
+    MonitorFilter G(*D.pvCopy);
+    testOk1(throttled(D, G, 0.0, 100));
+    testOk1(!throttled(D, G, 0.5, 101));
+    testOk(!throttled(D, G, 5.0, 102), "held back");
+    testOk(!throttled(D, G, 5.5, 105), "still held back");
+    testOk(throttled(D, G, 0.4, 112), "sent after the interval, without trigger");
+    testOk1(D.changed.get(D.offset("value")));
+
+    // the last update of a burst is sent by flush()
+    Subscriber B("field(value,timeStamp[throttle=2])");
+    MonitorFilter H(*B.pvCopy);
+    testOk1(!H.hasHeld());
+    testOk1(throttled(B, H, 1.0, 100));
+    testOk1(!throttled(B, H, 2.0, 101));
+    testOk1(H.hasHeld());
+    B.changed.clear();
+    testOk(H.flush(*B.copy, B.changed), "held update flushed");
+    testOk1(B.changed.get(B.offset("value")) && B.copy->getSubFieldT<PVDouble>("value")->get()==2.0);
+    testOk1(!H.hasHeld());
+    testOk(!H.flush(*B.copy, B.changed), "nothing more to flush");
+    testOk(!throttled(B, H, 3.0, 102), "interval starts at the update flushed");
+}
+
+void testCopies()
+{
+    testDiag("testCopies");
+    Subscriber S("field(value[deadband=10])");
+    MonitorFilter F(*S.pvCopy);
+
+    S.put("value", 1.0);
+    testOk1(S.update(F));
+    S.changed.clear();
+    S.put("value", 2.0);
+    testOk1(!S.update(F));
+
+    // another subscriber has no last value yet
+    MonitorFilter G(F);
+    S.changed.clear();
+    S.put("value", 2.0);
+    testOk(S.update(G), "copy sends first update");
+    S.changed.clear();
+    S.put("value", 2.0);
+    testOk(!S.update(F), "original keeps its last value");
+
+    F.reset();
+    S.changed.clear();
+    S.put("value", 2.0);
+    testOk(S.update(F), "sent after reset()");
+}
+
+void testNoOptions()
+{
+    testDiag("testNoOptions");
+    Subscriber S("field(value,alarm[queueSize=4])");
+    MonitorFilter F(*S.pvCopy);
+    testOk1(F.empty());
+    testOk1(!S.update(F));
+    S.put("value", 1.0);
+    testOk1(S.update(F));
+}
+
+void testErrors()
+{
+    testDiag("testErrors");
+    const char *requests[] = {
+        "field(value[deadband=abc])",
+        "field(value[deadband=-1])",
+        "field(alarm.message[deadband=1])",
+        "field(value[onChange=maybe])",
+        "field(value[deadband=x%])",
+        "field(value[decimate=2])",
+        "field(value[throttle=1])",
+        "field(alarm[throttle=1])",
+        "field(timeStamp[throttle=1],alarm[throttle=1])",
+    };
+    for(size_t i=0; i<sizeof(requests)/sizeof(requests[0]); i++) {
+        Subscriber S(requests[i]);
+        try {
+            MonitorFilter F(*S.pvCopy);
+            testFail("no error for %s", requests[i]);
+        } catch(std::invalid_argument& e) {
+            testPass("%s : %s", requests[i], e.what());
+        }
+    }
+
+    // a deadband given to a structure applies to its numeric fields
+    Subscriber S("field(alarm[deadband=1])");
+    MonitorFilter F(*S.pvCopy);
+    testOk1(!F.empty());
+
+    Subscriber other("field(value[deadband=1],alarm)");
+    try {
+        F.filter(*other.copy, other.changed);
+        testFail("structure mismatch not detected");
+    } catch(std::invalid_argument& e) {
+        testPass("structure mismatch : %s", e.what());
+    }
+}
+
+} // namespace
+
+MAIN(testMonitorFilter)
+{
+    testPlan(97);
+    testDeadband();
+    testOnChange();
+    testStructureOptions();
+    testRelativeDeadband();
+    testDecimate();
+    testDecimateUpdateCopy();
+    testThrottle();
+    testCopies();
+    testNoOptions();
+    testErrors();
+    return testDone();
+}
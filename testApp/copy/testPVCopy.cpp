@@ -345,12 +345,157 @@ static void powerSupplyTest()
     testPVScalar(valueNameMaster,valueNameCopy,pvMaster,pvCopy);
 }
 
+// full names in the copy and master match
+static bool checkOffsets(PVStructurePtr const & pvMaster, PVCopyPtr const & pvCopy)
+{
+    PVStructurePtr pvStructureCopy = pvCopy->createPVStructure();
+    bool ok = pvCopy->getMasterPVField(0)==pvMaster;
+    for(size_t i=1; i<pvStructureCopy->getNumberFields(); i++) {
+        string name = pvStructureCopy->getSubField(i)->getFullName();
+        PVFieldPtr pvMasterField = pvCopy->getMasterPVField(i);
+        if(pvMasterField->getFullName()!=name) {
+            testDiag("copy %s master %s", name.c_str(), pvMasterField->getFullName().c_str());
+            ok = false;
+        }
+    }
+    testOk(ok, "getMasterPVField()");
+
+    ok = pvCopy->getCopyOffset(pvMaster)==0;
+    for(size_t i=1; i<pvMaster->getNumberFields(); i++) {
+        PVFieldPtr pvMasterField = pvMaster->getSubField(i);
+        PVFieldPtr pvCopyField = pvStructureCopy->getSubField(pvMasterField->getFullName());
+        size_t expect = pvCopyField ? pvCopyField->getFieldOffset() : string::npos;
+        if(pvCopy->getCopyOffset(pvMasterField)!=expect) {
+            testDiag("master %s copy %u", pvMasterField->getFullName().c_str(),
+                     unsigned(pvCopy->getCopyOffset(pvMasterField)));
+            ok = false;
+        }
+    }
+    testOk(ok, "getCopyOffset()");
+    return ok;
+}
+
+static void offsetTest()
+{
+    if(debug) { cout << endl << endl << "****offsetTest****" << endl; }
+    CreateRequest::shared_pointer createRequest = CreateRequest::create();
+    PVStructurePtr pvMaster = createPowerSupply();
+    PVStructurePtr pvOther = createPowerSupply();
+    const char *requests[] = {
+        "",
+        "power.value",
+        "alarm,timeStamp,voltage.value,power.value,current.value",
+        "alarm,timeStamp,voltage{value,alarm},power{value,alarm,display},current.value",
+        "current{display{limitLow}},alarm.severity,voltage",
+    };
+    for(size_t i=0; i<sizeof(requests)/sizeof(requests[0]); i++) {
+        testDiag("request \"%s\"", requests[i]);
+        PVCopyPtr pvCopy = PVCopy::create(pvMaster,createRequest->createRequest(requests[i]),"");
+        checkOffsets(pvMaster, pvCopy);
+    }
+    PVCopyPtr pvCopy = PVCopy::create(pvMaster,createRequest->createRequest(requests[1]),"");
+    testOk1(pvCopy->getCopyOffset(pvOther->getSubField("power.value"))==string::npos);
+
+    PVStructurePtr pvRequest = createRequest->createRequest(
+        "alarm,timeStamp[shareData=true],power{value,alarm[x=y]}");
+    pvCopy = PVCopy::create(pvMaster,pvRequest,"");
+    PVStructurePtr pvStructureCopy = pvCopy->createPVStructure();
+    testOk1(!pvCopy->getOptions(pvStructureCopy->getSubFieldT("alarm")->getFieldOffset()));
+    PVStructurePtr options = pvCopy->getOptions(
+        pvStructureCopy->getSubFieldT("timeStamp")->getFieldOffset());
+    testOk1(options && options->getSubFieldT<PVString>("shareData")->get()=="true");
+    options = pvCopy->getOptions(pvStructureCopy->getSubFieldT("power.alarm")->getFieldOffset());
+    testOk1(options && options->getSubFieldT<PVString>("x")->get()=="y");
+    testOk1(!pvCopy->getOptions(pvStructureCopy->getSubFieldT("power.alarm.severity")->getFieldOffset()));
+    try {
+        pvCopy->getOptions(pvStructureCopy->getNumberFields());
+        testFail("getOptions() accepted invalid offset");
+    } catch(std::invalid_argument& e) {
+        testPass("getOptions() invalid offset : %s", e.what());
+    }
+
+    // only the selected fields are copied
+    BitSetPtr bitSet(new BitSet(pvStructureCopy->getNumberFields()));
+    pvCopy->initCopy(pvStructureCopy, bitSet);
+    pvMaster->getSubFieldT<PVInt>("power.alarm.severity")->put(2);
+    pvMaster->getSubFieldT<PVInt>("power.alarm.status")->put(3);
+    pvMaster->getSubFieldT<PVDouble>("power.value")->put(5.0);
+    bitSet->clear();
+    bitSet->set(pvStructureCopy->getSubFieldT("power.alarm.severity")->getFieldOffset());
+    bitSet->set(pvStructureCopy->getSubFieldT("power.value")->getFieldOffset());
+    pvCopy->updateCopyFromBitSet(pvStructureCopy, bitSet);
+    testOk1(pvStructureCopy->getSubFieldT<PVInt>("power.alarm.severity")->get()==2);
+    testOk1(pvStructureCopy->getSubFieldT<PVInt>("power.alarm.status")->get()==0);
+    testOk1(pvStructureCopy->getSubFieldT<PVDouble>("power.value")->get()==5.0);
+
+    // a structure includes all of its sub-fields
+    bitSet->clear();
+    bitSet->set(pvStructureCopy->getSubFieldT("power")->getFieldOffset());
+    pvCopy->updateCopyFromBitSet(pvStructureCopy, bitSet);
+    testOk1(pvStructureCopy->getSubFieldT<PVInt>("power.alarm.status")->get()==3);
+
+    pvStructureCopy->getSubFieldT<PVString>("alarm.message")->put("copy");
+    pvStructureCopy->getSubFieldT<PVDouble>("power.value")->put(6.0);
+    bitSet->clear();
+    bitSet->set(pvStructureCopy->getSubFieldT("alarm")->getFieldOffset());
+    pvCopy->updateMaster(pvStructureCopy, bitSet);
+    testOk1(pvMaster->getSubFieldT<PVString>("alarm.message")->get()=="copy");
+    testOk1(pvMaster->getSubFieldT<PVDouble>("power.value")->get()==5.0);
+
+    pvMaster->getSubFieldT<PVInt>("power.alarm.status")->put(1);
+    bitSet->clear();
+    pvCopy->updateCopySetBitSet(pvStructureCopy, bitSet);
+    testOk1(pvStructureCopy->getSubFieldT<PVInt>("power.alarm.status")->get()==1);
+    testOk1(pvStructureCopy->getSubFieldT<PVDouble>("power.value")->get()==5.0);
+    testOk1(bitSet->cardinality()==2);
+}
+
+static void sharedTest()
+{
+    if(debug) { cout << endl << endl << "****sharedTest****" << endl; }
+    CreateRequest::shared_pointer createRequest = CreateRequest::create();
+    PVStructurePtr pvMaster = createPowerSupply();
+    PVStructurePtr pvOther = createPowerSupply();
+    string request("alarm,timeStamp,power.value");
+
+    PVCopyPtr first = PVCopy::createShared(pvMaster,createRequest->createRequest(request),"");
+    PVCopyPtr second = PVCopy::createShared(pvMaster,createRequest->createRequest(request),"");
+    testOk1(first && first==second);
+    testOk1(PVCopy::create(pvMaster,createRequest->createRequest(request),"")!=first);
+
+    // equal requests from a different string
+    PVCopyPtr spaced = PVCopy::createShared(pvMaster,
+        createRequest->createRequest("field(alarm, timeStamp, power.value)"),"");
+    testOk1(spaced==first);
+
+    testOk1(PVCopy::createShared(pvOther,createRequest->createRequest(request),"")!=first);
+    testOk1(PVCopy::createShared(pvMaster,createRequest->createRequest("alarm,power.value"),"")!=first);
+    testOk1(PVCopy::createShared(pvMaster,
+        createRequest->createRequest("alarm,timeStamp[shareData=true],power.value"),"")!=first);
+    testOk1(!PVCopy::createShared(pvMaster,createRequest->createRequest("field(alarm)"),"nosuch"));
+
+    // per-subscriber copies of one Structure
+    PVStructurePtr copy1 = first->createPVStructure();
+    PVStructurePtr copy2 = second->createPVStructure();
+    testOk1(copy1!=copy2 && copy1->getStructure()==copy2->getStructure());
+
+    std::tr1::weak_ptr<PVCopy> weak(first);
+    first.reset();
+    second.reset();
+    spaced.reset();
+    testOk1(weak.expired());
+    PVCopyPtr third = PVCopy::createShared(pvMaster,createRequest->createRequest(request),"");
+    testOk1(third && *third->getStructure()==*copy1->getStructure());
+}
+
 MAIN(testPVCopy)
 {
-    testPlan(67);
+    testPlan(102);
     scalarTest();
     arrayTest();
     powerSupplyTest();
+    offsetTest();
+    sharedTest();
     return testDone();
 }
 
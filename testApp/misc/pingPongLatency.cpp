@@ -0,0 +1,114 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/*
+ * Measure the thread handoff latency of the Event and Mutex
+ * implementations.  Not a unit test, nothing is checked.
+ */
+#include <cstdio>
+#include <string>
+
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <testMain.h>
+
+#include <pv/event.h>
+#include <pv/lock.h>
+#include <pv/thread.h>
+#include <pv/futex.h>
+#include <pv/timeStamp.h>
+
+using namespace epics::pvData;
+
+namespace {
+
+// Two threads passing a token back and forth through a pair of events.
+template<typename E>
+struct PingPong {
+    E ping, pong;
+    long count;
+    explicit PingPong(long count) :count(count) {}
+    void echo()
+    {
+        for(long i=0; i<count; i++) {
+            ping.wait();
+            pong.signal();
+        }
+    }
+    double run()
+    {
+        Thread peer(Thread::Config(this, &PingPong::echo)
+                    .name("pong")
+                    .prio(epicsThreadPriorityMedium));
+        TimeStamp start, end;
+        start.getCurrent();
+        for(long i=0; i<count; i++) {
+            ping.signal();
+            pong.wait();
+        }
+        end.getCurrent();
+        return TimeStamp::diff(end, start)/count;
+    }
+};
+
+// Two threads incrementing a counter under a common mutex.
+template<typename M>
+struct Contend {
+    M mutex;
+    long count, value;
+    explicit Contend(long count) :count(count), value(0) {}
+    void inc()
+    {
+        for(long i=0; i<count; i++) {
+            mutex.lock();
+            value++;
+            mutex.unlock();
+        }
+    }
+    double run()
+    {
+        TimeStamp start, end;
+        start.getCurrent();
+        {
+            Thread A(Thread::Config(this, &Contend::inc).name("incA"));
+            Thread B(Thread::Config(this, &Contend::inc).name("incB"));
+        }
+        end.getCurrent();
+        return TimeStamp::diff(end, start)/(2*count);
+    }
+};
+
+template<typename E>
+void pingPong(const char *name, long count)
+{
+    PingPong<E> test(count);
+    printf("%-30s round trip %8.3f us\n", name, test.run()*1e6);
+}
+
+template<typename M>
+void contend(const char *name, long count)
+{
+    Contend<M> test(count);
+    printf("%-30s lock+unlock %7.3f us\n", name, test.run()*1e6);
+}
+
+} // namespace
+
+MAIN(pingPongLatency)
+{
+    const long count = 100000;
+
+    pingPong<epicsEvent>("epicsEvent", count);
+    pingPong<Event>("epics::pvData::Event", count);
+#ifdef PVDATA_HAVE_FUTEX
+    pingPong<FutexEvent>("FutexEvent", count);
+#endif
+
+    contend<epicsMutex>("epicsMutex", 10*count);
+    contend<Mutex>("epics::pvData::Mutex", 10*count);
+#ifdef PVDATA_HAVE_FUTEX
+    contend<FutexMutex>("FutexMutex", 10*count);
+#endif
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <cstring>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/arrayAllocator.h>
+#include <pv/sharedVector.h>
+#include <pv/byteBuffer.h>
+#include <pv/pvData.h>
+
+using namespace epics::pvData;
+
+namespace {
+
+bool aligned(const void *ptr, size_t alignment)
+{
+    return ((size_t)ptr)%alignment==0;
+}
+
+struct CountingAllocator : public ArrayAllocator {
+    POINTER_DEFINITIONS(CountingAllocator);
+    AlignedAllocator inner;
+    size_t allocs, frees, liveBytes;
+    CountingAllocator() :inner(64), allocs(0), frees(0), liveBytes(0) {}
+    virtual ~CountingAllocator() {}
+    virtual void* allocate(size_t bytes)
+    {
+        allocs++;
+        liveBytes += bytes;
+        return inner.allocate(bytes);
+    }
+    virtual void deallocate(void *ptr, size_t bytes)
+    {
+        frees++;
+        liveBytes -= bytes;
+        inner.deallocate(ptr, bytes);
+    }
+};
+
+} // namespace
+
+static void testAligned()
+{
+    testDiag("testAligned");
+    AlignedAllocator A(64);
+    bool ok = true;
+    for(size_t n=0; n<5000; n+=7) {
+        void *p = A.allocate(n);
+        ok &= p!=0 && aligned(p, 64);
+        memset(p, 0xa5, n);
+        A.deallocate(p, n);
+    }
+    testOk(ok, "64 byte aligned for all sizes");
+
+    try {
+        AlignedAllocator bad(48);
+        testFail("Accepted alignment 48");
+    } catch(std::invalid_argument& e) {
+        testPass("Rejected alignment 48 : %s", e.what());
+    }
+}
+
+static void testPool()
+{
+    testDiag("testPool");
+    AlignedAllocator A(64, 0, 1024, 512);
+
+    void *a = A.allocate(100);
+    A.deallocate(a, 100);
+    testOk1(A.stats().pooledBytes==128);
+
+    // same size class
+    void *b = A.allocate(120);
+    testOk1(a==b);
+    testOk1(A.stats().poolHits==1);
+    testOk1(A.stats().poolMisses==1);
+    testOk1(A.stats().pooledBytes==0);
+
+    // too large to pool
+    void *c = A.allocate(1000);
+    testOk1(A.stats().poolMisses==1);
+    A.deallocate(c, 1000);
+    testOk1(A.stats().pooledBytes==0);
+
+    // pool size is bounded
+    void *blocks[10];
+    for(size_t i=0; i<10; i++)
+        blocks[i] = A.allocate(256);
+    for(size_t i=0; i<10; i++)
+        A.deallocate(blocks[i], 256);
+    testOk(A.stats().pooledBytes==1024, "pooledBytes %u", (unsigned)A.stats().pooledBytes);
+
+    A.deallocate(b, 120);
+    testOk1(A.stats().pooledBytes==1024);
+
+    A.trim();
+    testOk1(A.stats().pooledBytes==0);
+}
+
+static void testHugePage()
+{
+    testDiag("testHugePage");
+    AlignedAllocator A(64, 1024*1024);
+    const size_t bytes = 3*1024*1024 + 5;
+    char *p = (char*)A.allocate(bytes);
+    testOk1(p!=0 && aligned(p, 64));
+    p[0] = 1;
+    p[bytes-1] = 2;
+    testOk1(p[0]+p[bytes-1]==3);
+#ifdef __linux__
+    testOk1(aligned(p, AlignedAllocator::hugePageSize));
+    testOk1(A.stats().hugePageAllocations==1);
+#else
+    testSkip(2, "huge pages only on Linux");
+#endif
+    A.deallocate(p, bytes);
+
+    void *small = A.allocate(1000);
+    testOk1(A.stats().hugePageAllocations<=1);
+    A.deallocate(small, 1000);
+}
+
+static void testSharedVector()
+{
+    testDiag("testSharedVector");
+    testOk1(ArrayAllocator::get(pvDouble)==0);
+
+    CountingAllocator::shared_pointer A(new CountingAllocator);
+    ArrayAllocator::set(pvDouble, A);
+    testOk1(ArrayAllocator::get(pvDouble)==A.get());
+    testOk1(ArrayAllocator::get(pvInt)==0);
+    {
+        shared_vector<double> V(1000, 1.5);
+        testOk1(A->allocs==1);
+        testOk1(A->liveBytes==1000*sizeof(double));
+        testOk1(aligned(V.data(), 64));
+        testOk1(V[999]==1.5);
+
+        V.resize(2000);
+        testOk1(A->allocs==2 && A->frees==1);
+        testOk1(aligned(V.data(), 64));
+        testOk1(V[999]==1.5);
+
+        shared_vector<const double> C(freeze(V));
+        shared_vector<double> U(thaw(C));
+        testOk1(A->allocs==2);
+
+        shared_vector<int32> I(10);
+        testOk1(A->allocs==2);
+    }
+    testOk1(A->allocs==A->frees);
+    testOk1(A->liveBytes==0);
+
+    // PVDoubleArray storage
+    {
+        PVDoubleArrayPtr arr(getPVDataCreate()->createPVScalarArray<PVDoubleArray>());
+        arr->setLength(100);
+        testOk1(A->allocs==A->frees+1);
+        shared_vector<const double> data(arr->view());
+        testOk1(aligned(data.data(), 64));
+    }
+    testOk1(A->allocs==A->frees);
+
+    ArrayAllocator::set(pvDouble, ArrayAllocator::shared_pointer());
+    testOk1(ArrayAllocator::get(pvDouble)==0);
+    {
+        size_t before = A->allocs;
+        shared_vector<double> V(10);
+        testOk1(A->allocs==before);
+    }
+
+    try {
+        ArrayAllocator::set(pvString, A);
+        testFail("Accepted pvString");
+    } catch(std::invalid_argument& e) {
+        testPass("Rejected pvString : %s", e.what());
+    }
+}
+
+static void testDefault()
+{
+    testDiag("testDefault");
+    CountingAllocator::shared_pointer A(new CountingAllocator);
+    ArrayAllocator::setDefault(A);
+    testOk1(ArrayAllocator::getDefault()==A.get());
+    testOk1(ArrayAllocator::get(pvUByte)==A.get());
+    {
+        shared_vector<uint8> V(10);
+        testOk1(A->allocs==1);
+
+        ByteBuffer buf(1000);
+        testOk1(A->allocs==2);
+        testOk1(aligned(buf.getBuffer(), 64));
+        buf.putInt(42);
+        buf.flip();
+        testOk1(buf.getInt()==42);
+
+        char raw[8];
+        ByteBuffer wrapped(raw, sizeof(raw));
+        testOk1(A->allocs==2);
+    }
+    testOk1(A->allocs==2 && A->frees==2);
+
+    // type specific takes precedence
+    CountingAllocator::shared_pointer B(new CountingAllocator);
+    ArrayAllocator::set(pvUByte, B);
+    {
+        shared_vector<uint8> V(10);
+        testOk1(B->allocs==1 && A->allocs==2);
+    }
+    ArrayAllocator::set(pvUByte, ArrayAllocator::shared_pointer());
+
+    ArrayAllocator::setDefault(ArrayAllocator::shared_pointer());
+    testOk1(ArrayAllocator::getDefault()==0);
+    {
+        ByteBuffer buf(100);
+        testOk1(A->allocs==2);
+    }
+}
+
+MAIN(testArrayAllocator)
+{
+    testPlan(48);
+    testAligned();
+    testPool();
+    testHugePage();
+    testSharedVector();
+    testDefault();
+    return testDone();
+}
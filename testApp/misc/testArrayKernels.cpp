@@ -0,0 +1,254 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <cmath>
+#include <limits>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/arrayKernels.h>
+
+using namespace epics::pvData;
+
+namespace {
+
+template<typename T>
+shared_vector<const T> ramp(size_t n, double start, double step)
+{
+    shared_vector<T> ret(n);
+    for(size_t i=0; i<n; i++)
+        ret[i] = T(start + step*i);
+    return freeze(ret);
+}
+
+template<typename T>
+ArrayStatistics reference(const shared_vector<const T>& V)
+{
+    ArrayStatistics S;
+    S.count = V.size();
+    S.min = std::numeric_limits<double>::infinity();
+    S.max = -S.min;
+    S.sum = S.sumOfSquares = 0.0;
+    for(size_t i=0; i<V.size(); i++) {
+        double v = V[i];
+        if(v<S.min) S.min = v;
+        if(v>S.max) S.max = v;
+        S.sum += v;
+        S.sumOfSquares += v*v;
+    }
+    return S;
+}
+
+bool close(double a, double b)
+{
+    return std::fabs(a-b) <= 1e-12*std::max(std::fabs(a), std::fabs(b));
+}
+
+bool sameStats(const ArrayStatistics& A, const ArrayStatistics& B)
+{
+    bool ok = A.count==B.count && A.min==B.min && A.max==B.max
+            && close(A.sum, B.sum) && close(A.sumOfSquares, B.sumOfSquares);
+    if(!ok)
+        testDiag("count %u %u min %g %g max %g %g sum %.17g %.17g sumsq %.17g %.17g",
+                 (unsigned)A.count, (unsigned)B.count, A.min, B.min, A.max, B.max,
+                 A.sum, B.sum, A.sumOfSquares, B.sumOfSquares);
+    return ok;
+}
+
+template<typename T>
+void testStatsType(const char *name, double start, double step)
+{
+    bool ok = true;
+    // all tail lengths of the vector loops
+    for(size_t n=1; n<40; n++) {
+        shared_vector<const T> V(ramp<T>(n, start, step));
+        ok &= sameStats(arrayStatistics(V), reference(V));
+    }
+    shared_vector<const T> V(ramp<T>(3001, start, step));
+    ok &= sameStats(arrayStatistics(V), reference(V));
+    testOk(ok, "arrayStatistics<%s>", name);
+}
+
+} // namespace
+
+static void testStatistics()
+{
+    testDiag("testStatistics with %s kernels", ArrayKernels::implementation());
+    testStatsType<double>("double", -100.5, 0.25);
+    testStatsType<float>("float", 10.0, -0.5);
+    testStatsType<int8>("int8", -100, 1);
+    testStatsType<uint8>("uint8", 0, 1);
+    testStatsType<int16>("int16", -1000, 3);
+    testStatsType<uint16>("uint16", 0, 7);
+    testStatsType<int32>("int32", -100000, 77);
+    testStatsType<uint32>("uint32", 0, 1001);
+    testStatsType<int64>("int64", -1e12, 1e9);
+    testStatsType<uint64>("uint64", 0, 1e9);
+
+    shared_vector<double> V(5, 1.0);
+    V[1] = -3.0;
+    V[3] = 7.0;
+    shared_vector<const double> C(freeze(V));
+    ArrayStatistics S(arrayStatistics(C));
+    testOk1(S.count==5);
+    testOk1(S.min==-3.0 && S.max==7.0);
+    testOk1(S.sum==7.0 && S.sumOfSquares==61.0);
+    testOk1(S.mean()==1.4);
+    testOk1(close(S.rms(), std::sqrt(61.0/5)));
+    testOk1(close(S.stddev(), std::sqrt(61.0/5 - 1.4*1.4)));
+
+    // NaN is ignored by min and max
+    V = thaw(C);
+    V[0] = std::numeric_limits<double>::quiet_NaN();
+    C = freeze(V);
+    S = arrayStatistics(C);
+    testOk1(S.min==-3.0 && S.max==7.0);
+    testOk1(S.sum!=S.sum);
+
+    shared_vector<const double> E;
+    S = arrayStatistics(E);
+    testOk1(S.count==0 && S.sum==0.0);
+    testOk1(S.min==std::numeric_limits<double>::infinity());
+    testOk1(S.max==-std::numeric_limits<double>::infinity());
+
+    try {
+        shared_vector<const boolean> B(2, 1);
+        arrayStatistics(B);
+        testFail("accepted boolean");
+    } catch(std::invalid_argument& e) {
+        testPass("boolean : %s", e.what());
+    }
+}
+
+static void testAffine()
+{
+    testDiag("testAffine");
+    shared_vector<const int16> raw(ramp<int16>(1001, -500, 1));
+    shared_vector<double> eng(arrayAffine<double>(raw, 0.5, -10.0));
+    bool ok = eng.size()==raw.size();
+    for(size_t i=0; ok && i<raw.size(); i++)
+        ok &= eng[i]==raw[i]*0.5 - 10.0;
+    testOk(ok, "int16 -> double");
+
+    shared_vector<const double> D(freeze(eng));
+    shared_vector<float> F(arrayAffine<float>(D, 2.0, 1.0));
+    ok = F.size()==D.size();
+    for(size_t i=0; ok && i<D.size(); i++)
+        ok &= F[i]==float(D[i]*2.0 + 1.0);
+    testOk(ok, "double -> float");
+
+    shared_vector<int32> I(arrayAffine<int32>(D, 4.0, 0.0));
+    ok = I.size()==D.size();
+    for(size_t i=0; ok && i<D.size(); i++)
+        ok &= I[i]==int32(D[i]*4.0);
+    testOk(ok, "double -> int32");
+
+    shared_vector<double> inplace(arrayAffine<double>(D, 1.0, 0.0));
+    ok = std::equal(inplace.begin(), inplace.end(), D.begin());
+    testOk(ok, "identity");
+}
+
+static void testConvert()
+{
+    testDiag("testConvert");
+    shared_vector<const int32> I(ramp<int32>(2049, -1024, 3));
+    shared_vector<double> D(arrayConvert<double>(I));
+    bool ok = D.size()==I.size();
+    for(size_t i=0; ok && i<I.size(); i++)
+        ok &= D[i]==double(I[i]);
+    testOk(ok, "int32 -> double");
+
+    shared_vector<const double> C(freeze(D));
+    shared_vector<int16> S(arrayConvert<int16>(C));
+    ok = S.size()==C.size();
+    for(size_t i=0; ok && i<C.size(); i++)
+        ok &= S[i]==int16(C[i]);
+    testOk(ok, "double -> int16");
+}
+
+static void testHistogram()
+{
+    testDiag("testHistogram");
+    shared_vector<const double> V(ramp<double>(100, 0.0, 0.1)); // 0.0 ... 9.9
+    shared_vector<uint64> bins(10, 0);
+    size_t n = arrayHistogram(V, 0.0, 10.0, bins);
+    testOk1(n==100);
+    bool ok = true;
+    uint64 total = 0;
+    for(size_t i=0; i<bins.size(); i++) {
+        total += bins[i];
+        ok &= bins[i]>=9 && bins[i]<=11; // rounding of 0.1*i
+    }
+    testOk1(ok && total==100);
+
+    // accumulate, and ignore out of range
+    shared_vector<double> W(4);
+    W[0] = -0.001;
+    W[1] = 10.0;
+    W[2] = std::numeric_limits<double>::quiet_NaN();
+    W[3] = 9.5;
+    shared_vector<const double> CW(freeze(W));
+    uint64 last = bins[9];
+    n = arrayHistogram(CW, 0.0, 10.0, bins);
+    testOk1(n==1);
+    testOk1(bins[9]==last+1);
+
+    shared_vector<const uint8> B(ramp<uint8>(256, 0, 1));
+    shared_vector<uint64> bb(4, 0);
+    n = arrayHistogram(B, 0.0, 256.0, bb);
+    testOk1(n==256 && bb[0]==64 && bb[1]==64 && bb[2]==64 && bb[3]==64);
+
+    try {
+        arrayHistogram(V, 1.0, 1.0, bins);
+        testFail("accepted lo==hi");
+    } catch(std::invalid_argument& e) {
+        testPass("lo==hi : %s", e.what());
+    }
+}
+
+static void testParallel()
+{
+    testDiag("testParallel");
+    shared_vector<const double> V(ramp<double>(100003, -1000.0, 0.0123));
+    shared_vector<const int32> I(ramp<int32>(100003, -50000, 1));
+    ArrayStatistics serial(arrayStatistics(V)), serialI(arrayStatistics(I));
+    shared_vector<double> serialAffine(arrayAffine<double>(I, 0.1, 3.0));
+    shared_vector<uint64> serialBins(50, 0);
+    arrayHistogram(V, -1000.0, 0.0, serialBins);
+
+    ArrayKernels::setParallel(4, 1000);
+    testOk1(ArrayKernels::threads()==4);
+
+    testOk1(sameStats(arrayStatistics(V), serial));
+    testOk1(sameStats(arrayStatistics(I), serialI));
+    shared_vector<double> A(arrayAffine<double>(I, 0.1, 3.0));
+    testOk1(std::equal(A.begin(), A.end(), serialAffine.begin()));
+    shared_vector<double> D(arrayConvert<double>(I));
+    testOk1(D.size()==I.size() && D[0]==-50000.0 && D[100002]==50002.0);
+    shared_vector<uint64> bins(50, 0);
+    size_t n = arrayHistogram(V, -1000.0, 0.0, bins);
+    testOk1(std::equal(bins.begin(), bins.end(), serialBins.begin()));
+    testOk1(n==81301);
+
+    // small arrays are not split
+    shared_vector<const double> small(ramp<double>(10, 0.0, 1.0));
+    testOk1(arrayStatistics(small).sum==45.0);
+
+    ArrayKernels::setParallel(1);
+    testOk1(ArrayKernels::threads()==1);
+    testOk1(sameStats(arrayStatistics(V), serial));
+}
+
+MAIN(testArrayKernels)
+{
+    testPlan(44);
+    testStatistics();
+    testAffine();
+    testConvert();
+    testHistogram();
+    testParallel();
+    return testDone();
+}
@@ -7,6 +7,8 @@
 #include <testMain.h>
 
 #include <pv/event.h>
+#include <pv/thread.h>
+#include <pv/futex.h>
 
 using namespace epics::pvData;
 
@@ -41,10 +43,75 @@ static void testBasicEvent()
     testOk1(!e.tryWait());
 }
 
+#ifdef PVDATA_HAVE_FUTEX
+static void testBasicFutexEvent()
+{
+    testDiag("testBasicFutexEvent");
+
+    FutexEvent e;
+
+    testOk1(!e.tryWait());
+    testOk1(!e.wait(0.01));
+
+    e.signal();
+    e.signal();
+    testOk1(e.wait(0.01));
+    testOk1(!e.tryWait());
+
+    FutexEvent full(true);
+    testOk1(full.wait());
+    testOk1(!full.tryWait());
+}
+
+namespace {
+struct Counter {
+    FutexMutex mutex;
+    int count;
+    enum {loops = 100000};
+    Counter() :count(0) {}
+    void inc()
+    {
+        for(int i=0; i<loops; i++) {
+            mutex.lock();
+            mutex.lock(); // recursive
+            count++;
+            mutex.unlock();
+            mutex.unlock();
+        }
+    }
+};
+}
+
+static void testFutexMutex()
+{
+    testDiag("testFutexMutex");
+
+    Counter C;
+
+    testOk1(C.mutex.tryLock());
+    testOk1(C.mutex.tryLock());
+    C.mutex.unlock();
+    C.mutex.unlock();
+
+    {
+        Thread A(Thread::Config(&C, &Counter::inc).name("incA"));
+        Thread B(Thread::Config(&C, &Counter::inc).name("incB"));
+        // joined on destruction
+    }
+    testOk(C.count==2*Counter::loops, "count %d == %d", C.count, 2*Counter::loops);
+}
+#endif
+
 MAIN(testEvent)
 {
-    testPlan(9);
+    testPlan(18);
     testBasicEvent();
+#ifdef PVDATA_HAVE_FUTEX
+    testBasicFutexEvent();
+    testFutexMutex();
+#else
+    testSkip(9, "No futex");
+#endif
     return testDone();
 }
  
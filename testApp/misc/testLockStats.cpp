@@ -0,0 +1,85 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <sstream>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/lock.h>
+#include <pv/event.h>
+#include <pv/thread.h>
+
+using namespace epics::pvData;
+
+namespace {
+struct Holder {
+    NamedMutex mutex;
+    Event locked, release;
+    Holder() :mutex("testLockStats") {}
+    void hold()
+    {
+        Lock G(mutex);
+        locked.signal();
+        release.wait();
+        epicsThreadSleep(0.01);
+    }
+};
+}
+
+static void testNamedMutex()
+{
+    testDiag("testNamedMutex");
+    resetLockStats();
+
+    Holder H;
+    {
+        Lock G(H.mutex);
+        testOk1(G.ownsLock());
+        Lock G2(H.mutex); // recursive
+        testOk1(G2.ownsLock());
+    }
+    {
+        Thread T(Thread::Config(&H, &Holder::hold).name("holder"));
+        H.locked.wait();
+        H.release.signal();
+        Lock G(H.mutex); // waits for the holder
+        testOk1(G.ownsLock());
+    }
+
+    std::ostringstream strm;
+    reportLockStats(strm);
+    testDiag("%s", strm.str().c_str());
+
+#ifdef PVDATA_LOCK_STATS
+    std::vector<LockStats> stats;
+    getLockStats(stats);
+    const LockStats *S = 0;
+    for(size_t i=0; i<stats.size(); i++)
+        if(stats[i].name=="testLockStats")
+            S = &stats[i];
+    testOk1(S!=0);
+    if(S) {
+        testOk(S->instances==1, "instances %u==1", (unsigned)S->instances);
+        testOk(S->acquired==3, "acquired %u==3", (unsigned)S->acquired);
+        testOk(S->contended==1, "contended %u==1", (unsigned)S->contended);
+        testOk(S->maxWait>=5000000, "maxWait %g ms", S->maxWait*1e-6);
+        testOk(S->maxHold>=5000000, "maxHold %g ms", S->maxHold*1e-6);
+    } else {
+        testSkip(5, "testLockStats missing");
+    }
+    testOk1(strm.str().find("testLockStats")!=std::string::npos);
+#else
+    testOk1(strm.str().find("PVDATA_LOCK_STATS")!=std::string::npos);
+    testSkip(6, "Not built with PVDATA_LOCK_STATS");
+#endif
+}
+
+MAIN(testLockStats)
+{
+    testPlan(10);
+    testNamedMutex();
+    return testDone();
+}
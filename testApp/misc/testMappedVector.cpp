@@ -0,0 +1,187 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/mappedVector.h>
+#include <pv/pvData.h>
+
+using namespace epics::pvData;
+
+namespace {
+
+const char *fname = "testMappedVector.tmp";
+const size_t nelem = 100000; // spans several pages
+
+void writeFile()
+{
+    std::vector<double> data(nelem);
+    for(size_t i=0; i<nelem; i++)
+        data[i] = double(i);
+    FILE *fp = fopen(fname, "wb");
+    if(!fp)
+        testAbort("Can't create %s", fname);
+    // odd length, so the last element is incomplete
+    if(fwrite(&data[0], sizeof(double), nelem, fp)!=nelem || fwrite("xyz", 1, 3, fp)!=3)
+        testAbort("Can't write %s", fname);
+    fclose(fp);
+}
+
+bool checkValues(const shared_vector<const double>& V, size_t first)
+{
+    for(size_t i=0; i<V.size(); i++) {
+        if(V[i]!=double(first+i)) {
+            testDiag("[%u] %f != %u", (unsigned)i, V[i], (unsigned)(first+i));
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+static void testMapWhole()
+{
+    testDiag("testMapWhole");
+    shared_vector<const double> V(mapFileVector<double>(fname));
+    testOk(V.size()==nelem, "size %u", (unsigned)V.size());
+    testOk1(checkValues(V, 0));
+
+    shared_vector<const uint8> B(mapFileVector<uint8>(fname));
+    testOk1(B.size()==nelem*sizeof(double)+3);
+    testOk1(B[B.size()-1]=='z');
+}
+
+static void testMapRegion()
+{
+    testDiag("testMapRegion");
+    // not page aligned
+    shared_vector<const double> V(mapFileVector<double>(fname, 8*1001, 5000, mapReadOnly|mapRandom));
+    testOk1(V.size()==5000);
+    testOk1(checkValues(V, 1001));
+
+    shared_vector<const double> E(mapFileVector<double>(fname, 8*10, 0));
+    testOk1(E.empty());
+
+    try {
+        mapFileVector<double>(fname, 3);
+        testFail("accepted unaligned offset");
+    } catch(std::invalid_argument& e) {
+        testPass("unaligned offset : %s", e.what());
+    }
+    try {
+        mapFileVector<double>(fname, 8*(nelem-10), 11);
+        testFail("accepted region beyond EOF");
+    } catch(std::runtime_error& e) {
+        testPass("beyond EOF : %s", e.what());
+    }
+    try {
+        mapFileVector<double>("testMappedVector.nonexistent");
+        testFail("opened non-existent file");
+    } catch(std::runtime_error& e) {
+        testPass("no file : %s", e.what());
+    }
+}
+
+static void testReadOnly()
+{
+    testDiag("testReadOnly");
+    shared_vector<const double> V(mapFileVector<double>(fname, 0, 100));
+    const double *mapped = V.data();
+    testOk1(!V.unique());
+
+    // shares the mapping
+    shared_vector<const double> copy(V);
+    testOk1(copy.data()==mapped);
+    copy.clear();
+    testOk1(!V.unique());
+
+    // must copy
+    shared_vector<double> M(thaw(V));
+    testOk1(M.data()!=mapped);
+    testOk1(M.size()==100 && M[99]==99.0);
+    M[0] = 42.0;
+
+    shared_vector<const double> again(mapFileVector<double>(fname, 0, 1));
+    testOk1(again[0]==0.0);
+
+    // slices, casts and assignments of the mapping stay read-only
+    shared_vector<const double> part(mapFileVector<double>(fname, 0, 100));
+    part.slice(10, 20);
+    testOk(!part.unique(), "slice is read-only");
+    shared_vector<const void> bytes(static_shared_vector_cast<const void>(part));
+    part.clear();
+    testOk(!bytes.unique(), "cast is read-only");
+    shared_vector<const double> other;
+    other = static_shared_vector_cast<const double>(bytes);
+    bytes.clear();
+    testOk(!other.unique(), "assignment is read-only");
+    shared_vector<double> W(thaw(other));
+    testOk1(W.size()==20 && W[0]==10.0 && W.unique());
+}
+
+static void testCopyOnWrite()
+{
+    testDiag("testCopyOnWrite");
+    shared_vector<const double> V(mapFileVector<double>(fname, 0, 100, mapCopyOnWrite|mapWillNeed));
+    const double *mapped = V.data();
+    testOk1(V.unique());
+
+    // in place
+    shared_vector<double> M(thaw(V));
+    testOk1(M.data()==mapped);
+    M[0] = 42.0;
+    testOk1(M[0]==42.0);
+
+    // file is not modified
+    shared_vector<const double> again(mapFileVector<double>(fname, 0, 1));
+    testOk1(again[0]==0.0);
+}
+
+static void testReplace()
+{
+    testDiag("testReplace");
+    PVDoubleArrayPtr arr(getPVDataCreate()->createPVScalarArray<PVDoubleArray>());
+    shared_vector<const double> V(mapFileVector<double>(fname));
+    const double *mapped = V.data();
+    arr->replace(V);
+    V.clear();
+
+    PVDoubleArray::const_svector view(arr->view());
+    testOk1(view.data()==mapped);
+    testOk1(view.size()==nelem);
+    view.clear();
+
+    // modification through the array copies
+    PVDoubleArray::svector mod(arr->reuse());
+    testOk1(mod.data()!=mapped);
+    testOk1(mod.size()==nelem && mod[nelem-1]==double(nelem-1));
+}
+
+MAIN(testMappedVector)
+{
+#ifdef _WIN32
+    testPlan(1);
+    testSkip(1, "mapFileVector() not supported");
+#else
+    testPlan(28);
+    writeFile();
+    try {
+        testMapWhole();
+        testMapRegion();
+        testReadOnly();
+        testCopyOnWrite();
+        testReplace();
+    } catch(std::exception& e) {
+        testFail("Unexpected exception: %s", e.what());
+    }
+    remove(fname);
+#endif
+    return testDone();
+}
@@ -377,6 +377,42 @@ void testArray() {
     testArrayType<PVStringArray>(sdata, NELEMENTS(sdata));
 }
 
+template<typename PVT>
+void testArrayReuse(const typename PVT::value_type* rdata, size_t len)
+{
+    testDiag("deserialize %s re-uses array", ScalarTypeFunc::name(PVT::typeCode));
+
+    typename PVT::svector data(len);
+    std::copy(rdata, rdata+len, data.begin());
+
+    typename PVT::shared_pointer src = std::tr1::static_pointer_cast<PVT>(getPVDataCreate()->createPVScalarArray(PVT::typeCode));
+    typename PVT::shared_pointer dest = std::tr1::static_pointer_cast<PVT>(getPVDataCreate()->createPVScalarArray(PVT::typeCode));
+    src->replace(freeze(data));
+    {
+        typename PVT::svector prev(len+2);
+        dest->replace(freeze(prev));
+    }
+    const void *before = dest->view().dataPtr().get();
+
+    buffer->clear();
+    src->serialize(buffer, flusher);
+    buffer->flip();
+    dest->deserialize(buffer, control);
+
+    testOk1(*src==*dest);
+    testOk1(dest->view().dataPtr().get()==before);
+
+    // while a reference is held elsewhere it must not be modified
+    typename PVT::const_svector held(dest->view());
+    buffer->clear();
+    src->serialize(buffer, flusher);
+    buffer->flip();
+    dest->deserialize(buffer, control);
+
+    testOk1(*src==*dest);
+    testOk1(dest->view().dataPtr().get()!=held.dataPtr().get());
+}
+
 void testStructure() {
     testDiag("Testing structure...");
 
@@ -861,7 +897,7 @@ void testFromString(int byteOrder)
 
 MAIN(testSerialization) {
 
-    testPlan(234);
+    testPlan(242);
 
     flusher = new SerializableControlImpl();
     control = new DeserializableControlImpl();
@@ -874,6 +910,8 @@ MAIN(testSerialization) {
 
     testScalar();
     testArray();
+    testArrayReuse<PVDoubleArray>(ddata, NELEMENTS(ddata));
+    testArrayReuse<PVStringArray>(sdata, NELEMENTS(sdata));
     testStructure();
     testStructureId();
     testStructureArray();
@@ -328,6 +328,78 @@ static void testCapacity()
     testOk1(vect[1]==124);
 }
 
+static void testResizeModes()
+{
+    testDiag("Test resize_uninitialized() and resize_amortized()");
+
+    epics::pvData::shared_vector<int32> vect(10, 100);
+    int32 *peek = vect.dataPtr().get();
+
+    vect.resize_uninitialized(5);
+    testOk1(vect.dataPtr().get() == peek);
+    testOk1(vect.size()==5);
+    testOk1(vect.dataTotal()==10);
+
+    vect.resize_uninitialized(10);
+    testOk1(vect.dataPtr().get() == peek);
+    testOk1(vect.size()==10);
+
+    {
+        // shared, so a new array, and the other reference is untouched
+        epics::pvData::shared_vector<int32> other(vect);
+        vect.resize_uninitialized(4);
+        testOk1(vect.dataPtr().get() != peek);
+        testOk1(vect.size()==4);
+        testOk1(vect.unique());
+        testOk1(other.dataPtr().get() == peek);
+        testOk1(other.size()==10 && other[9]==100);
+    }
+
+    {
+        // read-only storage, eg. a file mapping, is not resized in place
+        for(unsigned i=0; i<2; i++) {
+            epics::pvData::shared_vector<int32> src(10, 100);
+            std::tr1::shared_ptr<int32> store(src.dataPtr());
+            src.clear();
+            epics::pvData::shared_vector<void> bytes(store, 0, 10*sizeof(int32),
+                                                     epics::pvData::detail::_shared_vector_readonly_tag());
+            int32 *ro = store.get();
+            store.reset();
+            epics::pvData::shared_vector<int32> RO(epics::pvData::static_shared_vector_cast<int32>(bytes));
+            bytes.clear();
+            if(i==0) {
+                RO.resize(5);
+                testOk(RO.dataPtr().get()!=ro && RO.size()==5 && RO[4]==100, "resize() copies read-only storage");
+            } else {
+                RO.resize_uninitialized(5);
+                testOk(RO.dataPtr().get()!=ro && RO.size()==5, "resize_uninitialized() allocates for read-only storage");
+            }
+        }
+    }
+
+    vect.resize_uninitialized(0);
+    testOk1(vect.empty());
+
+    size_t nallocs = 0;
+    size_t cap = vect.capacity();
+    for(size_t s=0; s<16*1024; s++) {
+        vect.resize_amortized(s+1);
+        vect[s] = int32(s);
+        if(cap!=vect.capacity()) {
+            nallocs++;
+            cap = vect.capacity();
+        }
+    }
+    bool ok = true;
+    for(size_t s=0; s<vect.size(); s++)
+        ok &= vect[s]==int32(s);
+    testDiag("resize_amortized() %lu times caused %lu re-allocations",
+             (unsigned long)vect.size(), (unsigned long)nallocs);
+    testOk1(vect.size()==16*1024);
+    testOk1(ok);
+    testOk1(nallocs<=25);
+}
+
 static void testPush()
 {
     epics::pvData::shared_vector<int32> vect;
@@ -622,7 +694,7 @@ void testBad()
 
 MAIN(testSharedVector)
 {
-    testPlan(167);
+    testPlan(183);
     testDiag("Tests for shared_vector");
 
     testDiag("sizeof(shared_vector<int32>)=%lu",
@@ -635,6 +707,7 @@ MAIN(testSharedVector)
     testShare();
     testConst();
     testSlice();
+    testResizeModes();
     testPush();
     testVoid();
     testConstVoid();
@@ -16,6 +16,8 @@
 #include <cstdio>
 #include <cstring>
 #include <list>
+#include <vector>
+#include <stdexcept>
 
 #include <epicsUnitTest.h>
 #include <testMain.h>
@@ -108,6 +110,136 @@ static void testBasic() {
     testDiag("testBasic PASSED");
 }
 
+namespace {
+struct CountCommand : public Command {
+    POINTER_DEFINITIONS(CountCommand);
+    int count;
+    CountCommand() :count(0) {}
+    virtual void command() { count++; }
+};
+
+struct ThrowCommand : public Command {
+    virtual void command() { throw std::runtime_error("expected exception\n"); }
+};
+
+void countFN(void *raw)
+{
+    (*(int*)raw)++;
+}
+}
+
+static void testBatch()
+{
+    testDiag("testBatch");
+    ExecutorPtr executor(new Executor(string("batch"),middlePriority));
+
+    // the same command queued many times runs once per time
+    CountCommand::shared_pointer cmd(new CountCommand);
+    std::vector<CommandPtr> batch(100, cmd);
+    batch.push_back(CommandPtr(new ThrowCommand));
+
+    Executor::Completion done;
+    executor->executeBatch(batch.begin(), batch.end(), &done);
+    executor->executeBatch(batch.begin(), batch.begin()+50, &done);
+    testOk1(done.wait(5.0));
+    testOk(cmd->count==150, "count %d == 150", cmd->count);
+    testOk(done.failures()==1, "failures %u == 1", (unsigned)done.failures());
+    testOk1(cmd.use_count()==1+100); // queue holds no references
+
+    // reuse completion with function commands
+    int fncount = 0;
+    for(int i=0; i<1000; i++)
+        executor->execute(&countFN, &fncount, &done);
+    done.wait();
+    testOk1(done.isDone());
+    testOk(fncount==1000, "fncount %d == 1000", fncount);
+
+    // a NULL command rejects the whole batch
+    std::vector<CommandPtr> bad(3, cmd);
+    bad[1].reset();
+    cmd->count = 0;
+    try {
+        executor->executeBatch(bad.begin(), bad.end(), &done);
+        testFail("NULL command in batch accepted");
+    } catch(std::invalid_argument& e) {
+        testPass("NULL command in batch : %s", e.what());
+    }
+    testOk(done.wait(5.0) && done.isDone(), "nothing added to completion");
+    testOk(cmd->count==0, "nothing queued, count %d == 0", cmd->count);
+
+    // commands queued before destruction are executed
+    cmd->count = 0;
+    executor->executeBatch(batch.begin(), batch.begin()+10);
+    executor.reset();
+    testOk(cmd->count==10, "count %d == 10", cmd->count);
+}
+
+namespace {
+struct Recorder {
+    Event release;
+    std::vector<int> order;
+    static void block(void *raw)
+    {
+        ((Recorder*)raw)->release.wait();
+    }
+    static void control(void *raw)
+    {
+        ((Recorder*)raw)->order.push_back(1);
+    }
+    static void bulk(void *raw)
+    {
+        ((Recorder*)raw)->order.push_back(2);
+    }
+};
+}
+
+static void testClasses()
+{
+    testDiag("testClasses");
+    ExecutorPtr executor(new Executor(string("classes"),middlePriority));
+    unsigned control = executor->addClass("control", 0.001);
+    unsigned bulk = executor->addClass("bulk", 10.0);
+    testOk1(control==1 && bulk==2);
+
+    try {
+        executor->execute(&Recorder::bulk, 0, 0, 42);
+        testFail("unknown class accepted");
+    } catch(std::invalid_argument& e) {
+        testPass("unknown class rejected: %s", e.what());
+    }
+
+    Recorder R;
+    Executor::Completion done;
+    // keep the executor busy while the queues fill
+    executor->execute(&Recorder::block, &R, &done, bulk);
+    for(int i=0; i<10; i++)
+        executor->execute(&Recorder::bulk, &R, &done, bulk);
+    executor->execute(&Recorder::control, &R, &done, control);
+    executor->execute(&Recorder::bulk, &R, &done);
+    R.release.signal();
+    testOk1(done.wait(5.0));
+
+    testOk(R.order.size()==12, "executed %u == 12", (unsigned)R.order.size());
+    testOk1(!R.order.empty() && R.order[0]==1);
+
+    std::vector<Executor::ClassStats> stats;
+    executor->getStats(stats);
+    testOk1(stats.size()==3);
+    if(stats.size()==3) {
+        for(size_t i=0; i<stats.size(); i++)
+            testDiag("%s executed %u late %u max latency %f max run %f",
+                     stats[i].name.c_str(), (unsigned)stats[i].executed, (unsigned)stats[i].late,
+                     stats[i].latencyMax, stats[i].runMax);
+        testOk1(stats[0].executed==1 && stats[1].executed==1 && stats[2].executed==11);
+        testOk1(stats[2].queued==0);
+    } else {
+        testSkip(2, "Missing stats");
+    }
+    executor->resetStats();
+    executor->getStats(stats);
+    testOk1(stats[2].executed==0);
+}
+
 namespace {
 struct fninfo {
     int cnt;
@@ -217,6 +349,26 @@ void MyFunc::function()
 
 typedef std::tr1::shared_ptr<MyFunc> MyFuncPtr;
 
+namespace {
+struct NopFunc : public TimeFunctionRequester {
+    virtual void function() {}
+};
+}
+
+static void testTimeCalls()
+{
+    testDiag("testTimeCalls");
+    TimeFunction timeFunction(TimeFunctionRequesterPtr(new NopFunc));
+    TimeStatistics stats(timeFunction.timeCalls(0.0, 0.001));
+    testOk1(stats.samples>0 && stats.calls>=stats.samples);
+    try {
+        timeFunction.timeCalls(0.0, 0.001, 0.0);
+        testFail("minBatchTime 0 accepted");
+    } catch(std::invalid_argument& e) {
+        testPass("Expected exception: %s", e.what());
+    }
+}
+
 #ifdef TESTTHREADCONTEXT
 
 static void testThreadContext() {
@@ -233,11 +385,14 @@ static void testThreadContext() {
 
 MAIN(testThread)
 {
-    testPlan(7);
+    testPlan(28);
     testDiag("Tests thread");
     testThreadRun();
     testBasic();
+    testBatch();
+    testClasses();
     testBinders();
+    testTimeCalls();
 #ifdef TESTTHREADCONTEXT
     testThreadContext();
 #endif
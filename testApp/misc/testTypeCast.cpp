@@ -13,6 +13,8 @@
 #include <algorithm>
 #include <limits>
 #include <typeinfo>
+#include <vector>
+#include <sstream>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stddef.h>
@@ -111,12 +113,175 @@ namespace {
 
 #define FAIL(TTO, TFRO, VFRO) testfail<TTO,TFRO>::op(VFRO)
 
+    // castUnsafeV() must give the same result as castUnsafe() of each element
+    template<typename TO, typename FROM>
+    void testVCast(epics::pvData::ScalarType to, epics::pvData::ScalarType from)
+    {
+        // odd length from an odd offset to exercise unaligned heads and tails
+        const size_t count = 37;
+        FROM in[count+1];
+        TO out[count+1];
+        const bool negative = std::numeric_limits<FROM>::is_signed && std::numeric_limits<TO>::is_signed;
+        for(size_t i=0; i<=count; i++) {
+            in[i] = FROM(i%100) + FROM(i%4)/FROM(4);
+            if(negative && i%2)
+                in[i] = -in[i];
+        }
+        epics::pvData::castUnsafeV(count, to, out+1, from, in+1);
+        size_t bad = 0;
+        for(size_t i=1; i<=count; i++) {
+            if(out[i]!=::epics::pvData::castUnsafe<TO,FROM>(in[i]))
+                bad++;
+        }
+        testOk(bad==0, "castUnsafeV %s -> %s %u mismatches",
+               epics::pvData::ScalarTypeFunc::name(from),
+               epics::pvData::ScalarTypeFunc::name(to), (unsigned)bad);
+    }
+
+#define TESTV_ROW(TTO, CTO) \
+    testVCast<TTO, int8_t>(epics::pvData::CTO, epics::pvData::pvByte); \
+    testVCast<TTO, int16_t>(epics::pvData::CTO, epics::pvData::pvShort); \
+    testVCast<TTO, int32_t>(epics::pvData::CTO, epics::pvData::pvInt); \
+    testVCast<TTO, int64_t>(epics::pvData::CTO, epics::pvData::pvLong); \
+    testVCast<TTO, uint8_t>(epics::pvData::CTO, epics::pvData::pvUByte); \
+    testVCast<TTO, uint16_t>(epics::pvData::CTO, epics::pvData::pvUShort); \
+    testVCast<TTO, uint32_t>(epics::pvData::CTO, epics::pvData::pvUInt); \
+    testVCast<TTO, uint64_t>(epics::pvData::CTO, epics::pvData::pvULong); \
+    testVCast<TTO, float>(epics::pvData::CTO, epics::pvData::pvFloat); \
+    testVCast<TTO, double>(epics::pvData::CTO, epics::pvData::pvDouble)
+
+    void testVCastDoubleToFloat()
+    {
+        testDiag("Test vcast double -> float clipping");
+        const double special[] = {0.0, -0.0, 1.5, -1.5, 1e300, -1e300, 1e-300, -1e-300,
+                                  1e-310, -1e-310, FLT_MAX, -FLT_MAX, FLT_MIN, -FLT_MIN,
+                                  FLT_MAX*(1.0+1e-9), epicsINF, -epicsINF, epicsNAN};
+        const size_t nspecial = sizeof(special)/sizeof(special[0]);
+        // every value at every position in a vector
+        const size_t count = 8*nspecial+3;
+        double in[count];
+        float out[count], expect[count];
+        for(size_t i=0; i<count; i++) {
+            in[i] = special[(i*5)%nspecial];
+            expect[i] = epicsConvertDoubleToFloat(in[i]);
+        }
+        epics::pvData::castUnsafeV(count, epics::pvData::pvFloat, out,
+                                   epics::pvData::pvDouble, in);
+        testOk1(memcmp(out, expect, sizeof(out))==0);
+    }
+
+    // castUnsafe<string>() must print as std::ostream does
+    template<typename T>
+    size_t formatMismatches(const T* vals, size_t count)
+    {
+        size_t bad = 0;
+        for(size_t i=0; i<count; i++) {
+            std::ostringstream strm;
+            strm<<epics::pvData::print_cast(vals[i]);
+            std::string actual(epics::pvData::castUnsafe<std::string>(vals[i]));
+            if(actual!=strm.str()) {
+                if(bad++<5)
+                    testDiag("%s printed as %s", strm.str().c_str(), actual.c_str());
+            }
+        }
+        return bad;
+    }
+
+    void testFormat()
+    {
+        testDiag("Test printing matches std::ostream");
+        {
+            const int64_t ivals[] = {0, 1, -1, 9, 10, 99, 100, -128, 127, 255, 32767, -32768,
+                                     65535, 2147483647, -2147483647-1, 4294967295LL,
+                                     9223372036854775807LL, -9223372036854775807LL-1};
+            const size_t n = sizeof(ivals)/sizeof(ivals[0]);
+            std::vector<int8_t> i8(n);
+            std::vector<uint8_t> u8(n);
+            std::vector<int16_t> i16(n);
+            std::vector<uint16_t> u16(n);
+            std::vector<int32_t> i32(n);
+            std::vector<uint32_t> u32(n);
+            std::vector<uint64_t> u64(n);
+            for(size_t i=0; i<n; i++) {
+                i8[i] = int8_t(ivals[i]);
+                u8[i] = uint8_t(ivals[i]);
+                i16[i] = int16_t(ivals[i]);
+                u16[i] = uint16_t(ivals[i]);
+                i32[i] = int32_t(ivals[i]);
+                u32[i] = uint32_t(ivals[i]);
+                u64[i] = uint64_t(ivals[i]);
+            }
+            size_t bad = formatMismatches(&i8[0], n) + formatMismatches(&u8[0], n)
+                    + formatMismatches(&i16[0], n) + formatMismatches(&u16[0], n)
+                    + formatMismatches(&i32[0], n) + formatMismatches(&u32[0], n)
+                    + formatMismatches(ivals, n) + formatMismatches(&u64[0], n);
+            testOk(bad==0, "integers %u mismatches", (unsigned)bad);
+        }
+        {
+            const double special[] = {0.0, -0.0, 0.5, 1.5, 2.5, -2.5, 0.1, 0.0001, 0.00001,
+                                      1e-5, 123456.5, 1234565.0, 999999.5, 9999995.0, 999999.0,
+                                      1000000.0, 1e100, 1e-100, 1e300, 5e-324, DBL_MAX, -DBL_MAX,
+                                      FLT_MAX, FLT_MIN, 3.14159265358979, 1.0/3.0, 2.0/3.0,
+                                      epicsINF, -epicsINF, epicsNAN};
+            const size_t n = sizeof(special)/sizeof(special[0]);
+            std::vector<double> dvals(special, special+n);
+            std::vector<float> fvals(n);
+            for(size_t i=0; i<n; i++)
+                fvals[i] = float(special[i]);
+            // decimal values with few digits hit rounding ties, random bits the rest
+            srand(1234);
+            for(size_t i=0; i<20000; i++) {
+                int e = rand()%40 - 20;
+                double dec = (rand()%2000000 - 1000000)*pow(10.0, e);
+                dvals.push_back(dec);
+                fvals.push_back(float(dec));
+                uint64_t bits = (uint64_t(rand())<<42) ^ (uint64_t(rand())<<21) ^ uint64_t(rand());
+                double raw;
+                memcpy(&raw, &bits, sizeof(raw));
+                if(raw==raw)
+                    dvals.push_back(raw);
+                uint32_t fbits = uint32_t(bits);
+                float fraw;
+                memcpy(&fraw, &fbits, sizeof(fraw));
+                if(fraw==fraw)
+                    fvals.push_back(fraw);
+            }
+            size_t bad = formatMismatches(&dvals[0], dvals.size());
+            testOk(bad==0, "%u doubles %u mismatches", (unsigned)dvals.size(), (unsigned)bad);
+            bad = formatMismatches(&fvals[0], fvals.size());
+            testOk(bad==0, "%u floats %u mismatches", (unsigned)fvals.size(), (unsigned)bad);
+        }
+    }
+
+    // parseToPOD() must give the same result as strtod()
+    void testParseDouble()
+    {
+        testDiag("Test parsing matches strtod()");
+        srand(4321);
+        size_t bad = 0, count = 0;
+        for(size_t i=0; i<20000; i++) {
+            int e = rand()%60 - 30;
+            double val = (rand()%2000000 - 1000000)*pow(10.0, e) + rand()/double(RAND_MAX);
+            const char *fmts[] = {"%g", "%.15g", "%.17g", "%f", "%e"};
+            for(size_t f=0; f<5; f++) {
+                char buf[64];
+                sprintf(buf, fmts[f], val);
+                double expect = strtod(buf, NULL), actual = 0.0;
+                epics::pvData::detail::parseToPOD(std::string(buf), &actual);
+                count++;
+                if(memcmp(&expect, &actual, sizeof(double))!=0 && bad++<5)
+                    testDiag("%s parsed as %.17g", buf, actual);
+            }
+        }
+        testOk(bad==0, "%u doubles %u mismatches", (unsigned)count, (unsigned)bad);
+    }
+
 } // end namespace
 
 
 MAIN(testTypeCast)
 {
-    testPlan(123);
+    testPlan(228);
 
 try {
 
@@ -419,6 +584,21 @@ try {
         testOk1(result[2]=="42424242");
     }
 
+    testDiag("castUnsafeV using %s kernels", epics::pvData::detail::castUnsafeVKernels());
+    TESTV_ROW(int8_t, pvByte);
+    TESTV_ROW(int16_t, pvShort);
+    TESTV_ROW(int32_t, pvInt);
+    TESTV_ROW(int64_t, pvLong);
+    TESTV_ROW(uint8_t, pvUByte);
+    TESTV_ROW(uint16_t, pvUShort);
+    TESTV_ROW(uint32_t, pvUInt);
+    TESTV_ROW(uint64_t, pvULong);
+    TESTV_ROW(float, pvFloat);
+    TESTV_ROW(double, pvDouble);
+    testVCastDoubleToFloat();
+    testFormat();
+    testParseDouble();
+
 } catch(std::exception& e) {
     testAbort("Uncaught exception: %s", e.what());
 }
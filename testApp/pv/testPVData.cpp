@@ -10,6 +10,7 @@
 #include <cstddef>
 #include <string>
 #include <cstdio>
+#include <limits>
 
 #include <epicsUnitTest.h>
 #include <testMain.h>
@@ -22,6 +23,7 @@
 #include <pv/standardPVField.h>
 #include <pv/pvTimeStamp.h>
 #include <pv/bitSet.h>
+#include <pv/arrayAllocator.h>
 
 using namespace epics::pvData;
 using std::tr1::static_pointer_cast;
@@ -534,6 +536,198 @@ static void testCopy()
     testOk(*pvUnion == *pvUnion2, "PVUnion PVStructure copy, to different type PVUnion");
 }
 
+namespace {
+struct CountingAllocator : public ArrayAllocator {
+    POINTER_DEFINITIONS(CountingAllocator);
+    size_t allocs, bytes;
+    CountingAllocator() :allocs(0), bytes(0) {}
+    virtual ~CountingAllocator() {}
+    virtual void* allocate(size_t n)
+    {
+        allocs++;
+        bytes += n;
+        return ::operator new(n);
+    }
+    virtual void deallocate(void *ptr, size_t)
+    {
+        ::operator delete(ptr);
+    }
+};
+}
+
+static void testCopyShares()
+{
+    testDiag("Check that copy() shares array storage");
+
+    CountingAllocator::shared_pointer counter(new CountingAllocator);
+    ArrayAllocator::set(pvDouble, counter);
+
+    StructureConstPtr type(fieldCreate->createFieldBuilder()->
+                           addArray("value", pvDouble)->
+                           addArray("names", pvString)->
+                           addNestedStructure("sub")->
+                               addArray("value", pvDouble)->
+                               endNested()->
+                           add("timeStamp", standardField->timeStamp())->
+                           createStructure());
+    PVStructurePtr src(pvDataCreate->createPVStructure(type));
+    PVDoubleArrayPtr value(src->getSubFieldT<PVDoubleArray>("value"));
+    PVDoubleArray::svector data(1024*1024, 1.5);
+    value->replace(freeze(data));
+    PVStringArray::svector names(100, "name");
+    src->getSubFieldT<PVStringArray>("names")->replace(freeze(names));
+    PVDoubleArray::svector sub(1000, 2.5);
+    src->getSubFieldT<PVDoubleArray>("sub.value")->replace(freeze(sub));
+
+    PVStructurePtr dest(pvDataCreate->createPVStructure(type));
+    size_t allocs = counter->allocs, bytes = counter->bytes;
+    dest->copy(*src);
+    testOk(counter->allocs==allocs && counter->bytes==bytes,
+           "no payload copied (%u bytes allocated)", unsigned(counter->bytes-bytes));
+
+    PVDoubleArrayPtr destValue(dest->getSubFieldT<PVDoubleArray>("value"));
+    testOk1(destValue->view().data()==value->view().data());
+    testOk1(dest->getSubFieldT<PVStringArray>("names")->view().data()
+            ==src->getSubFieldT<PVStringArray>("names")->view().data());
+    testOk1(dest->getSubFieldT<PVDoubleArray>("sub.value")->view().data()
+            ==src->getSubFieldT<PVDoubleArray>("sub.value")->view().data());
+    testOk1(*dest==*src);
+
+    // masked copy of the value only
+    PVStructurePtr dest2(pvDataCreate->createPVStructure(type));
+    BitSet mask;
+    mask.set(value->getFieldOffset());
+    dest2->copyUnchecked(*src, mask);
+    testOk1(counter->allocs==allocs && counter->bytes==bytes);
+    testOk1(dest2->getSubFieldT<PVDoubleArray>("value")->view().data()==value->view().data());
+    testOk1(dest2->getSubFieldT<PVDoubleArray>("sub.value")->view().empty());
+
+    // modifying the copy copies once, and leaves the source unchanged
+    PVDoubleArray::svector mod(destValue->reuse());
+    mod[0] = 42.0;
+    destValue->replace(freeze(mod));
+    testOk1(counter->allocs==allocs+1);
+    testOk1(value->view()[0]==1.5 && destValue->view()[0]==42.0);
+    testOk1(*dest!=*src);
+
+    // shared storage does not make NaN equal to itself
+    PVDoubleArray::svector nan(4, std::numeric_limits<double>::quiet_NaN());
+    value->replace(freeze(nan));
+    destValue->copy(*value);
+    testOk1(destValue->view().data()==value->view().data());
+    testOk(*destValue!=*value, "shared NaN array not equal");
+    PVDoubleArray::svector nums(4, 1.0);
+    value->replace(freeze(nums));
+    destValue->copy(*value);
+    testOk1(*destValue==*value);
+
+    // shared structure array elements are equal to themselves, even with NaN
+    StructureConstPtr elem(fieldCreate->createFieldBuilder()->add("x", pvDouble)->createStructure());
+    PVStructureArrayPtr sa(pvDataCreate->createPVStructureArray(elem)),
+                        sb(pvDataCreate->createPVStructureArray(elem));
+    PVStructureArray::svector elems(1, pvDataCreate->createPVStructure(elem));
+    elems[0]->getSubFieldT<PVDouble>("x")->put(std::numeric_limits<double>::quiet_NaN());
+    sa->replace(freeze(elems));
+    sb->copy(*sa);
+    testOk1(*sa==*sb);
+    PVStructureArray::svector other(1, pvDataCreate->createPVStructure(elem));
+    other[0]->getSubFieldT<PVDouble>("x")->put(std::numeric_limits<double>::quiet_NaN());
+    sb->replace(freeze(other));
+    testOk(*sa!=*sb, "different NaN elements not equal");
+
+    ArrayAllocator::set(pvDouble, ArrayAllocator::shared_pointer());
+}
+
+static void testSharedNames()
+{
+    testDiag("Check that field names are shared with the Structure");
+
+    PVStructurePtr a(standardPVField->scalar(pvDouble, alarmTimeStamp));
+    PVStructurePtr b(standardPVField->scalar(pvDouble, alarmTimeStamp));
+    StructureConstPtr type(a->getStructure());
+    StructureConstPtr timeStamp(type->getField<Structure>("timeStamp"));
+
+    testOk1(a->getFieldName().empty());
+    testOk1(a->getSubFieldT("value")->getFieldName()=="value");
+    testOk1(&a->getSubFieldT("alarm")->getFieldName()==&type->getFieldNames()[type->getFieldIndex("alarm")]);
+    testOk1(&a->getSubFieldT("timeStamp.secondsPastEpoch")->getFieldName()
+            ==&timeStamp->getFieldNames()[timeStamp->getFieldIndex("secondsPastEpoch")]);
+    testOk1(a->getSubFieldT("timeStamp.userTag")->getFullName()=="timeStamp.userTag");
+
+    // sub-fields which outlive their structure become top-level fields, keeping their names
+    PVFieldPtr value(a->getSubFieldT("value"));
+    PVStructurePtr ts(a->getSubFieldT<PVStructure>("timeStamp"));
+    a.reset();
+    testOk1(value->getFieldName()=="value" && !value->getParent());
+    testOk1(ts->getSubFieldT("userTag")->getFullName()=="timeStamp.userTag");
+
+    // fields moved to another structure are not taken along when the first is gone
+    PVStructurePtr src(standardPVField->scalar(pvDouble, alarmTimeStamp));
+    src->setTrackChanges(true);
+    StringArray names(1, "p");
+    PVFieldPtrArray fields(1, src->getSubFieldT("alarm"));
+    PVStructurePtr moved(pvDataCreate->createPVStructure(names, fields));
+    src.reset();
+    fields.clear();
+    PVFieldPtr p(moved->getSubField("p"));
+    testOk1(p && p->getFieldName()=="p" && p->getParent()==moved.get());
+    moved->getSubFieldT<PVInt>("p.severity")->put(1);
+    testOk1(moved->getSubFieldT("p.severity")->getFullName()=="p.severity");
+
+    b->setTrackChanges(true);
+    PVDoublePtr tracked(b->getSubFieldT<PVDouble>("value"));
+    b.reset();
+    tracked->put(1.0);
+    testOk(tracked->get()==1.0, "put after the tracking structure is gone");
+}
+
+static void testStringShares()
+{
+    testDiag("Check copy of PVString values");
+
+    const string text("a string which is too long for short string optimization");
+    PVStringPtr a(pvDataCreate->createPVScalar<PVString>());
+    PVStringPtr b(pvDataCreate->createPVScalar<PVString>());
+    testOk1(a->get().empty());
+
+    a->put(text);
+    b->copy(*a);
+    testOk1(b->get()==text);
+    testOk1(*a==*b);
+
+    // each is modified independently
+    a->put("other");
+    testOk1(a->get()=="other" && b->get()==text);
+    b->put("");
+    testOk1(a->get()=="other" && b->get().empty());
+
+    PVStructurePtr src(standardPVField->scalar(pvString, "display"));
+    PVStructurePtr dest(standardPVField->scalar(pvString, "display"));
+    src->getSubFieldT<PVString>("value")->put(text);
+    src->getSubFieldT<PVString>("display.units")->put("mm");
+    dest->copy(*src);
+    testOk1(*src==*dest);
+    src->getSubFieldT<PVString>("value")->put("changed");
+    testOk1(dest->getSubFieldT<PVString>("value")->get()==text);
+
+    // bounded strings are checked
+    ScalarConstPtr boundedType(fieldCreate->createBoundedString(8));
+    PVStringPtr bounded(static_pointer_cast<PVString>(pvDataCreate->createPVScalar(boundedType)));
+    try {
+        bounded->copy(*b);
+        bounded->copy(*a);
+        testPass("copy short strings to bounded");
+        bounded->copy(*pvDataCreate->createPVScalar<PVString>());
+        PVStringPtr c(pvDataCreate->createPVScalar<PVString>());
+        c->put(text);
+        bounded->copy(*c);
+        testFail("copy of long string to bounded");
+    } catch(std::overflow_error& e) {
+        testPass("Expected exception: %s", e.what());
+    }
+    testOk1(bounded->get().empty());
+}
+
 static void testFieldAccess()
 {
     testDiag("Check methods for accessing structure fields");
@@ -649,9 +843,329 @@ static void testFieldAccess()
     }
 }
 
+namespace {
+struct PostCounter : public PostHandler {
+    int count;
+    PostCounter() :count(0) {}
+    virtual void postPut() { count++; }
+};
+
+// keeps the changes of each group
+struct GroupLogger : public GroupPutHandler {
+    std::vector<BitSet> groups;
+    const PVStructure *top;
+    PVDoublePtr putValue; // put once from postGroupPut()
+    GroupLogger() :top(0) {}
+    virtual void postGroupPut(const PVStructure& top, const BitSet& changed)
+    {
+        this->top = &top;
+        groups.push_back(changed);
+        if(putValue) {
+            PVDoublePtr value(putValue);
+            putValue.reset();
+            value->put(-1.0);
+        }
+    }
+};
+
+// appends its name to a log, and optionally removes a handler
+struct PostLogger : public PostHandler {
+    string name;
+    string *log;
+    PVField *field;
+    PostHandlerPtr remove;
+    PostLogger(const string& name, string *log) :name(name), log(log), field(0) {}
+    virtual void postPut()
+    {
+        *log += name;
+        if(remove) {
+            field->removePostHandler(remove);
+            remove.reset();
+        }
+    }
+};
+
+// the only handler of a field, which removes itself
+struct PostRemover : public PostHandler {
+    std::tr1::weak_ptr<PostHandler> self;
+    PVField *field;
+    string *log;
+    PostRemover(PVField *field, string *log) :field(field), log(log) {}
+    virtual ~PostRemover() { *log += "~"; }
+    virtual void postPut()
+    {
+        *log += "R";
+        field->removePostHandler(PostHandlerPtr(self));
+        *log += "r";
+    }
+};
+}
+
+static void testTrackChanges()
+{
+    testDiag("Check change tracking of a top-level structure");
+
+    PVStructurePtr top(standardPVField->scalar(pvDouble, alarmTimeStamp));
+    PVDoublePtr value(top->getSubFieldT<PVDouble>("value"));
+    PVIntPtr severity(top->getSubFieldT<PVInt>("alarm.severity"));
+    PVStringPtr message(top->getSubFieldT<PVString>("alarm.message"));
+    BitSet changed;
+
+    testOk1(!top->isTrackingChanges());
+    value->put(1.0);
+    top->takeChanges(changed);
+    testOk1(changed.isEmpty());
+
+    top->setTrackChanges(true);
+    testOk1(top->isTrackingChanges());
+    value->put(2.0);
+    message->put("HIGH");
+    top->takeChanges(changed);
+    testOk1(changed.cardinality()==2);
+    testOk1(changed.get(value->getFieldOffset()));
+    testOk1(changed.get(message->getFieldOffset()));
+    top->takeChanges(changed);
+    testOk(changed.isEmpty(), "cleared by takeChanges()");
+
+    // copy() of a sub-structure marks each field
+    PVStructurePtr other(standardPVField->scalar(pvDouble, alarmTimeStamp));
+    top->getSubFieldT<PVStructure>("alarm")->copy(*other->getSubFieldT<PVStructure>("alarm"));
+    top->takeChanges(changed);
+    testOk1(changed.cardinality()==3);
+    testOk1(changed.get(severity->getFieldOffset()));
+
+    // deserialize, as a monitor client would
+    other->getSubFieldT<PVDouble>("value")->put(5.0);
+    other->getSubFieldT<PVInt>("alarm.severity")->put(2);
+    BitSet sent;
+    sent.set(value->getFieldOffset());
+    sent.set(severity->getFieldOffset());
+    std::vector<epicsUInt8> bytes;
+    {
+        struct Partial : public Serializable {
+            PVStructurePtr S; BitSet *B;
+            virtual void serialize(ByteBuffer *b, SerializableControl *c) const { S->serialize(b, c, B); }
+            virtual void deserialize(ByteBuffer *b, DeserializableControl *c) { S->deserialize(b, c, B); }
+        } P;
+        P.S = other;
+        P.B = &sent;
+        serializeToVector(&P, EPICS_BYTE_ORDER, bytes);
+        P.S = top;
+        deserializeFromVector(&P, EPICS_BYTE_ORDER, bytes);
+    }
+    testOk1(value->get()==5.0 && severity->get()==2);
+    top->takeChanges(changed);
+    testOk1(changed==sent);
+
+    // works alongside a PostHandler
+    std::tr1::shared_ptr<PostCounter> counter(new PostCounter);
+    value->setPostHandler(counter);
+    value->put(6.0);
+    top->takeChanges(changed);
+    testOk1(counter->count==1 && changed.get(value->getFieldOffset()));
+
+    top->setTrackChanges(false);
+    value->put(7.0);
+    top->takeChanges(changed);
+    testOk1(!top->isTrackingChanges() && changed.isEmpty());
+
+    try {
+        top->getSubFieldT<PVStructure>("alarm")->setTrackChanges(true);
+        testFail("change tracking of a sub-structure");
+    } catch(std::logic_error& e) {
+        testPass("Expected exception: %s", e.what());
+    }
+}
+
+static void testPostHandlers()
+{
+    testDiag("Check several PostHandlers and group puts");
+
+    PVStructurePtr top(standardPVField->scalar(pvDouble, alarmTimeStamp));
+    PVDoublePtr value(top->getSubFieldT<PVDouble>("value"));
+    PVIntPtr severity(top->getSubFieldT<PVInt>("alarm.severity"));
+    string log;
+    std::tr1::shared_ptr<PostLogger> A(new PostLogger("A", &log)),
+                                     B(new PostLogger("B", &log)),
+                                     C(new PostLogger("C", &log));
+
+    value->addPostHandler(A);
+    value->addPostHandler(B);
+    value->addPostHandler(A); // ignored
+    value->put(1.0);
+    testOk(log=="AB", "log \"%s\"", log.c_str());
+
+    try {
+        value->setPostHandler(C);
+        testFail("setPostHandler() with a handler registered");
+    } catch(std::logic_error& e) {
+        testPass("Expected exception: %s", e.what());
+    }
+
+    // a handler removes another while being posted
+    log.clear();
+    value->addPostHandler(C);
+    A->field = value.get();
+    A->remove = B;
+    value->put(2.0);
+    testOk(log=="ABC", "log \"%s\"", log.c_str());
+    log.clear();
+    value->put(3.0);
+    testOk(log=="AC", "log \"%s\"", log.c_str());
+
+    value->removePostHandler(A);
+    value->removePostHandler(C);
+    value->removePostHandler(C); // ignored
+    log.clear();
+    value->put(4.0);
+    testOk1(log.empty());
+    value->setPostHandler(B);
+    value->setPostHandler(B); // same handler is allowed
+    value->put(5.0);
+    testOk(log=="B", "log \"%s\"", log.c_str());
+
+    // the last reference to a handler is dropped while it is being called
+    {
+        std::tr1::shared_ptr<PostRemover> R(new PostRemover(severity.get(), &log));
+        R->self = R;
+        severity->addPostHandler(R);
+    }
+    log.clear();
+    severity->put(2);
+    testOk(log=="Rr~", "log \"%s\"", log.c_str());
+    log.clear();
+    severity->put(0);
+    testOk1(log.empty());
+
+    // notified once per field, at the end of the outermost group
+    severity->addPostHandler(A);
+    log.clear();
+    top->setTrackChanges(true);
+    top->beginGroupPut();
+    value->put(6.0);
+    top->beginGroupPut();
+    severity->put(1);
+    value->put(7.0);
+    top->endGroupPut();
+    testOk1(log.empty());
+    BitSet changed;
+    top->takeChanges(changed);
+    testOk(changed.isEmpty(), "change tracking deferred");
+    top->endGroupPut();
+    testOk(log=="BA", "log \"%s\"", log.c_str());
+    top->takeChanges(changed);
+    testOk1(changed.cardinality()==2);
+
+    log.clear();
+    top->beginGroupPut();
+    top->endGroupPut();
+    value->put(8.0);
+    testOk(log=="B", "log \"%s\"", log.c_str());
+
+    try {
+        top->endGroupPut();
+        testFail("endGroupPut() without beginGroupPut()");
+    } catch(std::logic_error& e) {
+        testPass("Expected exception: %s", e.what());
+    }
+    try {
+        top->getSubFieldT<PVStructure>("alarm")->beginGroupPut();
+        testFail("group put of a sub-structure");
+    } catch(std::logic_error& e) {
+        testPass("Expected exception: %s", e.what());
+    }
+}
+
+static void testGroupPutHandlers()
+{
+    testDiag("Check GroupPutHandlers");
+
+    PVStructurePtr top(standardPVField->scalar(pvDouble, alarmTimeStamp));
+    PVDoublePtr value(top->getSubFieldT<PVDouble>("value"));
+    PVIntPtr severity(top->getSubFieldT<PVInt>("alarm.severity"));
+    PVLongPtr seconds(top->getSubFieldT<PVLong>("timeStamp.secondsPastEpoch"));
+    std::tr1::shared_ptr<GroupLogger> G(new GroupLogger), H(new GroupLogger);
+    string log;
+    std::tr1::shared_ptr<PostLogger> A(new PostLogger("A", &log));
+    value->addPostHandler(A);
+
+    top->addGroupPutHandler(G);
+    top->addGroupPutHandler(G); // ignored
+
+    // a put outside of a group is a group of one
+    value->put(1.0);
+    testOk1(G->groups.size()==1 && G->top==top.get());
+    testOk1(G->groups.size()==1 && G->groups[0].cardinality()==1
+            && G->groups[0].get(value->getFieldOffset()));
+    testOk(log=="A", "log \"%s\"", log.c_str());
+
+    // one notification for a group, with all changes
+    G->groups.clear();
+    log.clear();
+    top->beginGroupPut();
+    value->put(2.0);
+    severity->put(1);
+    seconds->put(1234);
+    value->put(3.0);
+    testOk1(G->groups.empty() && log.empty());
+    top->endGroupPut();
+    testOk1(G->groups.size()==1);
+    BitSet expect;
+    expect.set(value->getFieldOffset());
+    expect.set(severity->getFieldOffset());
+    expect.set(seconds->getFieldOffset());
+    testOk1(G->groups.size()==1 && G->groups[0]==expect);
+    testOk(log=="A", "log \"%s\"", log.c_str());
+
+    // with change tracking, and a handler which puts
+    top->setTrackChanges(true);
+    top->addGroupPutHandler(H);
+    G->groups.clear();
+    G->putValue = value;
+    top->beginGroupPut();
+    severity->put(2);
+    top->endGroupPut();
+    testOk(G->groups.size()==2 && H->groups.size()==2, "put by handler is a new group");
+    BitSet changed;
+    top->takeChanges(changed);
+    testOk1(changed.cardinality()==2);
+
+    // empty group
+    G->groups.clear();
+    top->beginGroupPut();
+    top->endGroupPut();
+    testOk1(G->groups.empty());
+
+    // deserialize is recorded, one group per leaf field unless grouped
+    std::vector<epicsUInt8> bytes;
+    serializeToVector(standardPVField->scalar(pvDouble, alarmTimeStamp).get(), EPICS_BYTE_ORDER, bytes);
+    deserializeFromVector(top.get(), EPICS_BYTE_ORDER, bytes);
+    testOk(G->groups.size()==7, "%u groups", (unsigned)G->groups.size());
+    G->groups.clear();
+    top->beginGroupPut();
+    deserializeFromVector(top.get(), EPICS_BYTE_ORDER, bytes);
+    top->endGroupPut();
+    testOk1(G->groups.size()==1 && G->groups[0].cardinality()==7);
+
+    top->removeGroupPutHandler(G);
+    top->removeGroupPutHandler(H);
+    top->removeGroupPutHandler(H); // ignored
+    top->setTrackChanges(false);
+    G->groups.clear();
+    value->put(4.0);
+    testOk1(G->groups.empty());
+
+    try {
+        top->getSubFieldT<PVStructure>("alarm")->addGroupPutHandler(G);
+        testFail("GroupPutHandler of a sub-structure");
+    } catch(std::logic_error& e) {
+        testPass("Expected exception: %s", e.what());
+    }
+}
+
 MAIN(testPVData)
 {
-    testPlan(243);
+    testPlan(322);
     fieldCreate = getFieldCreate();
     pvDataCreate = getPVDataCreate();
     standardField = getStandardField();
@@ -663,7 +1177,13 @@ MAIN(testPVData)
     testScalarArray();
     testRequest();
     testCopy();
+    testCopyShares();
+    testSharedNames();
+    testStringShares();
     testFieldAccess();
+    testTrackChanges();
+    testPostHandlers();
+    testGroupPutHandlers();
     return testDone();
 }
 
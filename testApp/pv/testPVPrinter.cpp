@@ -0,0 +1,252 @@
+/* testPVPrinter.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <sstream>
+#include <limits>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/pvData.h>
+#include <pv/pvPrinter.h>
+#include <pv/standardField.h>
+#include <pv/standardPVField.h>
+#include <pv/convert.h>
+
+using namespace epics::pvData;
+using std::string;
+
+namespace {
+
+string streamed(const PVField& field)
+{
+    std::ostringstream strm;
+    strm << field;
+    return strm.str();
+}
+
+void testSame(const PVField& field, const char *msg)
+{
+    string expect(streamed(field)), actual(PVPrinter().toString(field));
+    testOk(expect==actual, "%s", msg);
+    if(expect!=actual)
+        testDiag("expect\n%s\nactual\n%s", expect.c_str(), actual.c_str());
+}
+
+void testEqual(const string& actual, const char *expect)
+{
+    testOk(actual==expect, "\"%s\" == \"%s\"", actual.c_str(), expect);
+}
+
+StructureConstPtr everything()
+{
+    return getFieldCreate()->createFieldBuilder()
+            ->setId("epics:test/Everything:1.0")
+            ->add("b", pvBoolean)
+            ->add("i8", pvByte)
+            ->add("u8", pvUByte)
+            ->add("i16", pvShort)
+            ->add("u16", pvUShort)
+            ->add("i32", pvInt)
+            ->add("u32", pvUInt)
+            ->add("i64", pvLong)
+            ->add("u64", pvULong)
+            ->add("f", pvFloat)
+            ->add("d", pvDouble)
+            ->add("s", pvString)
+            ->addArray("bs", pvBoolean)
+            ->addArray("i8s", pvByte)
+            ->addArray("u8s", pvUByte)
+            ->addArray("ds", pvDouble)
+            ->addArray("ss", pvString)
+            ->addNestedStructure("sub")
+                ->add("x", pvInt)
+                ->addNestedStructure("deeper")
+                    ->add("y", pvString)
+                ->endNested()
+            ->endNested()
+            ->addNestedUnion("choice")
+                ->add("i", pvInt)
+                ->addArray("a", pvDouble)
+            ->endNested()
+            ->add("any", getFieldCreate()->createVariantUnion())
+            ->addNestedStructureArray("table")
+                ->add("name", pvString)
+            ->endNested()
+            ->addNestedUnionArray("unions")
+                ->add("i", pvInt)
+                ->add("s", pvString)
+            ->endNested()
+            ->createStructure();
+}
+
+PVStructurePtr filled()
+{
+    PVStructurePtr V(getPVDataCreate()->createPVStructure(everything()));
+    V->getSubFieldT<PVBoolean>("b")->put(true);
+    V->getSubFieldT<PVByte>("i8")->put(-5);
+    V->getSubFieldT<PVUByte>("u8")->put(200);
+    V->getSubFieldT<PVShort>("i16")->put(-1234);
+    V->getSubFieldT<PVUShort>("u16")->put(65535);
+    V->getSubFieldT<PVInt>("i32")->put(-123456789);
+    V->getSubFieldT<PVUInt>("u32")->put(4000000000u);
+    V->getSubFieldT<PVLong>("i64")->put(-1234567890123ll);
+    V->getSubFieldT<PVULong>("u64")->put(12345678901234567ull);
+    V->getSubFieldT<PVFloat>("f")->put(1.5e-7f);
+    V->getSubFieldT<PVDouble>("d")->put(3.14159265358979);
+    V->getSubFieldT<PVString>("s")->put("hello \"world\"\n");
+
+    PVBooleanArray::svector bs(2);
+    bs[0] = true;
+    bs[1] = false;
+    V->getSubFieldT<PVBooleanArray>("bs")->replace(freeze(bs));
+    PVByteArray::svector i8s(3);
+    i8s[0] = -1; i8s[1] = 0; i8s[2] = 65;
+    V->getSubFieldT<PVByteArray>("i8s")->replace(freeze(i8s));
+    PVUByteArray::svector u8s(2, 255);
+    V->getSubFieldT<PVUByteArray>("u8s")->replace(freeze(u8s));
+    PVDoubleArray::svector ds(5);
+    for(size_t i=0; i<ds.size(); i++)
+        ds[i] = 0.1*i - 1e10*(i==4);
+    V->getSubFieldT<PVDoubleArray>("ds")->replace(freeze(ds));
+    PVStringArray::svector ss(2);
+    ss[0] = "one";
+    ss[1] = "two words";
+    V->getSubFieldT<PVStringArray>("ss")->replace(freeze(ss));
+
+    V->getSubFieldT<PVInt>("sub.x")->put(42);
+    V->getSubFieldT<PVString>("sub.deeper.y")->put("why");
+
+    V->getSubFieldT<PVUnion>("choice")->select<PVInt>("i")->put(7);
+
+    PVStructureArrayPtr table(V->getSubFieldT<PVStructureArray>("table"));
+    PVStructureArray::svector rows(3);
+    rows[0] = getPVDataCreate()->createPVStructure(table->getStructureArray()->getStructure());
+    rows[0]->getSubFieldT<PVString>("name")->put("first");
+    rows[2] = getPVDataCreate()->createPVStructure(table->getStructureArray()->getStructure());
+    table->replace(freeze(rows));
+
+    PVUnionArrayPtr unions(V->getSubFieldT<PVUnionArray>("unions"));
+    PVUnionArray::svector elems(2);
+    elems[0] = getPVDataCreate()->createPVUnion(unions->getUnionArray()->getUnion());
+    elems[0]->select<PVString>("s")->put("sel");
+    elems[1] = getPVDataCreate()->createPVUnion(unions->getUnionArray()->getUnion());
+    unions->replace(freeze(elems));
+    return V;
+}
+
+} // namespace
+
+static void testText()
+{
+    testDiag("testText");
+    PVStructurePtr V(filled());
+    testSame(*V, "everything");
+    testSame(*getPVDataCreate()->createPVStructure(everything()), "everything, default values");
+    testSame(*V->getSubFieldT<PVStructure>("sub"), "sub-structure");
+    testSame(*V->getSubFieldT<PVUnion>("choice"), "union");
+    testSame(*V->getSubFieldT<PVUnion>("any"), "empty variant union");
+    testSame(*V->getSubFieldT<PVStructureArray>("table"), "structure array");
+    testSame(*V->getSubFieldT<PVUnionArray>("unions"), "union array");
+    testSame(*getStandardPVField()->scalar(pvDouble, "alarm,timeStamp,display,control,valueAlarm"),
+             "NTScalar");
+
+    testEqual(PVPrinter().toString(*V->getSubFieldT<PVByte>("i8")), "-5");
+    testEqual(PVPrinter().toString(*V->getSubFieldT<PVUByte>("u8")), "200");
+    testEqual(PVPrinter().toString(*V->getSubFieldT<PVBoolean>("b")), "true");
+    testEqual(PVPrinter().toString(*V->getSubFieldT<PVByteArray>("i8s")), "[-1,0,65]");
+
+    // appends
+    string buf("prefix ");
+    PVPrinter().print(buf, *V->getSubFieldT<PVInt>("sub.x"));
+    testEqual(buf, "prefix 42");
+
+    std::ostringstream strm;
+    PVPrinter().print(strm, *V->getSubFieldT<PVInt>("sub.x"));
+    testEqual(strm.str(), "42");
+
+    testEqual(PVPrinter().indent(1).toString(*V->getSubFieldT<PVStructure>("sub.deeper")),
+              "    structure deeper\n        string y why\n");
+
+    string conv;
+    getConvert()->getString(&conv, V);
+    testOk1(conv==streamed(*V)+"\n");
+}
+
+static void testLimits()
+{
+    testDiag("testLimits");
+    PVStructurePtr V(filled());
+    PVPrinter P;
+    P.maxArrayElements(2);
+
+    testEqual(P.toString(*V->getSubFieldT<PVDoubleArray>("ds")), "[0,0.1,...]");
+    testEqual(P.toString(*V->getSubFieldT<PVStringArray>("ss")), "[one,two words]");
+    testEqual(P.toString(*V->getSubFieldT<PVStructureArray>("table")),
+              "structure[] table\n"
+              "    structure \n"
+              "        string name first\n"
+              "    (none)\n"
+              "    ...\n");
+    testEqual(PVPrinter().maxArrayElements(0).toString(*V->getSubFieldT<PVDoubleArray>("ds")),
+              "[0,0.1,0.2,0.3,-1e+10]");
+
+    P = PVPrinter().maxDepth(1);
+    testEqual(P.toString(*V->getSubFieldT<PVStructure>("sub")),
+              "structure sub\n"
+              "    int x 42\n"
+              "    structure deeper\n"
+              "        ...\n");
+    testEqual(P.toString(*V->getSubFieldT<PVUnion>("choice")),
+              "union choice\n"
+              "    int  7\n"); // selected member has no field name
+    testEqual(PVPrinter().maxDepth(1).format(PVPrinter::json)
+              .toString(*V->getSubFieldT<PVStructure>("sub")),
+              "{\"x\":42,\"deeper\":{}}");
+}
+
+static void testJSON()
+{
+    testDiag("testJSON");
+    PVStructurePtr V(filled());
+    PVPrinter P;
+    P.format(PVPrinter::json);
+
+    testEqual(P.toString(*V),
+              "{\"b\":true,\"i8\":-5,\"u8\":200,\"i16\":-1234,\"u16\":65535,"
+              "\"i32\":-123456789,\"u32\":4000000000,\"i64\":-1234567890123,"
+              "\"u64\":12345678901234567,\"f\":1.50000005e-07,\"d\":3.14159265358979,"
+              "\"s\":\"hello \\\"world\\\"\\n\",\"bs\":[true,false],\"i8s\":[-1,0,65],"
+              "\"u8s\":[255,255],\"ds\":[0,0.10000000000000001,0.20000000000000001,"
+              "0.30000000000000004,-9999999999.6000004],\"ss\":[\"one\",\"two words\"],"
+              "\"sub\":{\"x\":42,\"deeper\":{\"y\":\"why\"}},\"choice\":7,\"any\":null,"
+              "\"table\":[{\"name\":\"first\"},null,{\"name\":\"\"}],"
+              "\"unions\":[\"sel\",null]}");
+
+    PVDoublePtr d(getPVDataCreate()->createPVScalar<PVDouble>());
+    d->put(std::numeric_limits<double>::quiet_NaN());
+    testEqual(P.toString(*d), "null");
+    d->put(-std::numeric_limits<double>::infinity());
+    testEqual(P.toString(*d), "null");
+    d->put(0.1);
+    testEqual(P.toString(*d), "0.10000000000000001");
+
+    PVStringPtr s(getPVDataCreate()->createPVScalar<PVString>());
+    s->put(string("a\\b\t\x01\x1f/", 7));
+    testEqual(P.toString(*s), "\"a\\\\b\\t\\u0001\\u001f/\"");
+
+    testEqual(PVPrinter().format(PVPrinter::json).maxArrayElements(1)
+              .toString(*V->getSubFieldT<PVStringArray>("ss")), "[\"one\"]");
+}
+
+MAIN(testPVPrinter)
+{
+    testPlan(29);
+    testText();
+    testLimits();
+    testJSON();
+    return testDone();
+}
@@ -20,6 +20,8 @@
 #include <pv/pvIntrospect.h>
 #include <pv/pvData.h>
 #include <pv/convert.h>
+#include <pv/pvSubArrayCopy.h>
+#include <pv/arrayKernels.h>
 #include <pv/standardField.h>
 #include <pv/standardPVField.h>
 
@@ -197,11 +199,141 @@ static void testVoid()
     testOk1(iarr->getLength()==4);
 }
 
+static void testSubArrayCopy()
+{
+    testDiag("Check pvSubArrayCopy");
+
+    PVIntArrayPtr from = static_pointer_cast<PVIntArray>(getPVDataCreate()->createPVScalarArray(pvInt));
+    PVIntArrayPtr to = static_pointer_cast<PVIntArray>(getPVDataCreate()->createPVScalarArray(pvInt));
+
+    PVIntArray::svector fdata(10);
+    for(size_t i=0; i<fdata.size(); i++)
+        fdata[i] = int32(i);
+    from->replace(freeze(fdata));
+
+    // every other element of from into elements 1-5 of an empty array
+    copy(*from, 0, 2, *to, 1, 1, 5);
+    {
+        PVIntArray::const_svector result(to->view());
+        testOk1(result.size()==6);
+        testOk1(result.size()==6 && result[0]==0 && result[1]==0 && result[2]==2 && result[5]==8);
+    }
+
+    // again with stride in the destination, in place as to is not shared
+    const void *before = to->view().dataPtr().get();
+    copy(*from, 1, 1, *to, 0, 2, 3);
+    {
+        PVIntArray::const_svector result(to->view());
+        testOk1(result.size()==6);
+        testOk1(result.size()==6 && result[0]==1 && result[1]==0 && result[2]==2
+                && result[3]==4 && result[4]==3 && result[5]==8);
+        testOk1(result.dataPtr().get()==before);
+    }
+
+    // a reference held elsewhere is not modified
+    PVIntArray::const_svector held(to->view());
+    copy(*from, 9, 1, *to, 0, 1, 1);
+    testOk1(to->view()[0]==9);
+    testOk1(held[0]==1);
+
+    // copy onto itself
+    copy(*to, 0, 1, *to, 1, 1, 5);
+    {
+        PVIntArray::const_svector result(to->view());
+        testOk1(result.size()==6 && result[0]==9 && result[1]==9 && result[2]==0 && result[5]==3);
+    }
+
+    // a failed copy leaves the destination unchanged
+    PVIntArrayPtr bounded = static_pointer_cast<PVIntArray>(getPVDataCreate()->createPVScalarArray(
+                getFieldCreate()->createBoundedScalarArray(pvInt, 4)));
+    PVIntArray::svector bdata(2, 7);
+    bounded->replace(freeze(bdata));
+    try {
+        copy(*from, 0, 1, *bounded, 0, 1, 5);
+        testFail("Expected exception");
+    } catch(std::invalid_argument& e) {
+        testPass("Expected exception: %s", e.what());
+    }
+    testOk1(bounded->getLength()==2 && bounded->view()[1]==7);
+}
+
+// compare with the element by element definition of copy()
+template<typename PVT>
+bool checkStridedCopy(size_t n, size_t fromOffset, size_t fromStride,
+                      size_t toOffset, size_t toStride, size_t count)
+{
+    typedef typename PVT::value_type value_type;
+    std::tr1::shared_ptr<PVT> from(getPVDataCreate()->createPVScalarArray<PVT>());
+    std::tr1::shared_ptr<PVT> to(getPVDataCreate()->createPVScalarArray<PVT>());
+    typename PVT::svector fdata(n), tdata(n/2);
+    for(size_t i=0; i<n; i++)
+        fdata[i] = castUnsafe<value_type>(uint32(i%251 + 1));
+    for(size_t i=0; i<tdata.size(); i++)
+        tdata[i] = castUnsafe<value_type>(uint32(i%7 + 1));
+    from->replace(freeze(fdata));
+    to->replace(freeze(tdata));
+    typename PVT::const_svector src(from->view()), orig(to->view());
+
+    copy(*from, fromOffset, fromStride, *to, toOffset, toStride, count);
+
+    typename PVT::const_svector result(to->view());
+    size_t length = std::max(orig.size(), toOffset + count*toStride);
+    if(result.size()!=length) {
+        testDiag("length %u != %u", (unsigned)result.size(), (unsigned)length);
+        return false;
+    }
+    for(size_t i=0; i<length; i++) {
+        value_type expect = i<orig.size() ? orig[i] : value_type();
+        if(i>=toOffset && (i-toOffset)%toStride==0 && (i-toOffset)/toStride<count)
+            expect = src[fromOffset + (i-toOffset)/toStride*fromStride];
+        if(result[i]!=expect) {
+            testDiag("[%u] differs", (unsigned)i);
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename PVT>
+void testStridedCopyType(const char *name)
+{
+    bool ok = true;
+    for(size_t fs=1; fs<=5; fs++) {
+        for(size_t ts=1; ts<=3; ts++) {
+            ok &= checkStridedCopy<PVT>(1000, 3, fs, 0, ts, 997/fs/ts);
+            ok &= checkStridedCopy<PVT>(1000, 0, fs, 700, ts, 17);
+            ok &= checkStridedCopy<PVT>(1000, 1, fs, 100, ts, 150/ts);
+        }
+    }
+    testOk(ok, "strided copy %s", name);
+}
+
+static void testStridedCopy()
+{
+    testDiag("Check pvSubArrayCopy strides");
+    testStridedCopyType<PVBooleanArray>("boolean");
+    testStridedCopyType<PVByteArray>("byte");
+    testStridedCopyType<PVUShortArray>("ushort");
+    testStridedCopyType<PVIntArray>("int");
+    testStridedCopyType<PVFloatArray>("float");
+    testStridedCopyType<PVDoubleArray>("double");
+    testStridedCopyType<PVStringArray>("string");
+
+    testOk1(checkStridedCopy<PVDoubleArray>(10, 0, 1, 0, 1, 0));
+
+    // large copies split across threads
+    ArrayKernels::setParallel(3, 1000);
+    testOk1(checkStridedCopy<PVUShortArray>(100000, 5, 1, 10, 1, 99990));
+    testOk1(checkStridedCopy<PVUShortArray>(100000, 0, 3, 0, 1, 33333));
+    testOk1(checkStridedCopy<PVDoubleArray>(100000, 1, 2, 7, 2, 20000));
+    ArrayKernels::setParallel(1);
+}
+
 } // end namespace
 
 MAIN(testPVScalarArray)
 {
-    testPlan(158);
+    testPlan(179);
     testFactory();
     testBasic<PVByteArray>();
     testBasic<PVUByteArray>();
@@ -210,5 +342,7 @@ MAIN(testPVScalarArray)
     testBasic<PVStringArray>();
     testShare();
     testVoid();
+    testSubArrayCopy();
+    testStridedCopy();
     return testDone();
 }
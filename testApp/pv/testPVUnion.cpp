@@ -10,12 +10,14 @@
 #include <cstddef>
 #include <string>
 #include <cstdio>
+#include <vector>
 
 #include <epicsUnitTest.h>
 #include <testMain.h>
 
 #include <pv/pvIntrospect.h>
 #include <pv/pvData.h>
+#include <pv/bitSet.h>
 #include <pv/standardField.h>
 #include <pv/standardPVField.h>
 #include <pv/timeStamp.h>
@@ -111,12 +113,204 @@ static void testPVUnionArray()
     std::cout << "testPVUnionArray PASSED" << std::endl;
 }
 
+namespace {
+struct Flusher : public SerializableControl {
+    virtual ~Flusher() {}
+    virtual void flushSerializeBuffer() {}
+    virtual void ensureBuffer(std::size_t) {}
+    virtual void alignBuffer(std::size_t) {}
+    virtual bool directSerialize(ByteBuffer*, const char*, std::size_t, std::size_t) { return false; }
+    virtual void cachedSerialize(std::tr1::shared_ptr<const Field> const & field, ByteBuffer* buffer)
+    { field->serialize(buffer, this); }
+};
+struct Control : public DeserializableControl {
+    virtual ~Control() {}
+    virtual void ensureData(std::size_t) {}
+    virtual void alignData(std::size_t) {}
+    virtual bool directDeserialize(ByteBuffer*, char*, std::size_t, std::size_t) { return false; }
+    virtual std::tr1::shared_ptr<const Field> cachedDeserialize(ByteBuffer* buffer)
+    { return fieldCreate->deserialize(buffer, this); }
+};
+}
+
+// serialize from into to
+static void transfer(const PVUnion& from, PVUnion& to)
+{
+    std::vector<char> bytes(1024);
+    ByteBuffer buffer(&bytes[0], bytes.size());
+    Flusher flusher;
+    from.serialize(&buffer, &flusher);
+    buffer.flip();
+    Control control;
+    to.deserialize(&buffer, &control);
+}
+
+namespace {
+struct PostCounter : public PostHandler {
+    int count;
+    PostCounter() :count(0) {}
+    virtual void postPut() { count++; }
+};
+struct GroupPutCounter : public GroupPutHandler {
+    int count;
+    GroupPutCounter() :count(0) {}
+    virtual void postGroupPut(const PVStructure&, const BitSet&) { count++; }
+};
+}
+
+static void testMemberCache()
+{
+    testDiag("testMemberCache");
+    UnionConstPtr type(fieldCreate->createFieldBuilder()->
+                       add("doubleValue", pvDouble)->
+                       add("intValue", pvInt)->
+                       addArray("ubyteValue", pvUByte)->
+                       createUnion());
+    PVUnionPtr pvValue(pvDataCreate->createPVUnion(type));
+
+    std::tr1::weak_ptr<PVField> first(pvValue->select(0));
+    pvValue->select(1);
+    testOk(!first.expired(), "member kept");
+    PVFieldPtr reselected(pvValue->select(0));
+    testOk(reselected==first.lock(), "member re-used on reselect");
+    reselected.reset();
+
+    // a re-used member has the value of a new one
+    pvValue->select<PVInt>(1)->put(7);
+    pvValue->select(0);
+    testOk1(pvValue->select<PVInt>(1)->get()==0);
+    pvValue->select(0);
+
+    // a member held elsewhere is not re-used
+    PVDoublePtr held(pvValue->get<PVDouble>());
+    held->put(1.5);
+    pvValue->select(1);
+    testOk1(pvValue->select<PVDouble>(0).get()!=held.get());
+    testOk1(held->get()==1.5);
+    held.reset();
+
+    // cached members hold no array values
+    PVUByteArray::svector arr(1000, 7);
+    PVUByteArray::const_svector data(freeze(arr));
+    pvValue->select<PVUByteArray>(2)->replace(data);
+    pvValue->select(0);
+    testOk(data.unique(), "array released");
+    testOk1(pvValue->select<PVUByteArray>(2)->getLength()==0);
+
+    // deserialize
+    PVUnionPtr other(pvDataCreate->createPVUnion(type));
+    other->select<PVInt>(1)->put(42);
+    transfer(*other, *pvValue);
+    PVField *intMember = pvValue->get().get();
+    testOk1(pvValue->get<PVInt>()->get()==42);
+    other->select<PVDouble>(0)->put(2.5);
+    transfer(*other, *pvValue);
+    testOk1(pvValue->get<PVDouble>()->get()==2.5);
+    other->select<PVInt>(1)->put(43);
+    transfer(*other, *pvValue);
+    testOk(pvValue->get().get()==intMember, "member re-used by deserialize");
+    testOk1(pvValue->get<PVInt>()->get()==43);
+
+    // variant unions, by Field identity
+    PVUnionPtr variant(pvDataCreate->createPVUnion(fieldCreate->createVariantUnion())),
+               source(pvDataCreate->createPVUnion(fieldCreate->createVariantUnion()));
+    PVDoublePtr dval(pvDataCreate->createPVScalar<PVDouble>());
+    PVStringPtr sval(pvDataCreate->createPVScalar<PVString>());
+    dval->put(3.5);
+    sval->put("hello");
+    source->set(dval);
+    transfer(*source, *variant);
+    PVField *doubleMember = variant->get().get();
+    source->set(sval);
+    transfer(*source, *variant);
+    testOk1(variant->get<PVString>()->get()=="hello");
+    source->set(dval);
+    variant->copyUnchecked(*source);
+    testOk(variant->get().get()==doubleMember, "variant member re-used by copy");
+    testOk1(variant->get<PVDouble>()->get()==3.5);
+
+    // the checks apply to sub-fields of a member as well
+    PVUnionPtr waveforms(pvDataCreate->createPVUnion(
+                             fieldCreate->createFieldBuilder()->
+                             add("doubleValue", pvDouble)->
+                             addNestedStructure("waveform")->
+                                 addArray("value", pvDouble)->
+                                 add("count", pvInt)->
+                                 add("units", pvString)->
+                                 endNested()->
+                             createUnion()));
+    PVStructurePtr waveform(waveforms->select<PVStructure>(1));
+    std::tr1::shared_ptr<PostCounter> counter(new PostCounter);
+    waveform->getSubFieldT<PVDoubleArray>("value")->addPostHandler(counter);
+    PVDoubleArray::svector samples(10, 1.0);
+    waveform->getSubFieldT<PVDoubleArray>("value")->replace(freeze(samples));
+    std::tr1::weak_ptr<PVField> member(waveform);
+    waveform.reset();
+    waveforms->select(0);
+    testOk(member.expired(), "not kept with a PostHandler on a sub-field");
+    testOk1(counter->count==1);
+
+    waveform = waveforms->select<PVStructure>(1);
+    PVIntPtr count(waveform->getSubFieldT<PVInt>("count"));
+    member = waveform;
+    waveform.reset();
+    waveforms->select(0);
+    testOk(member.expired(), "not kept with a sub-field held elsewhere");
+    count.reset();
+
+    waveform = waveforms->select<PVStructure>(1);
+    waveform->setTrackChanges(true);
+    member = waveform;
+    waveform.reset();
+    waveforms->select(0);
+    testOk(member.expired(), "not kept while tracking changes");
+
+    waveform = waveforms->select<PVStructure>(1);
+    std::tr1::shared_ptr<GroupPutCounter> group(new GroupPutCounter);
+    waveform->addGroupPutHandler(group);
+    member = waveform;
+    waveform.reset();
+    waveforms->select(0);
+    testOk(member.expired(), "not kept with a GroupPutHandler");
+
+    waveform = waveforms->select<PVStructure>(1);
+    waveform->beginGroupPut();
+    member = waveform;
+    waveform.reset();
+    waveforms->select(0);
+    testOk(member.expired(), "not kept during a group put");
+
+    waveform = waveforms->select<PVStructure>(1);
+    samples.resize(10);
+    waveform->getSubFieldT<PVDoubleArray>("value")->replace(freeze(samples));
+    waveform->getSubFieldT<PVInt>("count")->put(10);
+    waveform->getSubFieldT<PVString>("units")->put("V");
+    member = waveform;
+    waveform.reset();
+    waveforms->select(0);
+    waveform = waveforms->select<PVStructure>(1);
+    testOk(waveform==member.lock(), "member re-used");
+    testOk1(waveform->getSubFieldT<PVDoubleArray>("value")->getLength()==0);
+    testOk1(waveform->getSubFieldT<PVInt>("count")->get()==0);
+    testOk1(waveform->getSubFieldT<PVString>("units")->get().empty());
+    testOk1(!waveform->isTrackingChanges());
+    waveform->getSubFieldT<PVInt>("count")->put(1);
+    testOk(group->count==0, "no GroupPutHandler");
+
+    size_t limit = PVUnion::memberCacheSize();
+    PVUnion::setMemberCacheSize(0);
+    first = pvValue->select(0);
+    pvValue->select(1);
+    testOk(first.expired(), "not kept without cache");
+    PVUnion::setMemberCacheSize(limit);
+}
 
 MAIN(testPVUnion)
 {
-    testPlan(6);
+    testPlan(33);
     testPVUnionType();
     testPVUnionArray();
+    testMemberCache();
     return testDone();
 }
 
@@ -0,0 +1,207 @@
+/* testSerializedUpdate.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <vector>
+#include <stdexcept>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/pvData.h>
+#include <pv/standardPVField.h>
+#include <pv/pvSerializedUpdate.h>
+
+using namespace epics::pvData;
+using std::string;
+
+namespace {
+
+/* A connection's send buffer.  Small, so that appends are split,
+ * and flushed to 'sent'.
+ */
+struct Sender : public SerializableControl
+{
+    std::vector<char> scratch;
+    ByteBuffer buffer;
+    std::vector<char> sent;
+    bool direct;
+    size_t ndirect;
+
+    Sender(int byteOrder, size_t size = 64, bool direct = false)
+        :scratch(size)
+        ,buffer(&scratch[0], scratch.size(), byteOrder)
+        ,direct(direct)
+        ,ndirect(0)
+    {}
+    virtual ~Sender() {}
+
+    virtual void flushSerializeBuffer()
+    {
+        sent.insert(sent.end(), buffer.getBuffer(), buffer.getBuffer()+buffer.getPosition());
+        buffer.clear();
+    }
+    virtual void ensureBuffer(std::size_t size) { flushSerializeBuffer(); }
+    virtual void alignBuffer(std::size_t alignment) { buffer.align(alignment); }
+    virtual bool directSerialize(ByteBuffer *existingBuffer, const char* toSerialize,
+                                 std::size_t elementCount, std::size_t elementSize)
+    {
+        if(!direct)
+            return false;
+        flushSerializeBuffer();
+        sent.insert(sent.end(), toSerialize, toSerialize+elementCount*elementSize);
+        ndirect++;
+        return true;
+    }
+    virtual void cachedSerialize(std::tr1::shared_ptr<const Field> const & field, ByteBuffer* buffer)
+    {
+        field->serialize(buffer, this);
+    }
+
+    const std::vector<char>& done() { flushSerializeBuffer(); return sent; }
+};
+
+// what each connection would send without SerializedUpdate
+std::vector<char> reference(const PVStructure& value, BitSet& changed, const BitSet& overrun, int byteOrder)
+{
+    Sender S(byteOrder);
+    changed.serialize(&S.buffer, &S);
+    value.serialize(&S.buffer, &S, &changed);
+    overrun.serialize(&S.buffer, &S);
+    return S.done();
+}
+
+PVStructurePtr makeValue()
+{
+    PVStructurePtr value(getStandardPVField()->scalarArray(pvDouble, "alarm,timeStamp"));
+    PVDoubleArray::svector arr(100);
+    for(size_t i=0; i<arr.size(); i++)
+        arr[i] = i*0.5;
+    value->getSubFieldT<PVDoubleArray>("value")->replace(freeze(arr));
+    value->getSubFieldT<PVInt>("alarm.severity")->put(2);
+    value->getSubFieldT<PVString>("alarm.message")->put("HIGH");
+    return value;
+}
+
+void testMatch(int byteOrder, const char *name)
+{
+    testDiag("testMatch %s", name);
+    PVStructurePtr value(makeValue());
+    BitSet changed, overrun, none;
+    changed.set(value->getSubFieldT<PVField>("value")->getFieldOffset());
+    changed.set(value->getSubFieldT<PVField>("alarm")->getFieldOffset());
+    overrun.set(value->getSubFieldT<PVField>("value")->getFieldOffset());
+
+    SerializedUpdate update(*value, changed, overrun, byteOrder);
+    testOk1(update.getByteOrder()==byteOrder);
+
+    std::vector<char> expect(reference(*value, changed, overrun, byteOrder)),
+                      expectNone(reference(*value, changed, none, byteOrder));
+
+    {
+        Sender S(byteOrder);
+        update.serialize(&S.buffer, &S, true);
+        testOk(S.done()==expect, "overrun matches");
+        testOk1(update.size(true)==expect.size());
+    }
+    {
+        Sender S(byteOrder);
+        update.serialize(&S.buffer, &S, false);
+        testOk(S.done()==expectNone, "up to date matches");
+        testOk1(update.size(false)==expectNone.size());
+    }
+    {
+        Sender S(byteOrder, 64, true);
+        update.serialize(&S.buffer, &S, true);
+        testOk(S.done()==expect, "direct matches");
+        testOk(S.ndirect==1, "directSerialize() used for large block");
+    }
+    {
+        // several updates appended to one buffer
+        Sender S(byteOrder, 4096);
+        update.serialize(&S.buffer, &S, true);
+        update.serialize(&S.buffer, &S, false);
+        std::vector<char> both(expect);
+        both.insert(both.end(), expectNone.begin(), expectNone.end());
+        testOk(S.done()==both, "appended twice");
+    }
+    {
+        Sender S(byteOrder==EPICS_ENDIAN_BIG ? EPICS_ENDIAN_LITTLE : EPICS_ENDIAN_BIG);
+        try {
+            update.serialize(&S.buffer, &S, true);
+            testFail("byte order mismatch not detected");
+        } catch(std::logic_error& e) {
+            testPass("byte order mismatch: %s", e.what());
+        }
+    }
+}
+
+void testRoundTrip()
+{
+    testDiag("testRoundTrip");
+    PVStructurePtr value(makeValue());
+    BitSet changed, overrun;
+    changed.set(value->getSubFieldT<PVField>("alarm.message")->getFieldOffset());
+    changed.set(value->getSubFieldT<PVField>("value")->getFieldOffset());
+    overrun.set(value->getSubFieldT<PVField>("alarm.message")->getFieldOffset());
+
+    SerializedUpdate update(*value, changed, overrun, EPICS_ENDIAN_BIG);
+    Sender S(EPICS_ENDIAN_BIG);
+    update.serialize(&S.buffer, &S, true);
+    std::vector<char> sent(S.done());
+
+    PVStructurePtr copy(getPVDataCreate()->createPVStructure(value->getStructure()));
+    BitSet rchanged, roverrun;
+    ByteBuffer in(&sent[0], sent.size(), EPICS_ENDIAN_BIG);
+    struct Control : public DeserializableControl {
+        virtual void ensureData(std::size_t) {}
+        virtual void alignData(std::size_t) {}
+        virtual bool directDeserialize(ByteBuffer*, char*, std::size_t, std::size_t) { return false; }
+        virtual std::tr1::shared_ptr<const Field> cachedDeserialize(ByteBuffer* buffer)
+        { return getFieldCreate()->deserialize(buffer, this); }
+    } control;
+    rchanged.deserialize(&in, &control);
+    copy->deserialize(&in, &control, &rchanged);
+    roverrun.deserialize(&in, &control);
+
+    testOk1(in.getRemaining()==0);
+    testOk1(rchanged==changed);
+    testOk1(roverrun==overrun);
+    testOk1(copy->getSubFieldT<PVString>("alarm.message")->get()=="HIGH");
+    testOk1(copy->getSubFieldT<PVInt>("alarm.severity")->get()==0); // not changed
+    PVDoubleArray::const_svector arr(copy->getSubFieldT<PVDoubleArray>("value")->view());
+    testOk1(arr.size()==100 && arr[99]==49.5);
+}
+
+void testShared()
+{
+    testDiag("testShared");
+    PVStructurePtr value(makeValue());
+    BitSet changed, overrun;
+    changed.set(0);
+
+    SerializedUpdate update(*value, changed, overrun);
+    // the encoding is a snapshot
+    value->getSubFieldT<PVString>("alarm.message")->put("changed afterwards");
+    SerializedUpdate later(*value, changed, overrun);
+    testOk1(later.getChanged().size()>update.getChanged().size());
+
+    // all variants point into one block
+    testOk1(update.getChanged().dataPtr()==update.getOverrun(true).dataPtr());
+    testOk1(update.getOverrun(true).dataPtr()==update.getOverrun(false).dataPtr());
+    testOk1(update.getOverrun(false).size()==1);
+}
+
+} // namespace
+
+MAIN(testSerializedUpdate)
+{
+    testPlan(28);
+    testMatch(EPICS_ENDIAN_BIG, "big endian");
+    testMatch(EPICS_ENDIAN_LITTLE, "little endian");
+    testRoundTrip();
+    testShared();
+    return testDone();
+}
@@ -16,6 +16,7 @@
 /* copy */
 int testCreateRequest(void);
 int testPVCopy(void);
+int testMonitorFilter(void);
 
 /* misc */
 int testBaseException(void);
@@ -28,6 +29,10 @@ int testSerialization(void);
 int testSharedVector(void);
 int testThread(void);
 int testEvent(void);
+int testLockStats(void);
+int testArrayAllocator(void);
+int testMappedVector(void);
+int testArrayKernels(void);
 int testTimeStamp(void);
 int testTimer(void);
 int testTypeCast(void);
@@ -41,6 +46,8 @@ int testConvert(void);
 int testFieldBuilder(void);
 int testIntrospect(void);
 int testOperators(void);
+int testPVPrinter(void);
+int testSerializedUpdate(void);
 int testPVData(void);
 int testPVScalarArray(void);
 int testPVStructureArray(void);
@@ -59,6 +66,8 @@ void pvDataAllTests(void)
     runTest(testFieldBuilder);
     runTest(testIntrospect);
     runTest(testOperators);
+    runTest(testPVPrinter);
+    runTest(testSerializedUpdate);
     runTest(testPVData);
     runTest(testPVScalarArray);
     runTest(testPVStructureArray);
@@ -78,6 +87,10 @@ void pvDataAllTests(void)
     runTest(testSharedVector);
     runTest(testThread);
     runTest(testEvent);
+    runTest(testLockStats);
+    runTest(testArrayAllocator);
+    runTest(testMappedVector);
+    runTest(testArrayKernels);
     runTest(testTimeStamp);
     runTest(testTimer);
     runTest(testTypeCast);
@@ -85,6 +98,7 @@ void pvDataAllTests(void)
     /* copy */
     runTest(testCreateRequest);
     runTest(testPVCopy);
+    runTest(testMonitorFilter);
 
     /* property */
     runTest(testCreateRequest);